@@ -0,0 +1,27 @@
+#ifndef SF_BENCH_H
+#define SF_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/// Current time in nanoseconds.
+static inline uint64_t bench_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+/// Print a result row in nanoseconds per operation.
+static inline void bench_report(const char *group, const char *name, const size_t n, const uint64_t elapsed) {
+    printf("%-12s %-28s n=%-10zu %8.2f ns/op\n", group, name, n, (double)elapsed / (double)n);
+}
+/// Bijective scramble of an index, for unique but unordered keys.
+static inline uint64_t bench_key(const uint64_t i) {
+    uint64_t x = (i + 1) * 0x9E3779B97F4A7C15u;
+    x ^= x >> 32;
+    return x;
+}
+/// Prevent the compiler from discarding a computed value.
+static volatile uint64_t bench_sink;
+
+#endif // SF_BENCH_H
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#define MAP_NAME chained
+#define MAP_K uint64_t
+#define MAP_V uint64_t
+#include "sf/containers/map.h"
+
+#define MAP_NAME tree
+#define MAP_K uint64_t
+#define MAP_V uint64_t
+#include "sf/containers/btree.h"
+
+typedef struct {
+    uint64_t key, value;
+} pair;
+static bool pair_less(const pair a, const pair b) {
+    return a.key < b.key;
+}
+#define VEC_NAME pairs
+#define VEC_T pair
+#include "sf/containers/vec.h"
+#define VEC_NAME pairs
+#define VEC_T pair
+#define LESS_FN pair_less
+#include "sf/containers/vec_algo.h"
+
+/// A time window query, collecting the pairs with keys in [lo, hi).
+typedef struct {
+    uint64_t lo, hi;
+    pairs *out;
+} window;
+static void collect(void *ud, const uint64_t key, const uint64_t value) {
+    const window *w = ud;
+    if (key >= w->lo && key < w->hi)
+        pairs_push(w->out, (pair){ key, value });
+}
+
+int main(int argc, char **argv) {
+    const size_t max = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 1000000;
+    for (size_t n = 1000; n <= max; n *= 10) {
+        chained map = chained_new();
+        tree t = tree_new();
+        uint64_t start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            chained_set(&map, bench_key(i), i);
+        bench_report("chained", "insert", n, bench_now() - start);
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            tree_set(&t, bench_key(i), i);
+        bench_report("btree", "insert", n, bench_now() - start);
+
+        uint64_t sum = 0;
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            sum += chained_get(&map, bench_key(i)).ok;
+        bench_report("chained", "lookup hit", n, bench_now() - start);
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            sum += tree_get(&t, bench_key(i)).ok;
+        bench_report("btree", "lookup hit", n, bench_now() - start);
+
+        // Windows holding about 100 of the uniformly spread keys.
+        const uint64_t width = UINT64_MAX / n * 100;
+        const size_t queries = n < 10000 ? 1000 : 100;
+        pairs out = pairs_new();
+        start = bench_now();
+        for (size_t q = 0; q < queries; ++q) {
+            window w = { bench_key(q + n), 0, &out };
+            w.hi = w.lo + width < w.lo ? UINT64_MAX : w.lo + width;
+            out.count = 0;
+            chained_foreach(&map, collect, &w);
+            pairs_sort(&out);
+            sum += out.count;
+        }
+        bench_report("chained", "window, foreach + sort", queries, bench_now() - start);
+        start = bench_now();
+        for (size_t q = 0; q < queries; ++q) {
+            const uint64_t lo = bench_key(q + n), hi = lo + width < lo ? UINT64_MAX : lo + width;
+            out.count = 0;
+            for (tree_iter it = tree_lower_bound(&t, lo); tree_iter_valid(it) && tree_iter_key(it) < hi; tree_iter_next(&it))
+                pairs_push(&out, (pair){ tree_iter_key(it), tree_iter_value(it) });
+            sum += out.count;
+        }
+        bench_report("btree", "window, lower_bound + iter", queries, bench_now() - start);
+        pairs_free(&out);
+
+        uint64_t *keys = malloc(n * sizeof(uint64_t)), *values = malloc(n * sizeof(uint64_t));
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = values[i] = i * 2;
+        start = bench_now();
+        tree_build_sorted(&t, keys, values, n);
+        bench_report("btree", "build_sorted", n, bench_now() - start);
+        free(values);
+        free(keys);
+
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            tree_delete(&t, i * 2);
+        bench_report("btree", "delete", n, bench_now() - start);
+
+        bench_sink = sum;
+        tree_free(&t);
+        chained_free(&map);
+    }
+}
@@ -0,0 +1,25 @@
+#include <stdlib.h>
+#include "bench.h"
+#include "sf/containers/buffer.h"
+
+int main(int argc, char **argv) {
+    const size_t max = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 10000000;
+    for (size_t n = 1000; n <= max; n *= 10) {
+        sf_buffer buff = sf_buffer_grow();
+        uint64_t start = bench_now();
+        for (uint32_t i = 0; i < n; ++i)
+            sf_buffer_autoins(&buff, &i);
+        bench_report("buffer", "insert u32", n, bench_now() - start);
+        sf_buffer_clear(&buff);
+
+        buff = sf_buffer_grow();
+        start = bench_now();
+        for (uint32_t i = 0; i < n; ++i) {
+            sf_buffer_prep_ex prep = sf_buffer_prepare(&buff, sizeof(i));
+            memcpy(prep.ok, &i, sizeof(i));
+            sf_buffer_commit(&buff, sizeof(i));
+        }
+        bench_report("buffer", "prepare/commit u32", n, bench_now() - start);
+        sf_buffer_clear(&buff);
+    }
+}
@@ -0,0 +1,31 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "sf/math.h"
+
+int main(int argc, char **argv) {
+    const size_t total = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 64 * 1024 * 1024;
+    uint8_t *data = malloc(64 * 1024);
+    for (size_t i = 0; i < 64 * 1024; ++i)
+        data[i] = (uint8_t)bench_key(i);
+
+    static const size_t sizes[] = { 4, 8, 16, 32, 64, 256, 4096, 64 * 1024 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s) {
+        const size_t size = sizes[s], n = total / size;
+        char name[64];
+
+        uint64_t start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            bench_sink += sf_fnv1a(data + (i & 7), size - (i & 7 && size > 8));
+        snprintf(name, sizeof(name), "sf_fnv1a %zu bytes", size);
+        bench_report("hash", name, n, bench_now() - start);
+
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            bench_sink += sf_hash64(data + (i & 7), size - (i & 7 && size > 8));
+        snprintf(name, sizeof(name), "sf_hash64 %zu bytes", size);
+        bench_report("hash", name, n, bench_now() - start);
+    }
+
+    free(data);
+}
@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#define MAP_NAME chained
+#define MAP_K uint64_t
+#define MAP_V uint64_t
+#include "sf/containers/map.h"
+
+#define MAP_NAME chained_inc
+#define MAP_K uint64_t
+#define MAP_V uint64_t
+#define MAP_INCREMENTAL
+#include "sf/containers/map.h"
+
+#define MAP_NAME chained_pool
+#define MAP_K uint64_t
+#define MAP_V uint64_t
+#define MAP_POOL
+#include "sf/containers/map.h"
+
+#define MAP_NAME swiss
+#define MAP_K uint64_t
+#define MAP_V uint64_t
+#include "sf/containers/swiss_map.h"
+
+#define MAP_NAME flat
+#define MAP_K uint64_t
+#define MAP_V uint64_t
+#include "sf/containers/flat_map.h"
+
+#define BENCH_MAP(TYPE, n) do { \
+    TYPE map = TYPE##_new(); \
+    uint64_t start = bench_now(); \
+    for (size_t i = 0; i < (n); ++i) \
+        TYPE##_set(&map, bench_key(i), i); \
+    bench_report(#TYPE, "insert", (n), bench_now() - start); \
+    \
+    uint64_t sum = 0; \
+    start = bench_now(); \
+    for (size_t i = 0; i < (n); ++i) \
+        sum += TYPE##_get(&map, bench_key(i)).ok; \
+    bench_report(#TYPE, "lookup hit", (n), bench_now() - start); \
+    \
+    start = bench_now(); \
+    for (size_t i = 0; i < (n); ++i) \
+        sum += TYPE##_get(&map, bench_key(i + (n))).is_ok; \
+    bench_report(#TYPE, "lookup miss", (n), bench_now() - start); \
+    \
+    start = bench_now(); \
+    for (size_t i = 0; i < (n); ++i) \
+        TYPE##_delete(&map, bench_key(i)); \
+    bench_report(#TYPE, "delete", (n), bench_now() - start); \
+    \
+    bench_sink = sum; \
+    TYPE##_free(&map); \
+} while (0)
+
+/// Worst case latency of a single insert, which is where a full rehash lands.
+#define BENCH_SPIKE(TYPE, n) do { \
+    TYPE map = TYPE##_new(); \
+    uint64_t worst = 0; \
+    for (size_t i = 0; i < (n); ++i) { \
+        const uint64_t start = bench_now(); \
+        TYPE##_set(&map, bench_key(i), i); \
+        const uint64_t elapsed = bench_now() - start; \
+        worst = elapsed > worst ? elapsed : worst; \
+    } \
+    printf("%-12s %-28s n=%-10zu %8.2f us\n", #TYPE, "worst insert", (size_t)(n), (double)worst / 1000.0); \
+    TYPE##_free(&map); \
+} while (0)
+
+/// Insert/delete churn over a fixed working set, followed by freeing the whole map.
+#define BENCH_CHURN(TYPE, n) do { \
+    TYPE map = TYPE##_new(); \
+    for (size_t i = 0; i < (n); ++i) \
+        TYPE##_set(&map, bench_key(i), i); \
+    uint64_t start = bench_now(); \
+    for (size_t i = 0; i < (n); ++i) { \
+        TYPE##_delete(&map, bench_key(i)); \
+        TYPE##_set(&map, bench_key(i), i); \
+    } \
+    bench_report(#TYPE, "churn", (n), bench_now() - start); \
+    start = bench_now(); \
+    TYPE##_free(&map); \
+    bench_report(#TYPE, "free", (n), bench_now() - start); \
+} while (0)
+
+/// A table built in one go and then only read, searched in Eytzinger order and as a plain sorted array.
+static void bench_flat(const size_t n) {
+    uint64_t *keys = malloc(n * sizeof(uint64_t)), *values = malloc(n * sizeof(uint64_t));
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = bench_key(i);
+        values[i] = i;
+    }
+    flat map = flat_new();
+    uint64_t start = bench_now();
+    flat_build(&map, keys, values, n);
+    bench_report("flat", "build", n, bench_now() - start);
+
+    uint64_t sum = 0;
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        sum += flat_get(&map, bench_key(i)).ok;
+    bench_report("flat", "lookup hit", n, bench_now() - start);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        sum += flat_get(&map, bench_key(i + n)).is_ok;
+    bench_report("flat", "lookup miss", n, bench_now() - start);
+
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = bench_key(i);
+        size_t lo = 0, len = n;
+        while (len > 0) {
+            const size_t half = len / 2;
+            if (map.keys[lo + half] < key) {
+                lo += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        sum += map.values[lo];
+    }
+    bench_report("flat", "lookup hit, sorted array", n, bench_now() - start);
+
+    bench_sink = sum;
+    flat_free(&map);
+    free(values);
+    free(keys);
+}
+
+int main(int argc, char **argv) {
+    const size_t max = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 10000000;
+    for (size_t n = 1000; n <= max; n *= 10) {
+        BENCH_MAP(chained, n);
+        BENCH_MAP(swiss, n);
+        bench_flat(n);
+    }
+    for (size_t n = 1000; n <= max; n *= 10) {
+        BENCH_SPIKE(chained, n);
+        BENCH_SPIKE(chained_inc, n);
+    }
+    for (size_t n = 1000; n <= max; n *= 10) {
+        BENCH_CHURN(chained, n);
+        BENCH_CHURN(chained_pool, n);
+    }
+}
@@ -0,0 +1,160 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "sf/math.h"
+#include "sf/thread.h"
+
+enum { RAND_DRAWS = 1000000 };
+
+static void draw_rand(void *ud) {
+    (void)ud;
+    uint64_t sum = 0;
+    for (int i = 0; i < RAND_DRAWS; ++i)
+        sum += (uint64_t)rand() % 6;
+    bench_sink += sum;
+}
+
+static void draw_sf_randu(void *ud) {
+    (void)ud;
+    uint64_t sum = 0;
+    for (int i = 0; i < RAND_DRAWS; ++i)
+        sum += sf_randu(0, 5);
+    bench_sink += sum;
+}
+
+/// Run `func` on 4 threads at once.
+static void on_threads(void (*func)(void *ud)) {
+    sf_thread threads[4];
+    for (size_t i = 0; i < 4; ++i)
+        sf_thread_start(&threads[i], func, NULL);
+    for (size_t i = 0; i < 4; ++i)
+        sf_thread_join(threads[i]);
+}
+
+int main(int argc, char **argv) {
+    const size_t n = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 300000;
+    const size_t steps = 100;
+    sf_vec3 *positions = malloc(n * sizeof(sf_vec3)), *velocities = malloc(n * sizeof(sf_vec3));
+    float *lengths = malloc(n * sizeof(float));
+    for (size_t i = 0; i < n; ++i) {
+        positions[i] = (sf_vec3){(float)(bench_key(i) % 1000), (float)(i % 100), 0};
+        velocities[i] = (sf_vec3){1, (float)(bench_key(i) % 7), -0.5f};
+    }
+    sf_vec3_soa soa_positions = sf_vec3_soa_new(n), soa_velocities = sf_vec3_soa_new(n);
+    sf_vec3_soa_from_aos(&soa_positions, positions);
+    sf_vec3_soa_from_aos(&soa_velocities, velocities);
+
+    // A simulation step: advance positions by velocities, one call per element or one per array.
+    uint64_t start = bench_now();
+    for (size_t s = 0; s < steps; ++s)
+        for (size_t i = 0; i < n; ++i)
+            positions[i] = sf_vec3_add(positions[i], sf_vec3_multf(velocities[i], 0.016f));
+    bench_report("vec3 step", "aos sf_vec3_add", n * steps, bench_now() - start);
+    start = bench_now();
+    for (size_t s = 0; s < steps; ++s)
+        sf_vec3_soa_fma(&soa_positions, &soa_positions, &soa_velocities, 0.016f);
+    bench_report("vec3 step", "soa sf_vec3_soa_fma", n * steps, bench_now() - start);
+
+    start = bench_now();
+    for (size_t s = 0; s < steps; ++s)
+        for (size_t i = 0; i < n; ++i) {
+            const sf_vec3 v = velocities[i];
+            lengths[i] = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+        }
+    bench_sink += (uint64_t)lengths[n / 2];
+    bench_report("vec3 length", "aos loop", n * steps, bench_now() - start);
+    start = bench_now();
+    for (size_t s = 0; s < steps; ++s)
+        sf_vec3_soa_length(lengths, &soa_velocities);
+    bench_sink += (uint64_t)lengths[n / 2];
+    bench_report("vec3 length", "soa sf_vec3_soa_length", n * steps, bench_now() - start);
+
+    start = bench_now();
+    for (size_t s = 0; s < steps; ++s)
+        for (size_t i = 0; i < n; ++i) {
+            const sf_vec3 v = positions[i];
+            const float sum = v.x * v.x + v.y * v.y + v.z * v.z;
+            positions[i] = sf_vec3_multf(v, sum > 0 ? 1 / sqrtf(sum) : 0);
+        }
+    bench_report("vec3 normalize", "aos loop", n * steps, bench_now() - start);
+    start = bench_now();
+    for (size_t s = 0; s < steps; ++s)
+        sf_vec3_soa_normalize(&soa_positions, &soa_positions);
+    bench_report("vec3 normalize", "soa sf_vec3_soa_normalize", n * steps, bench_now() - start);
+    bench_sink += (uint64_t)(positions[n / 2].x + soa_positions.x[n / 2]);
+
+    // World matrices of a scene of 100k nodes, each a child of an earlier one.
+    const size_t nodes = 100000;
+    sf_transform *transforms = malloc(nodes * sizeof(sf_transform));
+    sf_transform_id *handles = malloc(nodes * sizeof(sf_transform_id));
+    sf_transform_graph graph = sf_transform_graph_new();
+    for (size_t i = 0; i < nodes; ++i) {
+        transforms[i] = SF_TRANSFORM_IDENTITY;
+        transforms[i].position = (sf_vec3){1, (float)(i % 10), 0};
+        transforms[i].rotation = (sf_vec3){0, 0.1f, 0};
+        const size_t parent = i < 16 ? SIZE_MAX : (size_t)(bench_key(i) % i) / 2 + i / 2;
+        transforms[i].parent = parent == SIZE_MAX ? NULL : &transforms[parent];
+        handles[i] = sf_transform_graph_add(&graph, parent == SIZE_MAX ? SF_TRANSFORM_NONE : handles[parent], transforms[i]);
+    }
+    start = bench_now();
+    for (size_t i = 0; i < nodes; ++i)
+        bench_sink += (uint64_t)sf_transform_world(&transforms[i]).m[12];
+    bench_report("transforms", "parent walk per node", nodes, bench_now() - start);
+    start = bench_now();
+    for (size_t s = 0; s < 10; ++s) {
+        for (size_t i = 0; i < 16; ++i)
+            sf_transform_graph_set_local(&graph, handles[i], transforms[i]);
+        sf_transform_graph_update(&graph);
+    }
+    bench_report("transforms", "graph update, roots changed", nodes * 10, bench_now() - start);
+    start = bench_now();
+    for (size_t s = 0; s < 10; ++s) {
+        for (size_t i = nodes / 2; i < nodes; i += 100)
+            sf_transform_graph_set_local(&graph, handles[i], transforms[i]);
+        sf_transform_graph_update(&graph);
+    }
+    bench_report("transforms", "graph update, 1% changed", nodes * 10, bench_now() - start);
+    sf_transform_graph_free(&graph);
+    free(handles);
+    free(transforms);
+
+    // Dice rolls, and filling a megabyte of noise.
+    start = bench_now();
+    draw_rand(NULL);
+    bench_report("rand", "rand() % 6", RAND_DRAWS, bench_now() - start);
+    start = bench_now();
+    draw_sf_randu(NULL);
+    bench_report("rand", "sf_randu(0, 5)", RAND_DRAWS, bench_now() - start);
+    start = bench_now();
+    on_threads(draw_rand);
+    bench_report("rand", "rand() % 6, 4 threads", RAND_DRAWS, bench_now() - start);
+    start = bench_now();
+    on_threads(draw_sf_randu);
+    bench_report("rand", "sf_randu(0, 5), 4 threads", RAND_DRAWS, bench_now() - start);
+    const size_t noise_size = 1024 * 1024;
+    uint8_t *noise = malloc(noise_size);
+    start = bench_now();
+    for (size_t i = 0; i < noise_size; ++i)
+        noise[i] = (uint8_t)rand();
+    bench_report("rand bytes", "rand() per byte", noise_size, bench_now() - start);
+    sf_rng rng = sf_rng_new(1);
+    start = bench_now();
+    for (size_t i = 0; i < noise_size; i += 8) {
+        const uint64_t bits = sf_rng_next(&rng);
+        memcpy(noise + i, &bits, 8);
+    }
+    bench_report("rand bytes", "sf_rng_next per 8 bytes", noise_size, bench_now() - start);
+    start = bench_now();
+    for (int i = 0; i < 10; ++i)
+        sf_rand(noise, noise_size);
+    bench_report("rand bytes", "sf_rand", noise_size * 10, bench_now() - start);
+    bench_sink += noise[noise_size / 2];
+    free(noise);
+
+    sf_vec3_soa_free(&soa_positions);
+    sf_vec3_soa_free(&soa_velocities);
+    free(lengths);
+    free(velocities);
+    free(positions);
+}
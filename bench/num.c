@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "sf/num.h"
+
+int main(int argc, char **argv) {
+    const size_t n = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 1000000;
+    uint64_t *ints = malloc(n * sizeof(uint64_t));
+    double *doubles = malloc(n * sizeof(double));
+    char (*texts)[SF_NUM_BUFFER_SIZE] = malloc(n * SF_NUM_BUFFER_SIZE);
+    // Integers of every length, and doubles from both short decimals and full 17 digit values.
+    for (size_t i = 0; i < n; ++i) {
+        ints[i] = bench_key(i) >> (bench_key(i) % 64);
+        doubles[i] = i % 2 ? (double)(bench_key(i) % 100000) / 100 : (double)bench_key(i) / (double)bench_key(i + n);
+    }
+    char buffer[SF_NUM_BUFFER_SIZE];
+
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += (uint64_t)snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)ints[i]);
+    bench_report("format u64", "snprintf %llu", n, bench_now() - start);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += sf_u64_to_str(ints[i], buffer).len;
+    bench_report("format u64", "sf_u64_to_str", n, bench_now() - start);
+
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += (uint64_t)snprintf(buffer, sizeof(buffer), "%.17g", doubles[i]);
+    bench_report("format f64", "snprintf %.17g", n, bench_now() - start);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += sf_f64_to_str(doubles[i], buffer).len;
+    bench_report("format f64", "sf_f64_to_str (shortest)", n, bench_now() - start);
+
+    for (size_t i = 0; i < n; ++i)
+        sf_u64_to_str(ints[i], texts[i]);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += strtoull(texts[i], NULL, 10);
+    bench_report("parse u64", "strtoull", n, bench_now() - start);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += sf_str_to_u64(sf_ref(texts[i])).ok;
+    bench_report("parse u64", "sf_str_to_u64", n, bench_now() - start);
+
+    for (size_t i = 0; i < n; ++i)
+        sf_f64_to_str(doubles[i], texts[i]);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += (uint64_t)strtod(texts[i], NULL);
+    bench_report("parse f64", "strtod", n, bench_now() - start);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        bench_sink += (uint64_t)sf_str_to_f64(sf_ref(texts[i])).ok;
+    bench_report("parse f64", "sf_str_to_f64", n, bench_now() - start);
+
+    // Serializing into one growing buffer, the way a writer would.
+    sf_buffer out = sf_buffer_grow();
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        const int len = snprintf(buffer, sizeof(buffer), "%.17g", doubles[i]);
+        sf_buffer_insert(&out, buffer, (size_t)len);
+    }
+    bench_report("serialize", "snprintf + sf_buffer_insert", n, bench_now() - start);
+    sf_buffer_clear(&out);
+    out = sf_buffer_grow();
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i)
+        sf_buffer_insert_f64(&out, doubles[i]);
+    bench_report("serialize", "sf_buffer_insert_f64", n, bench_now() - start);
+    sf_buffer_clear(&out);
+
+    free(texts);
+    free(doubles);
+    free(ints);
+}
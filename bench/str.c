@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include "bench.h"
+#include "sf/str.h"
+#include "sf/strbuf.h"
+
+#define MAP_NAME map_si
+#define MAP_K sf_str
+#define MAP_V size_t
+#define HASH_FN sf_str_hash
+#define EQUAL_FN sf_str_eq
+#include "sf/containers/map.h"
+
+/// Heap allocator that counts calls, to see how many allocations a workload makes.
+static size_t allocations;
+static void *count_alloc(void *ud, const size_t size) {
+    (void)ud;
+    ++allocations;
+    return malloc(size);
+}
+static void *count_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    (void)ud, (void)old_size;
+    ++allocations;
+    return realloc(ptr, size);
+}
+static void count_free(void *ud, void *ptr, const size_t size) {
+    (void)ud, (void)size;
+    free(ptr);
+}
+static const sf_allocator counting = { count_alloc, count_realloc, count_free, NULL };
+
+static void report_allocs(const char *name, const size_t n) {
+    printf("%-12s %-28s n=%-10zu %8.2f allocs/op\n", "str", name, n, (double)allocations / (double)n);
+    allocations = 0;
+}
+
+int main(int argc, char **argv) {
+    const size_t max = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 1000000;
+#ifdef SF_STR_SSO
+    printf("sf_str: small string optimization on, %zu bytes\n", sizeof(sf_str));
+#else
+    printf("sf_str: small string optimization off, %zu bytes\n", sizeof(sf_str));
+#endif
+    for (size_t n = 1000; n <= max; n *= 10) {
+        // Short identifiers as map keys: format, insert, look up, free.
+        sf_str *keys = malloc(n * sizeof(sf_str));
+        map_si map = map_si_new();
+        uint64_t start = bench_now();
+        for (size_t i = 0; i < n; ++i) {
+            keys[i] = sf_str_fmt_in(&counting, "k%zx", (size_t)bench_key(i) & 0xFFFFFF);
+            map_si_set(&map, keys[i], i);
+        }
+        for (size_t i = 0; i < n; ++i)
+            bench_sink += map_si_get(&map, keys[i]).ok;
+        for (size_t i = 0; i < n; ++i)
+            sf_str_free_in(&counting, keys[i]);
+        bench_report("str", "map keys fmt/set/get/free", n, bench_now() - start);
+        report_allocs("map keys", n);
+        map_si_free(&map);
+        free(keys);
+
+        // Long route keys looked up in several tables, rehashed by every lookup or hashed once up front.
+        enum { TABLES = 6 };
+        sf_str *routes = malloc(n * sizeof(sf_str));
+        map_si tables[TABLES];
+        for (size_t t = 0; t < TABLES; ++t)
+            tables[t] = map_si_new();
+        for (size_t i = 0; i < n; ++i) {
+            routes[i] = sf_str_fmt("/api/v2/organizations/%zx/projects/%zu", (size_t)bench_key(i), i);
+            for (size_t t = 0; t < TABLES; ++t)
+                map_si_set(&tables[t], routes[i], i + t);
+        }
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i)
+            for (size_t t = 0; t < TABLES; ++t)
+                bench_sink += map_si_get(&tables[t], routes[i]).ok;
+        bench_report("str", "route x6 lookups", n, bench_now() - start);
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i) {
+            sf_str_hash_cached(&routes[i]);
+            for (size_t t = 0; t < TABLES; ++t)
+                bench_sink += map_si_get(&tables[t], routes[i]).ok;
+        }
+        bench_report("str", "route x6 lookups cached hash", n, bench_now() - start);
+        for (size_t t = 0; t < TABLES; ++t)
+            map_si_free(&tables[t]);
+        for (size_t i = 0; i < n; ++i)
+            sf_str_free(routes[i]);
+        free(routes);
+
+        // Log lines, short enough to fit inline and too long to.
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i) {
+            sf_str line = sf_str_fmt_in(&counting, "[W] %d", (int)(i & 0xFFFF));
+            bench_sink += line.len;
+            sf_str_free_in(&counting, line);
+        }
+        bench_report("str", "log fmt short", n, bench_now() - start);
+        report_allocs("log fmt short", n);
+
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i) {
+            sf_str line = sf_str_fmt_in(&counting, "[WARN] frame %zu took %d us", i, (int)(i & 0xFFFF));
+            bench_sink += line.len;
+            sf_str_free_in(&counting, line);
+        }
+        bench_report("str", "log fmt long", n, bench_now() - start);
+        report_allocs("log fmt long", n);
+
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i) {
+            sf_str joined = sf_str_join_in(&counting, sf_lit("obj."), sf_lit("pos"));
+            sf_str copy = sf_str_dup_in(&counting, joined);
+            bench_sink += copy.len;
+            sf_str_free_in(&counting, joined);
+            sf_str_free_in(&counting, copy);
+        }
+        bench_report("str", "join + dup short", n, bench_now() - start);
+        report_allocs("join + dup short", n);
+
+        // A 10 KB line built from 300 fragments.
+        const size_t lines = n / 1000;
+        start = bench_now();
+        for (size_t i = 0; i < lines; ++i) {
+            sf_str line = sf_str_dup_in(&counting, sf_lit(""));
+            for (int f = 0; f < 300; ++f)
+                sf_str_append_in(&counting, &line, sf_lit("fragment-of-a-line-32-bytes-long"));
+            bench_sink += line.len;
+            sf_str_free_in(&counting, line);
+        }
+        bench_report("str", "300 fragments sf_str_append", lines, bench_now() - start);
+        report_allocs("300 fragments sf_str_append", lines);
+
+        start = bench_now();
+        for (size_t i = 0; i < lines; ++i) {
+            sf_strbuf sb = sf_strbuf_new_in(&counting);
+            for (int f = 0; f < 300; ++f)
+                sf_strbuf_append(&sb, sf_lit("fragment-of-a-line-32-bytes-long"));
+            sf_str line = sf_strbuf_finish(&sb);
+            bench_sink += line.len;
+            sf_str_free_in(&counting, line);
+        }
+        bench_report("str", "300 fragments sf_strbuf", lines, bench_now() - start);
+        report_allocs("300 fragments sf_strbuf", lines);
+
+        start = bench_now();
+        for (size_t i = 0; i < n; ++i) {
+            sf_strbuf sb = sf_strbuf_new_in(&counting);
+            sf_strbuf_append(&sb, sf_lit("[WARN] frame "));
+            sf_strbuf_append_uint(&sb, i);
+            sf_strbuf_append(&sb, sf_lit(" took "));
+            sf_strbuf_append_int(&sb, (int)(i & 0xFFFF));
+            sf_strbuf_append(&sb, sf_lit(" us"));
+            sf_str line = sf_strbuf_finish(&sb);
+            bench_sink += line.len;
+            sf_str_free_in(&counting, line);
+        }
+        bench_report("str", "log typed appends long", n, bench_now() - start);
+        report_allocs("log typed appends long", n);
+    }
+}
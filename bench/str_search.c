@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "sf/str.h"
+
+#define TEXT_SIZE (1024 * 1024)
+#define ROUNDS 64
+
+/// Count occurrences of a byte the obvious way, as a baseline for sf_str_count_char.
+static size_t count_char_loop(const char *s, const size_t n, const char c) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i)
+        count += s[i] == c;
+    return count;
+}
+
+int main(int argc, char **argv) {
+    const size_t rounds = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : ROUNDS;
+
+    // Lowercase words with a newline every ~80 bytes, and one marker at the very end.
+    char *text = malloc(TEXT_SIZE + 1);
+    for (size_t i = 0; i < TEXT_SIZE; ++i) {
+        const uint64_t r = bench_key(i) % 80;
+        text[i] = r == 0 ? '\n' : r < 12 ? ' ' : (char)('a' + r % 26);
+    }
+    memcpy(text + TEXT_SIZE - 8, "NEEDLE!", 7);
+    text[TEXT_SIZE - 1] = '\n';
+    text[TEXT_SIZE] = '\0';
+    const sf_str s = { .c_str = text, .len = TEXT_SIZE, .flags = SF_STR_CONST };
+    const size_t bytes = rounds * TEXT_SIZE;
+
+    uint64_t start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += (uint64_t)((const char *)memchr(text, '!', TEXT_SIZE) - text);
+    bench_report("find char", "memchr", bytes, bench_now() - start);
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += sf_str_find_char(s, '!');
+    bench_report("find char", "sf_str_find_char", bytes, bench_now() - start);
+
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += (uint64_t)(strstr(text, "NEEDLE") - text);
+    bench_report("find", "strstr", bytes, bench_now() - start);
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += sf_str_find(s, sf_lit("NEEDLE"));
+    bench_report("find", "sf_str_find", bytes, bench_now() - start);
+
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += strcspn(text, "!?#");
+    bench_report("find any", "strcspn", bytes, bench_now() - start);
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += sf_str_find_any(s, sf_lit("!?#"));
+    bench_report("find any", "sf_str_find_any", bytes, bench_now() - start);
+
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += count_char_loop(text, TEXT_SIZE, '\n');
+    bench_report("count", "byte loop", bytes, bench_now() - start);
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += sf_str_count_char(s, '\n');
+    bench_report("count", "sf_str_count_char", bytes, bench_now() - start);
+
+    char *copy = malloc(TEXT_SIZE);
+    memcpy(copy, text, TEXT_SIZE);
+    const sf_str t = { .c_str = copy, .len = TEXT_SIZE, .flags = SF_STR_CONST };
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += (uint64_t)memcmp(text, copy, TEXT_SIZE);
+    bench_report("compare", "memcmp", bytes, bench_now() - start);
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r)
+        bench_sink += sf_str_eq(s, t);
+    bench_report("compare", "sf_str_eq", bytes, bench_now() - start);
+
+    // Splitting a file into lines, as views.
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r) {
+        sf_str rest = s, line;
+        while (sf_str_split_next(&rest, sf_lit("\n"), &line))
+            bench_sink += line.len;
+    }
+    bench_report("split", "sf_str_split_next lines", bytes, bench_now() - start);
+    start = bench_now();
+    for (size_t r = 0; r < rounds; ++r) {
+        sf_str rest = s, word;
+        while (sf_str_tokenize_next(&rest, sf_lit(" \n"), &word))
+            bench_sink += word.len;
+    }
+    bench_report("split", "sf_str_tokenize_next words", bytes, bench_now() - start);
+
+    free(copy);
+    free(text);
+}
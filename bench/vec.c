@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#define VEC_NAME vec_int
+#define VEC_T int
+#include "sf/containers/vec.h"
+
+#define VEC_NAME tag_vec
+#define VEC_T int
+#define VEC_INLINE 8
+#include "sf/containers/vec.h"
+
+/// Heap allocator that counts reallocations, to see how often a workload moves the vec.
+static size_t reallocations;
+static void *count_alloc(void *ud, const size_t size) {
+    (void)ud;
+    return malloc(size);
+}
+static void *count_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    (void)ud, (void)old_size;
+    ++reallocations;
+    return realloc(ptr, size);
+}
+static void count_free(void *ud, void *ptr, const size_t size) {
+    (void)ud, (void)size;
+    free(ptr);
+}
+static const sf_allocator counting = { count_alloc, count_realloc, count_free, NULL };
+
+static void report_reallocs(const char *name, const size_t n) {
+    printf("%-12s %-28s n=%-10zu %8.4f reallocs/op\n", "vec", name, n, (double)reallocations / (double)n);
+    reallocations = 0;
+}
+
+int main(int argc, char **argv) {
+    const size_t n = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 1000000;
+
+    // A queue depth hovering around a power of two: one element too many, then one fewer.
+    vec_int vec = vec_int_new_in(&counting);
+    for (int i = 0; i < 1025; ++i)
+        vec_int_push(&vec, i);
+    reallocations = 0;
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        vec_int_delete(&vec, vec.count - 1);
+        vec_int_push(&vec, (int)i);
+    }
+    bench_report("vec", "delete + push at 1025", n, bench_now() - start);
+    report_reallocs("delete + push at 1025", n);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        vec_int_push(&vec, (int)i);
+        bench_sink += (uint64_t)vec_int_pop(&vec);
+    }
+    bench_report("vec", "push + pop at 1025", n, bench_now() - start);
+    report_reallocs("push + pop at 1025", n);
+    vec_int_free(&vec);
+
+    // Building a vec from chunks of 64.
+    int chunk[64];
+    for (int i = 0; i < 64; ++i)
+        chunk[i] = i;
+    vec = vec_int_new();
+    start = bench_now();
+    for (size_t i = 0; i < n / 64; ++i)
+        for (size_t j = 0; j < 64; ++j)
+            vec_int_push(&vec, chunk[j]);
+    bench_report("vec", "push x64", n / 64 * 64, bench_now() - start);
+    vec_int_free(&vec);
+    vec = vec_int_new();
+    start = bench_now();
+    for (size_t i = 0; i < n / 64; ++i)
+        vec_int_append(&vec, chunk, 64);
+    bench_report("vec", "append 64", n / 64 * 64, bench_now() - start);
+    bench_sink += (uint64_t)vec.count;
+    vec_int_free(&vec);
+
+    // Short lists built and dropped in a loop, like the tags on each entity: most fit inline.
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        vec = vec_int_new();
+        for (size_t j = 0; j < i % 10; ++j)
+            vec_int_push(&vec, (int)j);
+        bench_sink += (uint64_t)vec.count;
+        vec_int_free(&vec);
+    }
+    bench_report("vec", "tags 0-9, heap", n, bench_now() - start);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        tag_vec tags = tag_vec_new();
+        for (size_t j = 0; j < i % 10; ++j)
+            tag_vec_push(&tags, (int)j);
+        bench_sink += (uint64_t)tags.count;
+        tag_vec_free(&tags);
+    }
+    bench_report("vec", "tags 0-9, 8 inline", n, bench_now() - start);
+}
@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#define VEC_NAME vec_int
+#define VEC_T int
+#include "sf/containers/vec.h"
+#define VEC_NAME vec_int
+#define VEC_T int
+#define VEC_RADIX_KEY(x) sf_radix_i32(x)
+#include "sf/containers/vec_algo.h"
+
+static int compare_ints(const void *a, const void *b) {
+    const int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    // Sizes from 1K up to the largest, 10M by default as 100M needs 800MB.
+    const size_t largest = argc > 1 ? (size_t)strtoull(argv[1], NULL, 10) : 10000000;
+    int *input = malloc(largest * sizeof(int));
+    for (size_t i = 0; i < largest; ++i)
+        input[i] = (int)bench_key(i);
+    vec_int vec = vec_int_new();
+    char name[64];
+
+    for (size_t n = 1000; n <= largest; n *= 10) {
+        // Smaller sizes repeat so every row sorts about the same amount of elements.
+        const size_t rounds = largest / n < 1000 ? largest / n : 1000;
+        vec_int_free(&vec);
+        vec_int_append(&vec, input, (uint64_t)n);
+
+        uint64_t elapsed = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            memcpy(vec.data, input, n * sizeof(int));
+            const uint64_t start = bench_now();
+            qsort(vec.data, n, sizeof(int), compare_ints);
+            elapsed += bench_now() - start;
+        }
+        snprintf(name, sizeof(name), "qsort %zu", n);
+        bench_report("sort", name, n * rounds, elapsed);
+
+        elapsed = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            memcpy(vec.data, input, n * sizeof(int));
+            const uint64_t start = bench_now();
+            vec_int_sort(&vec);
+            elapsed += bench_now() - start;
+        }
+        snprintf(name, sizeof(name), "introsort %zu", n);
+        bench_report("sort", name, n * rounds, elapsed);
+
+        elapsed = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            memcpy(vec.data, input, n * sizeof(int));
+            const uint64_t start = bench_now();
+            vec_int_radix_sort(&vec);
+            elapsed += bench_now() - start;
+        }
+        snprintf(name, sizeof(name), "radix %zu", n);
+        bench_report("sort", name, n * rounds, elapsed);
+
+        elapsed = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            memcpy(vec.data, input, n * sizeof(int));
+            const uint64_t start = bench_now();
+            vec_int_sort_parallel(&vec, 0);
+            elapsed += bench_now() - start;
+        }
+        snprintf(name, sizeof(name), "parallel x%zu %zu", sf_cpu_count(), n);
+        bench_report("sort", name, n * rounds, elapsed);
+
+        // Searching the sorted vec for keys in a scattered order.
+        const size_t lookups = 1000000;
+        uint64_t start = bench_now();
+        for (size_t i = 0; i < lookups; ++i) {
+            const int key = input[bench_key(i) % n];
+            bench_sink += (uint64_t)((int *)bsearch(&key, vec.data, n, sizeof(int), compare_ints) - vec.data);
+        }
+        snprintf(name, sizeof(name), "bsearch %zu", n);
+        bench_report("search", name, lookups, bench_now() - start);
+        start = bench_now();
+        for (size_t i = 0; i < lookups; ++i)
+            bench_sink += vec_int_lower_bound(&vec, input[bench_key(i) % n]);
+        snprintf(name, sizeof(name), "lower_bound %zu", n);
+        bench_report("search", name, lookups, bench_now() - start);
+    }
+
+    vec_int_free(&vec);
+    free(input);
+}
@@ -1,24 +1,40 @@
-#ifndef SS_SANITIZERS
-#define SS_SANITIZERS
-
-#include <stddef.h>
-
-#ifdef __has_feature
-  #if __has_feature(address_sanitizer)
-    #include <sanitizer/lsan_interface.h>
-  #else
-    // Define no-op versions if LSan isn’t enabled
-    static inline void __lsan_disable(void) {}
-    static inline void __lsan_enable(void) {}
-    static inline void __lsan_register_root_region(const void *start, size_t size) {(void)start;(void)size;}
-    static inline void __lsan_unregister_root_region(const void *start, size_t size) {(void)start;(void)size;}
-  #endif
-#else
-  static inline void __lsan_disable(void) {}
-  static inline void __lsan_enable(void) {}
-  static inline void __lsan_register_root_region(const void *start, size_t size) {(void)start;(void)size;}
-  static inline void __lsan_unregister_root_region(const void *start, size_t size) {(void)start;(void)size;}
-#endif
-
-
-#endif
+#ifndef SS_SANITIZERS
+#define SS_SANITIZERS
+
+#include <stddef.h>
+
+#ifdef __has_feature
+  #if __has_feature(address_sanitizer)
+    #include <sanitizer/lsan_interface.h>
+  #else
+    // Define no-op versions if LSan isn’t enabled
+    static inline void __lsan_disable(void) {}
+    static inline void __lsan_enable(void) {}
+    static inline void __lsan_register_root_region(const void *start, size_t size) {(void)start;(void)size;}
+    static inline void __lsan_unregister_root_region(const void *start, size_t size) {(void)start;(void)size;}
+  #endif
+#else
+  static inline void __lsan_disable(void) {}
+  static inline void __lsan_enable(void) {}
+  static inline void __lsan_register_root_region(const void *start, size_t size) {(void)start;(void)size;}
+  static inline void __lsan_unregister_root_region(const void *start, size_t size) {(void)start;(void)size;}
+#endif
+
+// ASan poisoning hooks for allocators that hand out pieces of larger blocks.
+#if defined(__SANITIZE_ADDRESS__)
+  #define SF_ASAN
+#elif defined(__has_feature)
+  #if __has_feature(address_sanitizer)
+    #define SF_ASAN
+  #endif
+#endif
+
+#ifdef SF_ASAN
+  #include <sanitizer/asan_interface.h>
+#else
+  static inline void __asan_poison_memory_region(void const volatile *addr, size_t size) {(void)addr;(void)size;}
+  static inline void __asan_unpoison_memory_region(void const volatile *addr, size_t size) {(void)addr;(void)size;}
+#endif
+
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SF_ALLOC_H
+#define SF_ALLOC_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// A pluggable allocator that containers and strings can be created with.
+/// Sizes are passed back on realloc/free so sized allocators (arenas, pools) need no headers.
+/// A NULL `sf_allocator *` always means the C heap.
+typedef struct sf_allocator {
+    void *(*alloc)(void *ud, size_t size);
+    void *(*realloc)(void *ud, void *ptr, size_t old_size, size_t size);
+    void (*free)(void *ud, void *ptr, size_t size);
+    void *ud; /// User data passed to each callback.
+} sf_allocator;
+
+/// Allocate `size` bytes from an allocator.
+static inline void *sf_alloc(const sf_allocator *alloc, const size_t size) {
+    return alloc ? alloc->alloc(alloc->ud, size) : malloc(size);
+}
+/// Allocate `count * size` zeroed bytes from an allocator.
+static inline void *sf_calloc(const sf_allocator *alloc, const size_t count, const size_t size) {
+    if (!alloc)
+        return calloc(count, size);
+    void *ptr = alloc->alloc(alloc->ud, count * size);
+    if (ptr)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+/// Resize an allocation of `old_size` bytes to `size` bytes.
+static inline void *sf_realloc(const sf_allocator *alloc, void *ptr, const size_t old_size, const size_t size) {
+    return alloc ? alloc->realloc(alloc->ud, ptr, old_size, size) : realloc(ptr, size);
+}
+/// Return an allocation of `size` bytes to its allocator.
+static inline void sf_free(const sf_allocator *alloc, void *ptr, const size_t size) {
+    if (alloc) alloc->free(alloc->ud, ptr, size);
+    else free(ptr);
+}
+
+#endif // SF_ALLOC_H
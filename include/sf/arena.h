@@ -0,0 +1,70 @@
+#ifndef SF_ARENA_H
+#define SF_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "sf/alloc.h"
+#include "sf/str.h"
+
+/// Default size of each chunk an arena allocates from its backing allocator.
+#define SF_ARENA_CHUNK_SIZE (64 * 1024)
+
+/// A block of memory allocations are bumped out of.
+typedef struct sf_arena_chunk {
+    struct sf_arena_chunk *prev;
+    size_t size; /// Usable bytes following the header.
+    size_t used;
+} sf_arena_chunk;
+
+/// A region allocator. Allocations are bumped out of chunks and only released all at once,
+/// either by rolling back to a mark or by resetting/freeing the arena.
+typedef struct {
+    sf_arena_chunk *head; /// The chunk currently allocated from.
+    sf_arena_chunk *spare; /// A released chunk kept around to avoid thrashing at chunk boundaries.
+    void *last; /// The most recent allocation, which can still be grown or popped in place.
+    size_t chunk_size;
+    const sf_allocator *backing; /// Where chunks come from, NULL for the C heap.
+} sf_arena;
+
+/// A saved arena position to roll back to.
+typedef struct {
+    sf_arena_chunk *chunk;
+    size_t used;
+} sf_arena_mark;
+
+/// Create an arena that allocates chunks of `chunk_size` bytes, 0 for the default.
+/// Note that chunks are lazily allocated.
+EXPORT sf_arena sf_arena_new(size_t chunk_size);
+/// Create an arena whose chunks are allocated from `backing`.
+EXPORT sf_arena sf_arena_new_in(const sf_allocator *backing, size_t chunk_size);
+/// Release every chunk owned by an arena.
+EXPORT void sf_arena_free(sf_arena *arena);
+/// Release every allocation, keeping the first chunk for reuse.
+EXPORT void sf_arena_reset(sf_arena *arena);
+
+/// Allocate `size` bytes aligned for any type. Returns NULL when out of memory.
+EXPORT void *sf_arena_alloc(sf_arena *arena, size_t size);
+/// Allocate `size` bytes aligned to `align`, which must be a power of two.
+EXPORT void *sf_arena_alloc_aligned(sf_arena *arena, size_t size, size_t align);
+/// Allocate enough space for `count` values of `type`.
+#define sf_arena_new_array(arena, type, count) ((type *)sf_arena_alloc_aligned(arena, sizeof(type) * (count), _Alignof(type)))
+
+/// Save the current position of an arena.
+EXPORT sf_arena_mark sf_arena_save(const sf_arena *arena);
+/// Release everything allocated since `mark` was saved.
+EXPORT void sf_arena_restore(sf_arena *arena, sf_arena_mark mark);
+
+/// Wrap an arena as an sf_allocator for containers and strings.
+/// Frees are no-ops unless they pop the most recent allocation.
+EXPORT sf_allocator sf_arena_allocator(sf_arena *arena);
+
+/// Create a new string with format specifiers inside an arena.
+/// Arena strings are released with the arena, so sf_str_free is a no-op on them.
+EXPORT sf_str sf_str_fmt_arena(sf_arena *arena, const char *format, ...);
+/// Join two strings together inside an arena.
+EXPORT sf_str sf_str_join_arena(sf_arena *arena, const sf_str str1, const sf_str str2);
+/// Duplicate a string inside an arena.
+EXPORT sf_str sf_str_dup_arena(sf_arena *arena, const sf_str string);
+
+#endif // SF_ARENA_H
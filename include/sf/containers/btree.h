@@ -0,0 +1,588 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "sf/alloc.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+/***********************************
+ * An ordered map, as a B+ tree whose nodes span a few cache lines.
+ * Pairs live in the leaves, which are linked in key order for iteration and range scans.
+ * You should #define MAP_K & MAP_V as key/value types,
+ * #define MAP_NAME as the desired type name for the map.
+ * Optionally, #define:
+ * - int (*CMP_FN)(const MAP_K, const MAP_K), negative, zero or positive like memcmp, defaulting to `<`
+ * - void (*CLEANUP_FN)(MAP_NAME *)
+ * - void (*KCLEANUP)(MAP_K)
+ * - size_t BTREE_NODE_BYTES, the target size of a node, 256 by default
+***********************************/
+
+#ifndef MAP_NAME
+#error Undefined typename MAP_NAME
+#define MAP_NAME sf_btree
+#endif
+#ifndef MAP_K
+#error Undefined type MAP_K
+#define MAP_K void *
+#endif
+#ifndef MAP_V
+#error Undefined type MAP_V
+#define MAP_V void *
+#endif
+
+#define EXPECTED_NAME EXPAND_CAT(MAP_NAME, _ex)
+#define EXPECTED_O MAP_V
+#include "sf/containers/expected.h"
+
+#define CAT(a, b) a##b
+#define EXPAND_CAT(a, b) CAT(a, b)
+#define FUNC(name) EXPAND_CAT(MAP_NAME, _##name)
+
+#ifndef BTREE_NODE_BYTES
+#define BTREE_NODE_BYTES 256
+#endif
+/// Pairs per leaf and keys per inner node that fit the node size, at least 4.
+/// Node sizes too small for the header fit nothing rather than wrapping around.
+#define LEAF_FIT (BTREE_NODE_BYTES > 3 * sizeof(void *) \
+    ? (BTREE_NODE_BYTES - 3 * sizeof(void *)) / (sizeof(MAP_K) + sizeof(MAP_V)) : 0)
+#define LEAF_CAP (LEAF_FIT > 4 ? LEAF_FIT : 4)
+#define INNER_FIT (BTREE_NODE_BYTES > 2 * sizeof(void *) \
+    ? (BTREE_NODE_BYTES - 2 * sizeof(void *)) / (sizeof(MAP_K) + sizeof(void *)) : 0)
+#define INNER_CAP (INNER_FIT > 4 ? INNER_FIT : 4)
+
+#ifndef CMP_FN
+/// Default ordering of keys.
+static inline int FUNC(cmp)(const MAP_K a, const MAP_K b) {
+    return (a > b) - (a < b);
+}
+#define CMP_FN FUNC(cmp)
+#endif
+
+/// A node holding pairs, linked to its neighbours in key order.
+#define LEAF EXPAND_CAT(MAP_NAME, _leaf)
+typedef struct LEAF {
+    size_t count;
+    struct LEAF *prev, *next;
+    MAP_K keys[LEAF_CAP];
+    MAP_V values[LEAF_CAP];
+} LEAF;
+/// A node routing lookups, where child `i` holds the keys from keys[i - 1] up to but excluding keys[i].
+#define INNER EXPAND_CAT(MAP_NAME, _inner)
+typedef struct INNER {
+    size_t count; /// The amount of keys, one less than the amount of children.
+    MAP_K keys[INNER_CAP];
+    void *children[INNER_CAP + 1];
+} INNER;
+
+/// An ordered map that uses user defined types for keys/values.
+typedef struct MAP_NAME {
+    size_t count; /// The amount of key/value pairs held within the map.
+    size_t height; /// The amount of inner levels above the leaves.
+    void *root; /// A leaf when `height` is 0, an inner node otherwise, NULL when empty.
+    LEAF *first, *last; /// The leaves with the lowest and highest keys.
+    const sf_allocator *alloc; /// Where nodes are allocated from, NULL for the C heap.
+} MAP_NAME;
+
+/// A position in a map, which stays valid until the map changes.
+typedef struct {
+    const LEAF *leaf; /// NULL once past either end.
+    size_t index;
+} FUNC(iter);
+
+/// Creates the map with the specified type and name, allocating from `alloc`.
+static inline MAP_NAME FUNC(new_in)(const sf_allocator *alloc) {
+    return (MAP_NAME) {
+        .count = 0,
+        .height = 0,
+        .root = NULL,
+        .first = NULL,
+        .last = NULL,
+        .alloc = alloc,
+    };
+}
+/// Creates the map with the specified type and name.
+static inline MAP_NAME FUNC(new)(void) {
+    return FUNC(new_in)(NULL);
+}
+/// Free a subtree `height` levels above the leaves.
+static inline void FUNC(free_node)(MAP_NAME *map, void *node, const size_t height) {
+    if (height == 0) {
+        sf_free(map->alloc, node, sizeof(LEAF));
+        return;
+    }
+    INNER *inner = node;
+    for (size_t i = 0; i <= inner->count; ++i)
+        FUNC(free_node)(map, inner->children[i], height - 1);
+    sf_free(map->alloc, inner, sizeof(INNER));
+}
+/// Clear a map, resetting it to the default state.
+static inline void FUNC(clear)(MAP_NAME *map) {
+    if (map->root)
+        FUNC(free_node)(map, map->root, map->height);
+    *map = FUNC(new_in)(map->alloc);
+}
+/// Free all of a map's resources.
+static inline void FUNC(free)(MAP_NAME *map) {
+    #ifdef CLEANUP_FN
+    CLEANUP_FN(map);
+    #endif
+    FUNC(clear)(map);
+}
+
+/// Index of the first of `count` keys not less than `key`, searched without data dependent branches.
+static inline size_t FUNC(lower_index)(const MAP_K *keys, size_t count, const MAP_K key) {
+    if (count == 0)
+        return 0;
+    const MAP_K *base = keys;
+    while (count > 1) {
+        const size_t half = count / 2;
+        base = CMP_FN(base[half], key) < 0 ? base + half : base;
+        count -= half;
+    }
+    return (size_t)(base - keys) + (CMP_FN(*base, key) < 0);
+}
+/// Index of the child of `inner` whose range holds `key`.
+static inline size_t FUNC(child_index)(const INNER *inner, const MAP_K key) {
+    const size_t i = FUNC(lower_index)(inner->keys, inner->count, key);
+    return i < inner->count && CMP_FN(inner->keys[i], key) == 0 ? i + 1 : i;
+}
+/// The leaf whose range holds `key`, or NULL when the map is empty.
+static inline LEAF *FUNC(find_leaf)(const MAP_NAME *map, const MAP_K key) {
+    void *node = map->root;
+    for (size_t level = map->height; node && level > 0; --level) {
+        const INNER *inner = node;
+        node = inner->children[FUNC(child_index)(inner, key)];
+    }
+    return node;
+}
+
+#define EX EXPAND_CAT(MAP_NAME, _ex)
+/// Returns the value at `key` on success.
+static inline EX FUNC(get)(const MAP_NAME *map, const MAP_K key) {
+    const LEAF *leaf = FUNC(find_leaf)(map, key);
+    if (!leaf)
+        return EXPAND_CAT(EX, _err)();
+    const size_t i = FUNC(lower_index)(leaf->keys, leaf->count, key);
+    if (i == leaf->count || CMP_FN(leaf->keys[i], key) != 0)
+        return EXPAND_CAT(EX, _err)();
+    return EXPAND_CAT(EX, _ok)(leaf->values[i]);
+}
+
+/// A node split off by an insert, to be added to the parent after `key`.
+typedef struct {
+    void *node;
+    MAP_K key;
+} FUNC(split);
+
+/// Allocate a node, exiting when out of memory like the other containers' inserts.
+static inline void *FUNC(alloc_node)(MAP_NAME *map, const size_t size) {
+    void *node = sf_alloc(map->alloc, size);
+    assert(node && "Out of memory");
+    if (!node) exit(1);
+    return node;
+}
+/// Insert at index `i` of a leaf, splitting it in half when full.
+static inline void FUNC(leaf_insert)(MAP_NAME *map, LEAF *leaf, const size_t i, const MAP_K key, const MAP_V value, FUNC(split) *split) {
+    map->count++;
+    if (leaf->count < LEAF_CAP) {
+        memmove(leaf->keys + i + 1, leaf->keys + i, (leaf->count - i) * sizeof(MAP_K));
+        memmove(leaf->values + i + 1, leaf->values + i, (leaf->count - i) * sizeof(MAP_V));
+        leaf->keys[i] = key;
+        leaf->values[i] = value;
+        leaf->count++;
+        return;
+    }
+    // Lay the pairs out with the new one, then deal them to both halves.
+    MAP_K keys[LEAF_CAP + 1];
+    MAP_V values[LEAF_CAP + 1];
+    memcpy(keys, leaf->keys, i * sizeof(MAP_K));
+    memcpy(values, leaf->values, i * sizeof(MAP_V));
+    keys[i] = key;
+    values[i] = value;
+    memcpy(keys + i + 1, leaf->keys + i, (LEAF_CAP - i) * sizeof(MAP_K));
+    memcpy(values + i + 1, leaf->values + i, (LEAF_CAP - i) * sizeof(MAP_V));
+
+    LEAF *right = FUNC(alloc_node)(map, sizeof(LEAF));
+    leaf->count = (LEAF_CAP + 1) / 2;
+    right->count = LEAF_CAP + 1 - leaf->count;
+    memcpy(leaf->keys, keys, leaf->count * sizeof(MAP_K));
+    memcpy(leaf->values, values, leaf->count * sizeof(MAP_V));
+    memcpy(right->keys, keys + leaf->count, right->count * sizeof(MAP_K));
+    memcpy(right->values, values + leaf->count, right->count * sizeof(MAP_V));
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+        leaf->next->prev = right;
+    else
+        map->last = right;
+    leaf->next = right;
+    split->node = right;
+    split->key = right->keys[0];
+}
+/// Add a child split off from child `i` to an inner node, splitting it around its middle key when full.
+static inline void FUNC(inner_insert)(MAP_NAME *map, INNER *inner, const size_t i, const FUNC(split) child, FUNC(split) *split) {
+    if (inner->count < INNER_CAP) {
+        memmove(inner->keys + i + 1, inner->keys + i, (inner->count - i) * sizeof(MAP_K));
+        memmove(inner->children + i + 2, inner->children + i + 1, (inner->count - i) * sizeof(void *));
+        inner->keys[i] = child.key;
+        inner->children[i + 1] = child.node;
+        inner->count++;
+        return;
+    }
+    MAP_K keys[INNER_CAP + 1];
+    void *children[INNER_CAP + 2];
+    memcpy(keys, inner->keys, i * sizeof(MAP_K));
+    keys[i] = child.key;
+    memcpy(keys + i + 1, inner->keys + i, (INNER_CAP - i) * sizeof(MAP_K));
+    memcpy(children, inner->children, (i + 1) * sizeof(void *));
+    children[i + 1] = child.node;
+    memcpy(children + i + 2, inner->children + i + 1, (INNER_CAP - i) * sizeof(void *));
+
+    // The middle key moves up, leaving both halves at least half full.
+    INNER *right = FUNC(alloc_node)(map, sizeof(INNER));
+    const size_t half = (INNER_CAP + 1) / 2;
+    inner->count = half;
+    right->count = INNER_CAP - half;
+    memcpy(inner->keys, keys, half * sizeof(MAP_K));
+    memcpy(inner->children, children, (half + 1) * sizeof(void *));
+    memcpy(right->keys, keys + half + 1, right->count * sizeof(MAP_K));
+    memcpy(right->children, children + half + 1, (right->count + 1) * sizeof(void *));
+    split->node = right;
+    split->key = keys[half];
+}
+/// Insert below `node`, `height` levels above the leaves.
+static inline void FUNC(insert_node)(MAP_NAME *map, void *node, const size_t height, const MAP_K key, const MAP_V value, FUNC(split) *split) {
+    if (height == 0) {
+        LEAF *leaf = node;
+        const size_t i = FUNC(lower_index)(leaf->keys, leaf->count, key);
+        if (i < leaf->count && CMP_FN(leaf->keys[i], key) == 0) {
+            #ifdef KCLEANUP
+            KCLEANUP(leaf->keys[i]);
+            #endif
+            leaf->keys[i] = key;
+            leaf->values[i] = value;
+            return;
+        }
+        FUNC(leaf_insert)(map, leaf, i, key, value, split);
+        return;
+    }
+    INNER *inner = node;
+    const size_t i = FUNC(child_index)(inner, key);
+    FUNC(split) child = { NULL, key };
+    FUNC(insert_node)(map, inner->children[i], height - 1, key, value, &child);
+    if (child.node)
+        FUNC(inner_insert)(map, inner, i, child, split);
+}
+/// Set the value at the requested key, overriding any existing value.
+static inline void FUNC(set)(MAP_NAME *map, const MAP_K key, const MAP_V value) {
+    if (!map->root) {
+        LEAF *leaf = FUNC(alloc_node)(map, sizeof(LEAF));
+        leaf->count = 0;
+        leaf->prev = leaf->next = NULL;
+        map->root = map->first = map->last = leaf;
+        map->height = 0;
+    }
+    FUNC(split) split = { NULL, key };
+    FUNC(insert_node)(map, map->root, map->height, key, value, &split);
+    if (split.node) {
+        INNER *root = FUNC(alloc_node)(map, sizeof(INNER));
+        root->count = 1;
+        root->keys[0] = split.key;
+        root->children[0] = map->root;
+        root->children[1] = split.node;
+        map->root = root;
+        map->height++;
+    }
+}
+
+/// Refill child `i` of `parent`, `height` levels above the leaves, once it is under half full,
+/// by borrowing from a sibling or merging with one.
+static inline void FUNC(rebalance)(MAP_NAME *map, INNER *parent, const size_t i, const size_t height) {
+    if (height == 0) {
+        LEAF *leaf = parent->children[i];
+        if (leaf->count >= LEAF_CAP / 2)
+            return;
+        LEAF *left = i > 0 ? parent->children[i - 1] : NULL;
+        LEAF *right = i < parent->count ? parent->children[i + 1] : NULL;
+        if (left && left->count > LEAF_CAP / 2) {
+            memmove(leaf->keys + 1, leaf->keys, leaf->count * sizeof(MAP_K));
+            memmove(leaf->values + 1, leaf->values, leaf->count * sizeof(MAP_V));
+            leaf->keys[0] = left->keys[--left->count];
+            leaf->values[0] = left->values[left->count];
+            leaf->count++;
+            parent->keys[i - 1] = leaf->keys[0];
+            return;
+        }
+        if (right && right->count > LEAF_CAP / 2) {
+            leaf->keys[leaf->count] = right->keys[0];
+            leaf->values[leaf->count++] = right->values[0];
+            right->count--;
+            memmove(right->keys, right->keys + 1, right->count * sizeof(MAP_K));
+            memmove(right->values, right->values + 1, right->count * sizeof(MAP_V));
+            parent->keys[i] = right->keys[0];
+            return;
+        }
+        // Both siblings are at the minimum, so one of them and this leaf fit in one node.
+        const size_t j = left ? i - 1 : i;
+        LEAF *into = parent->children[j], *from = parent->children[j + 1];
+        memcpy(into->keys + into->count, from->keys, from->count * sizeof(MAP_K));
+        memcpy(into->values + into->count, from->values, from->count * sizeof(MAP_V));
+        into->count += from->count;
+        into->next = from->next;
+        if (from->next)
+            from->next->prev = into;
+        else
+            map->last = into;
+        sf_free(map->alloc, from, sizeof(LEAF));
+    } else {
+        INNER *inner = parent->children[i];
+        if (inner->count >= INNER_CAP / 2)
+            return;
+        INNER *left = i > 0 ? parent->children[i - 1] : NULL;
+        INNER *right = i < parent->count ? parent->children[i + 1] : NULL;
+        if (left && left->count > INNER_CAP / 2) {
+            memmove(inner->keys + 1, inner->keys, inner->count * sizeof(MAP_K));
+            memmove(inner->children + 1, inner->children, (inner->count + 1) * sizeof(void *));
+            inner->keys[0] = parent->keys[i - 1];
+            inner->children[0] = left->children[left->count];
+            inner->count++;
+            parent->keys[i - 1] = left->keys[--left->count];
+            return;
+        }
+        if (right && right->count > INNER_CAP / 2) {
+            inner->keys[inner->count] = parent->keys[i];
+            inner->children[++inner->count] = right->children[0];
+            parent->keys[i] = right->keys[0];
+            right->count--;
+            memmove(right->keys, right->keys + 1, right->count * sizeof(MAP_K));
+            memmove(right->children, right->children + 1, (right->count + 1) * sizeof(void *));
+            return;
+        }
+        const size_t j = left ? i - 1 : i;
+        INNER *into = parent->children[j], *from = parent->children[j + 1];
+        into->keys[into->count] = parent->keys[j];
+        memcpy(into->keys + into->count + 1, from->keys, from->count * sizeof(MAP_K));
+        memcpy(into->children + into->count + 1, from->children, (from->count + 1) * sizeof(void *));
+        into->count += from->count + 1;
+        sf_free(map->alloc, from, sizeof(INNER));
+    }
+    // Drop the separator and child pointer of the node merged away.
+    const size_t j = i > 0 ? i - 1 : i;
+    memmove(parent->keys + j, parent->keys + j + 1, (parent->count - j - 1) * sizeof(MAP_K));
+    memmove(parent->children + j + 1, parent->children + j + 2, (parent->count - j - 1) * sizeof(void *));
+    parent->count--;
+}
+/// Delete `key` below `node`, `height` levels above the leaves. Returns whether it was found.
+static inline bool FUNC(delete_node)(MAP_NAME *map, void *node, const size_t height, const MAP_K key) {
+    if (height == 0) {
+        LEAF *leaf = node;
+        const size_t i = FUNC(lower_index)(leaf->keys, leaf->count, key);
+        if (i == leaf->count || CMP_FN(leaf->keys[i], key) != 0)
+            return false;
+        #ifdef KCLEANUP
+        KCLEANUP(leaf->keys[i]);
+        #endif
+        leaf->count--;
+        memmove(leaf->keys + i, leaf->keys + i + 1, (leaf->count - i) * sizeof(MAP_K));
+        memmove(leaf->values + i, leaf->values + i + 1, (leaf->count - i) * sizeof(MAP_V));
+        map->count--;
+        return true;
+    }
+    INNER *inner = node;
+    const size_t i = FUNC(child_index)(inner, key);
+    if (!FUNC(delete_node)(map, inner->children[i], height - 1, key))
+        return false;
+    FUNC(rebalance)(map, inner, i, height - 1);
+    return true;
+}
+/// Delete a value from a map by its key.
+static inline void FUNC(delete)(MAP_NAME *map, const MAP_K key) {
+    if (!map->root || !FUNC(delete_node)(map, map->root, map->height, key))
+        return;
+    if (map->height > 0 && ((INNER *)map->root)->count == 0) {
+        INNER *root = map->root;
+        map->root = root->children[0];
+        map->height--;
+        sf_free(map->alloc, root, sizeof(INNER));
+    } else if (map->height == 0 && map->count == 0) {
+        FUNC(clear)(map);
+    }
+}
+
+/// Replace a map's contents with pairs sorted by key, building full nodes bottom up in O(n).
+/// Where a key repeats, its last value wins. Returns false when out of memory or out of order,
+/// leaving the map empty.
+static inline bool FUNC(build_sorted)(MAP_NAME *map, const MAP_K *keys, const MAP_V *values, const size_t count) {
+    FUNC(clear)(map);
+    size_t unique = count > 0;
+    for (size_t i = 1; i < count; ++i) {
+        const int order = CMP_FN(keys[i - 1], keys[i]);
+        assert(order <= 0 && "Keys must be sorted.");
+        if (order > 0)
+            return false;
+        unique += order != 0;
+    }
+    if (unique == 0)
+        return true;
+
+    // Leaves split the pairs evenly, so all of them are at least half full.
+    size_t nodes = (unique + LEAF_CAP - 1) / LEAF_CAP;
+    void **level = sf_alloc(map->alloc, nodes * sizeof(void *));
+    MAP_K *mins = sf_alloc(map->alloc, nodes * sizeof(MAP_K));
+    bool ok = level && mins;
+    LEAF *prev = NULL;
+    for (size_t n = 0, i = 0; ok && n < nodes; ++n) {
+        LEAF *leaf = sf_alloc(map->alloc, sizeof(LEAF));
+        if (!leaf) {
+            ok = false;
+            break;
+        }
+        const size_t size = unique / nodes + (n < unique % nodes);
+        leaf->count = 0;
+        leaf->prev = prev;
+        leaf->next = NULL;
+        if (prev)
+            prev->next = leaf;
+        else
+            map->first = leaf;
+        map->last = prev = leaf;
+        for (; leaf->count < size; ++i) {
+            if (i + 1 < count && CMP_FN(keys[i], keys[i + 1]) == 0)
+                continue;
+            leaf->keys[leaf->count] = keys[i];
+            leaf->values[leaf->count++] = values[i];
+        }
+        level[n] = leaf;
+        mins[n] = leaf->keys[0];
+        map->count += size;
+    }
+    if (!ok) {
+        // Free the leaves through their links, as there is no tree above them yet.
+        for (LEAF *leaf = map->first, *next; leaf; leaf = next) {
+            next = leaf->next;
+            sf_free(map->alloc, leaf, sizeof(LEAF));
+        }
+        *map = FUNC(new_in)(map->alloc);
+    }
+
+    // Each level above groups the one below evenly, reusing the arrays in place.
+    const size_t leaves = nodes;
+    while (ok && nodes > 1) {
+        const size_t parents = (nodes + INNER_CAP) / (INNER_CAP + 1);
+        for (size_t p = 0, c = 0; p < parents; ++p) {
+            INNER *inner = sf_alloc(map->alloc, sizeof(INNER));
+            if (!inner) {
+                // Parents built so far took over their children, so free both from what is left.
+                for (size_t q = 0; q < p; ++q)
+                    FUNC(free_node)(map, level[q], map->height + 1);
+                for (; c < nodes; ++c)
+                    FUNC(free_node)(map, level[c], map->height);
+                *map = FUNC(new_in)(map->alloc);
+                ok = false;
+                break;
+            }
+            const size_t size = nodes / parents + (p < nodes % parents);
+            const MAP_K min = mins[c];
+            inner->count = size - 1;
+            for (size_t k = 0; k < size; ++k, ++c) {
+                inner->children[k] = level[c];
+                if (k > 0)
+                    inner->keys[k - 1] = mins[c];
+            }
+            level[p] = inner;
+            mins[p] = min;
+        }
+        nodes = parents;
+        map->height += ok;
+    }
+    if (ok)
+        map->root = level[0];
+    if (level)
+        sf_free(map->alloc, level, leaves * sizeof(void *));
+    if (mins)
+        sf_free(map->alloc, mins, leaves * sizeof(MAP_K));
+    return ok;
+}
+
+/// Position of the first pair.
+static inline FUNC(iter) FUNC(begin)(const MAP_NAME *map) {
+    return (FUNC(iter)){ map->first && map->first->count ? map->first : NULL, 0 };
+}
+/// Position of the last pair.
+static inline FUNC(iter) FUNC(rbegin)(const MAP_NAME *map) {
+    return (FUNC(iter)){ map->last && map->last->count ? map->last : NULL, map->last ? map->last->count - 1 : 0 };
+}
+/// Position of the first pair with a key not less than `key`.
+static inline FUNC(iter) FUNC(lower_bound)(const MAP_NAME *map, const MAP_K key) {
+    const LEAF *leaf = FUNC(find_leaf)(map, key);
+    if (!leaf)
+        return (FUNC(iter)){ NULL, 0 };
+    const size_t i = FUNC(lower_index)(leaf->keys, leaf->count, key);
+    if (i == leaf->count)
+        return (FUNC(iter)){ leaf->next, 0 };
+    return (FUNC(iter)){ leaf, i };
+}
+/// Returns whether an iterator points at a pair.
+static inline bool FUNC(iter_valid)(const FUNC(iter) it) {
+    return it.leaf != NULL;
+}
+static inline MAP_K FUNC(iter_key)(const FUNC(iter) it) {
+    return it.leaf->keys[it.index];
+}
+static inline MAP_V FUNC(iter_value)(const FUNC(iter) it) {
+    return it.leaf->values[it.index];
+}
+/// Step to the pair with the next higher key.
+static inline void FUNC(iter_next)(FUNC(iter) *it) {
+    if (++it->index == it->leaf->count) {
+        it->leaf = it->leaf->next;
+        it->index = 0;
+    }
+}
+/// Step to the pair with the next lower key.
+static inline void FUNC(iter_prev)(FUNC(iter) *it) {
+    if (it->index-- == 0) {
+        it->leaf = it->leaf->prev;
+        it->index = it->leaf ? it->leaf->count - 1 : 0;
+    }
+}
+/// Loop over the pairs with keys from `lo` up to but excluding `hi`, in order.
+static inline void FUNC(range)(const MAP_NAME *map, const MAP_K lo, const MAP_K hi, void (*func)(void *ud, MAP_K key, MAP_V value), void *ud) {
+    for (FUNC(iter) it = FUNC(lower_bound)(map, lo); it.leaf; FUNC(iter_next)(&it)) {
+        if (CMP_FN(it.leaf->keys[it.index], hi) >= 0)
+            return;
+        func(ud, it.leaf->keys[it.index], it.leaf->values[it.index]);
+    }
+}
+/// Loop over a map's key/value pairs in order and execute custom code with them.
+static inline void FUNC(foreach)(const MAP_NAME *map, void (*func)(void *ud, MAP_K key, MAP_V value), void *ud) {
+    for (const LEAF *leaf = map->first; leaf; leaf = leaf->next)
+        for (size_t i = 0; i < leaf->count; ++i)
+            func(ud, leaf->keys[i], leaf->values[i]);
+}
+#undef EX
+
+#undef LEAF
+#undef INNER
+#undef LEAF_FIT
+#undef LEAF_CAP
+#undef INNER_FIT
+#undef INNER_CAP
+#undef BTREE_NODE_BYTES
+
+#undef MAP_NAME
+#undef MAP_K
+#undef MAP_V
+#undef CMP_FN
+#ifdef CLEANUP_FN
+#undef CLEANUP_FN
+#endif
+#ifdef KCLEANUP
+#undef KCLEANUP
+#endif
+
+#undef CAT
+#undef EXPAND_CAT
+#undef FUNC
@@ -1,59 +1,85 @@
-#ifndef SF_BUFFER_H
-#define SF_BUFFER_H
-
-#include <stddef.h>
-#include <stdint.h>
-#include "export.h"
-
-/// Flags for determining a buffer's behavior.
-typedef enum {
-    SF_BUFFER_GROW     = (1 << 1),
-    SF_BUFFER_EMPTY    = (1 << 2),
-    SF_BUFFER_READONLY = (1 << 3),
-} sf_buffer_flag;
-
-/// Locations to offset from for use with buffer seeking.
-typedef enum {
-    SF_BUFFER_START,
-    SF_BUFFER_END,
-} sf_buffer_handle;
-
-/// A dynamic buffer object which can be written to and optionally expand.
-typedef struct {
-    size_t size;
-    uint8_t *ptr;
-    uint8_t *head;
-    uint8_t flags;
-} sf_buffer;
-
-typedef enum {
-    SF_BUFFER_FULL,
-    SF_BUFFER_OOB, // Out of bounds
-    SF_BUFFER_ALLOC_FAIL,
-} sf_buffer_err;
-
-#define EXPECTED_NAME sf_buffer_ex
-#define EXPECTED_E sf_buffer_err
-#include <sf/containers/expected.h>
-
-/// Allocate a fixed buffer at a specified size.
-EXPORT sf_buffer sf_buffer_fixed(size_t size);
-/// Allocate a buffer that grows as you insert bytes.
-EXPORT sf_buffer sf_buffer_grow(void);
-/// Wrap an existing buffer with an sf_buffer.
-EXPORT sf_buffer sf_buffer_own(uint8_t *existing, size_t size);
-/// Insert a value into a buffer. Can fail if there is not enough space.
-EXPORT sf_buffer_ex sf_buffer_insert(sf_buffer *buffer, const void *const ptr, size_t size);
-/// Insert a value into a buffer with automatic sizing.
-#define sf_buffer_autoins(buffer, value) sf_buffer_insert(buffer, value, sizeof(*(value)))
-/// Seek to a position in the buffer.
-EXPORT void sf_buffer_seek(sf_buffer *buffer, sf_buffer_handle handle, int64_t offset);
-/// Free a buffer and/or revert it to an empty state.
-EXPORT void sf_buffer_clear(sf_buffer *buffer);
-/// Copies x bytes from the buffer head to the specified location.
-EXPORT sf_buffer_ex sf_buffer_read(sf_buffer *buffer, void *dest, size_t bytes);
-/// Automatically read a value based on the type of the pointer.
-/// `dest` must be a pointer.
-#define sf_buffer_autoread(buffer, dest) sf_buffer_read(buffer, dest, sizeof(*(dest)))
-
-#endif // SF_BUFFER
+#ifndef SF_BUFFER_H
+#define SF_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "sf/alloc.h"
+
+/// Flags for determining a buffer's behavior.
+typedef enum {
+    SF_BUFFER_GROW     = (1 << 1),
+    SF_BUFFER_EMPTY    = (1 << 2),
+    SF_BUFFER_READONLY = (1 << 3),
+} sf_buffer_flag;
+
+/// Locations to offset from for use with buffer seeking.
+typedef enum {
+    SF_BUFFER_START,
+    SF_BUFFER_END,
+} sf_buffer_handle;
+
+/// Capacity a growing buffer starts at once it is first written to.
+#define SF_BUFFER_MIN_CAPACITY 64
+
+/// A dynamic buffer object which can be written to and optionally expand.
+typedef struct {
+    size_t size; /// Bytes of data, the furthest the head has written to.
+    size_t capacity; /// Bytes allocated, always at least `size`.
+    uint8_t *ptr;
+    uint8_t *head;
+    uint8_t flags;
+    const sf_allocator *alloc; /// Where `ptr` is allocated from, NULL for the C heap.
+} sf_buffer;
+
+typedef enum {
+    SF_BUFFER_FULL,
+    SF_BUFFER_OOB, // Out of bounds
+    SF_BUFFER_ALLOC_FAIL,
+    SF_BUFFER_NOT_WRITABLE, // Write to a SF_BUFFER_READONLY buffer
+} sf_buffer_err;
+
+#define EXPECTED_NAME sf_buffer_ex
+#define EXPECTED_E sf_buffer_err
+#include <sf/containers/expected.h>
+
+#define EXPECTED_NAME sf_buffer_prep_ex
+#define EXPECTED_O uint8_t *
+#define EXPECTED_E sf_buffer_err
+#include <sf/containers/expected.h>
+
+/// Allocate a fixed buffer at a specified size.
+EXPORT sf_buffer sf_buffer_fixed(size_t size);
+/// Allocate a fixed buffer at a specified size from `alloc`.
+EXPORT sf_buffer sf_buffer_fixed_in(const sf_allocator *alloc, size_t size);
+/// Allocate a buffer that grows as you insert bytes.
+EXPORT sf_buffer sf_buffer_grow(void);
+/// Create a buffer that grows as you insert bytes, allocating from `alloc`.
+EXPORT sf_buffer sf_buffer_grow_in(const sf_allocator *alloc);
+/// Wrap an existing buffer with an sf_buffer.
+EXPORT sf_buffer sf_buffer_own(uint8_t *existing, size_t size);
+/// Insert a value into a buffer. Can fail if there is not enough space.
+EXPORT sf_buffer_ex sf_buffer_insert(sf_buffer *buffer, const void *const ptr, size_t size);
+/// Grow a buffer's allocation to at least `capacity` bytes.
+/// Fails with SF_BUFFER_FULL on buffers that can't grow.
+EXPORT sf_buffer_ex sf_buffer_reserve(sf_buffer *buffer, size_t capacity);
+/// Make room for `size` bytes at the head and return where to write them,
+/// finish the write with `sf_buffer_commit`.
+EXPORT sf_buffer_prep_ex sf_buffer_prepare(sf_buffer *buffer, size_t size);
+/// Advance the head past `size` bytes written into the space returned by `sf_buffer_prepare`.
+EXPORT void sf_buffer_commit(sf_buffer *buffer, size_t size);
+/// Insert a value into a buffer with automatic sizing.
+#define sf_buffer_autoins(buffer, value) sf_buffer_insert(buffer, value, sizeof(*(value)))
+/// Seek to a position in the buffer.
+EXPORT void sf_buffer_seek(sf_buffer *buffer, sf_buffer_handle handle, int64_t offset);
+/// Free a buffer and/or revert it to an empty state.
+EXPORT void sf_buffer_clear(sf_buffer *buffer);
+/// Hash a buffer's data with sf_hash64. Use sf_hash_update to hash data spread over several buffers.
+EXPORT uint64_t sf_buffer_hash(const sf_buffer *buffer);
+/// Copies x bytes from the buffer head to the specified location.
+EXPORT sf_buffer_ex sf_buffer_read(sf_buffer *buffer, void *dest, size_t bytes);
+/// Automatically read a value based on the type of the pointer.
+/// `dest` must be a pointer.
+#define sf_buffer_autoread(buffer, dest) sf_buffer_read(buffer, dest, sizeof(*(dest)))
+
+#endif // SF_BUFFER
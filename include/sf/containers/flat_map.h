@@ -0,0 +1,338 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "sf/alloc.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+/***********************************
+ * A map for tables built once and read many times, with keys and values in contiguous sorted arrays.
+ * Lookups binary search a copy of the keys in Eytzinger order, where the nodes the next few steps
+ * can visit share cache lines. Changes rebuild the arrays, so batch them with insert_batch.
+ * You should #define MAP_K & MAP_V as key/value types,
+ * #define MAP_NAME as the desired type name for the map.
+ * Optionally, #define:
+ * - bool (*LESS_FN)(const MAP_K, const MAP_K), defaulting to `<`
+ * - void (*CLEANUP_FN)(MAP_NAME *)
+***********************************/
+
+#ifndef SF_FLAT_EYTZINGER
+#define SF_FLAT_EYTZINGER
+
+/// Index of the highest set bit. `value` must not be 0.
+static inline unsigned sf_flat_log2(size_t value) {
+#if defined(__GNUC__)
+    return (unsigned)(sizeof(unsigned long long) * 8 - 1) - (unsigned)__builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long i;
+    _BitScanReverse64(&i, value);
+    return (unsigned)i;
+#else
+    unsigned i = 0;
+    while (value >>= 1)
+        ++i;
+    return i;
+#endif
+}
+/// Index of the lowest set bit. `value` must not be 0.
+static inline unsigned sf_flat_ctz(size_t value) {
+#if defined(__GNUC__)
+    return (unsigned)__builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long i;
+    _BitScanForward64(&i, value);
+    return (unsigned)i;
+#else
+    unsigned i = 0;
+    for (; !(value & 1); value >>= 1)
+        ++i;
+    return i;
+#endif
+}
+/// Sorted position of node `k` in an Eytzinger tree of `count` nodes, numbered from 1.
+/// Nodes fill levels left to right, so its position in a perfect tree only overcounts
+/// the missing last level nodes to its left, which are every other position from the end.
+static inline size_t sf_flat_rank(const size_t k, const size_t count) {
+    const unsigned height = sf_flat_log2(count), depth = sf_flat_log2(k);
+    const size_t perfect = ((2 * (k - ((size_t)1 << depth)) + 1) << (height - depth)) - 1;
+    const size_t last_level = count - (((size_t)1 << height) - 1);
+    const size_t leaves_before = (perfect + 1) / 2;
+    return perfect - (leaves_before > last_level ? leaves_before - last_level : 0);
+}
+
+#if defined(__GNUC__)
+#define SF_FLAT_PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define SF_FLAT_PREFETCH(ptr) ((void)(ptr))
+#endif
+
+#endif // SF_FLAT_EYTZINGER
+
+#ifndef MAP_NAME
+#error Undefined typename MAP_NAME
+#define MAP_NAME sf_flat_map
+#endif
+#ifndef MAP_K
+#error Undefined type MAP_K
+#define MAP_K void *
+#endif
+#ifndef MAP_V
+#error Undefined type MAP_V
+#define MAP_V void *
+#endif
+
+#define EXPECTED_NAME EXPAND_CAT(MAP_NAME, _ex)
+#define EXPECTED_O MAP_V
+#include "sf/containers/expected.h"
+
+#define CAT(a, b) a##b
+#define EXPAND_CAT(a, b) CAT(a, b)
+#define FUNC(name) EXPAND_CAT(MAP_NAME, _##name)
+
+/// Ranges this short are insertion sorted before merging.
+#define FLAT_SMALL 16
+/// Tree nodes per cache line. The descendants four levels down from node k start at 16k,
+/// so prefetching there hides most of the latency of the deeper levels.
+#define FLAT_PREFETCH_STRIDE (sizeof(MAP_K) < 64 ? 64 / sizeof(MAP_K) : 1)
+
+#ifndef LESS_FN
+/// Default ordering of keys.
+static inline bool FUNC(less)(const MAP_K a, const MAP_K b) {
+    return a < b;
+}
+#define LESS_FN FUNC(less)
+#endif
+
+/// A sorted map with keys and values in separate arrays.
+typedef struct MAP_NAME {
+    size_t count; /// The amount of key/value pairs.
+    size_t capacity; /// The amount of pairs the arrays have room for.
+    MAP_K *keys; /// Sorted keys.
+    MAP_V *values; /// Values, in the order of `keys`.
+    MAP_K *tree; /// The keys again in Eytzinger order from index 1, for lookups.
+    const sf_allocator *alloc; /// Where the arrays are allocated from, NULL for the C heap.
+} MAP_NAME;
+
+/// Creates an empty map allocating from `alloc`.
+static inline MAP_NAME FUNC(new_in)(const sf_allocator *alloc) {
+    return (MAP_NAME) {
+        .count = 0,
+        .capacity = 0,
+        .keys = NULL,
+        .values = NULL,
+        .tree = NULL,
+        .alloc = alloc,
+    };
+}
+/// Creates an empty map.
+static inline MAP_NAME FUNC(new)(void) {
+    return FUNC(new_in)(NULL);
+}
+/// Free the arrays of a map, leaving it empty.
+static inline void FUNC(clear)(MAP_NAME *map) {
+    if (map->capacity) {
+        sf_free(map->alloc, map->keys, map->capacity * sizeof(MAP_K));
+        sf_free(map->alloc, map->values, map->capacity * sizeof(MAP_V));
+        sf_free(map->alloc, map->tree, (map->capacity + 1) * sizeof(MAP_K));
+    }
+    *map = FUNC(new_in)(map->alloc);
+}
+/// Free all of a map's resources.
+static inline void FUNC(free)(MAP_NAME *map) {
+    #ifdef CLEANUP_FN
+    CLEANUP_FN(map);
+    #endif
+    FUNC(clear)(map);
+}
+/// Lay the sorted keys out in Eytzinger order.
+static inline void FUNC(layout)(MAP_NAME *map) {
+    for (size_t k = 1; k <= map->count; ++k)
+        map->tree[k] = map->keys[sf_flat_rank(k, map->count)];
+}
+/// Stable sort of keys and values together, through `scratch_keys` and `scratch_values`.
+static inline void FUNC(sort_pairs)(MAP_K *keys, MAP_V *values, MAP_K *scratch_keys, MAP_V *scratch_values, const size_t count) {
+    for (size_t lo = 0; lo < count; lo += FLAT_SMALL) {
+        const size_t hi = lo + FLAT_SMALL < count ? lo + FLAT_SMALL : count;
+        for (size_t i = lo + 1; i < hi; ++i) {
+            const MAP_K key = keys[i];
+            const MAP_V value = values[i];
+            size_t j = i;
+            for (; j > lo && LESS_FN(key, keys[j - 1]); --j) {
+                keys[j] = keys[j - 1];
+                values[j] = values[j - 1];
+            }
+            keys[j] = key;
+            values[j] = value;
+        }
+    }
+    MAP_K *src_k = keys, *dst_k = scratch_keys;
+    MAP_V *src_v = values, *dst_v = scratch_values;
+    for (size_t width = FLAT_SMALL; width < count; width *= 2) {
+        for (size_t lo = 0; lo < count; lo += width * 2) {
+            const size_t mid = lo + width < count ? lo + width : count;
+            const size_t hi = mid + width < count ? mid + width : count;
+            size_t i = lo, j = mid, out = lo;
+            while (i < mid && j < hi) {
+                const size_t from = LESS_FN(src_k[j], src_k[i]) ? j++ : i++;
+                dst_k[out] = src_k[from];
+                dst_v[out++] = src_v[from];
+            }
+            for (; i < mid; ++i, ++out) {
+                dst_k[out] = src_k[i];
+                dst_v[out] = src_v[i];
+            }
+            for (; j < hi; ++j, ++out) {
+                dst_k[out] = src_k[j];
+                dst_v[out] = src_v[j];
+            }
+        }
+        MAP_K *tk = src_k;
+        src_k = dst_k;
+        dst_k = tk;
+        MAP_V *tv = src_v;
+        src_v = dst_v;
+        dst_v = tv;
+    }
+    if (src_k != keys) {
+        memcpy(keys, src_k, count * sizeof(MAP_K));
+        memcpy(values, src_v, count * sizeof(MAP_V));
+    }
+}
+/// Insert many pairs at once, overriding existing values. Where the batch repeats a key, its last value wins.
+/// The batch is sorted and merged with the map in one pass, so this costs O(n + m log m) for m new pairs.
+/// Returns false when out of memory, leaving the map unchanged.
+static inline bool FUNC(insert_batch)(MAP_NAME *map, const MAP_K *keys, const MAP_V *values, const size_t count) {
+    if (count == 0)
+        return true;
+    if (count > SIZE_MAX / 2 / sizeof(MAP_K) || count > SIZE_MAX / 2 / sizeof(MAP_V)
+        || map->count > SIZE_MAX / 2 / sizeof(MAP_K) - count || map->count > SIZE_MAX / 2 / sizeof(MAP_V) - count)
+        return false;
+    const size_t total = map->count + count;
+    // The batch and its merge scratch, then the merged arrays.
+    MAP_K *batch_keys = sf_alloc(map->alloc, count * 2 * sizeof(MAP_K));
+    MAP_V *batch_values = sf_alloc(map->alloc, count * 2 * sizeof(MAP_V));
+    MAP_K *new_keys = sf_alloc(map->alloc, total * sizeof(MAP_K));
+    MAP_V *new_values = sf_alloc(map->alloc, total * sizeof(MAP_V));
+    MAP_K *new_tree = sf_alloc(map->alloc, (total + 1) * sizeof(MAP_K));
+    const bool allocated = batch_keys && batch_values && new_keys && new_values && new_tree;
+    if (allocated) {
+        memcpy(batch_keys, keys, count * sizeof(MAP_K));
+        memcpy(batch_values, values, count * sizeof(MAP_V));
+        FUNC(sort_pairs)(batch_keys, batch_values, batch_keys + count, batch_values + count, count);
+
+        size_t i = 0, j = 0, out = 0;
+        while (i < map->count || j < count) {
+            // Skip batch pairs whose key comes again later in the batch.
+            if (j + 1 < count && !LESS_FN(batch_keys[j], batch_keys[j + 1])) {
+                ++j;
+                continue;
+            }
+            if (j == count || (i < map->count && LESS_FN(map->keys[i], batch_keys[j]))) {
+                new_keys[out] = map->keys[i];
+                new_values[out++] = map->values[i++];
+                continue;
+            }
+            if (i < map->count && !LESS_FN(batch_keys[j], map->keys[i]))
+                ++i;
+            new_keys[out] = batch_keys[j];
+            new_values[out++] = batch_values[j++];
+        }
+        FUNC(clear)(map);
+        map->count = out;
+        map->capacity = total;
+        map->keys = new_keys;
+        map->values = new_values;
+        map->tree = new_tree;
+        FUNC(layout)(map);
+    } else {
+        sf_free(map->alloc, new_keys, total * sizeof(MAP_K));
+        sf_free(map->alloc, new_values, total * sizeof(MAP_V));
+        sf_free(map->alloc, new_tree, (total + 1) * sizeof(MAP_K));
+    }
+    sf_free(map->alloc, batch_keys, count * 2 * sizeof(MAP_K));
+    sf_free(map->alloc, batch_values, count * 2 * sizeof(MAP_V));
+    return allocated;
+}
+/// Replace a map's contents with unsorted pairs. Where a key repeats, its last value wins.
+/// Returns false when out of memory, leaving the map empty.
+static inline bool FUNC(build)(MAP_NAME *map, const MAP_K *keys, const MAP_V *values, const size_t count) {
+    FUNC(clear)(map);
+    return FUNC(insert_batch)(map, keys, values, count);
+}
+/// Eytzinger node of the first key not less than `key`, or 0 if there is none.
+static inline size_t FUNC(search)(const MAP_NAME *map, const MAP_K key) {
+    const MAP_K *tree = map->tree;
+    size_t k = 1;
+    while (k <= map->count) {
+        SF_FLAT_PREFETCH(tree + k * FLAT_PREFETCH_STRIDE);
+        k = 2 * k + LESS_FN(tree[k], key);
+    }
+    // The last step left went to the answer, so drop the right steps after it and that step.
+    return k >> (sf_flat_ctz(~k) + 1);
+}
+/// Index of the first key not less than `key` in `keys`, or count if there is none.
+static inline size_t FUNC(lower_bound)(const MAP_NAME *map, const MAP_K key) {
+    const size_t k = FUNC(search)(map, key);
+    return k ? sf_flat_rank(k, map->count) : map->count;
+}
+
+#define EX EXPAND_CAT(MAP_NAME, _ex)
+/// Returns the value at `key` on success.
+static inline EX FUNC(get)(const MAP_NAME *map, const MAP_K key) {
+    // The node just compared is still in cache, unlike the sorted key.
+    const size_t k = FUNC(search)(map, key);
+    if (k == 0 || LESS_FN(key, map->tree[k]))
+        return EXPAND_CAT(EX, _err)();
+    return EXPAND_CAT(EX, _ok)(map->values[sf_flat_rank(k, map->count)]);
+}
+/// Set the value at the requested key, overriding any existing value. Rebuilds the arrays, O(n).
+/// Returns false when out of memory.
+static inline bool FUNC(set)(MAP_NAME *map, const MAP_K key, const MAP_V value) {
+    const size_t i = FUNC(lower_bound)(map, key);
+    if (i < map->count && !LESS_FN(key, map->keys[i])) {
+        map->values[i] = value;
+        return true;
+    }
+    return FUNC(insert_batch)(map, &key, &value, 1);
+}
+/// Delete a value from a map by its key, O(n).
+static inline void FUNC(delete)(MAP_NAME *map, const MAP_K key) {
+    const size_t i = FUNC(lower_bound)(map, key);
+    if (i == map->count || LESS_FN(key, map->keys[i]))
+        return;
+    memmove(map->keys + i, map->keys + i + 1, (map->count - i - 1) * sizeof(MAP_K));
+    memmove(map->values + i, map->values + i + 1, (map->count - i - 1) * sizeof(MAP_V));
+    map->count--;
+    FUNC(layout)(map);
+}
+/// Loop over the pairs with keys from `lo` up to but excluding `hi`, in order.
+static inline void FUNC(range)(const MAP_NAME *map, const MAP_K lo, const MAP_K hi, void (*func)(void *ud, MAP_K key, MAP_V value), void *ud) {
+    for (size_t i = FUNC(lower_bound)(map, lo); i < map->count && LESS_FN(map->keys[i], hi); ++i)
+        func(ud, map->keys[i], map->values[i]);
+}
+/// Loop over a map's key/value pairs in order and execute custom code with them.
+static inline void FUNC(foreach)(const MAP_NAME *map, void (*func)(void *ud, MAP_K key, MAP_V value), void *ud) {
+    for (size_t i = 0; i < map->count; ++i)
+        func(ud, map->keys[i], map->values[i]);
+}
+#undef EX
+
+#undef FLAT_SMALL
+#undef FLAT_PREFETCH_STRIDE
+
+#undef MAP_NAME
+#undef MAP_K
+#undef MAP_V
+#undef LESS_FN
+#ifdef CLEANUP_FN
+#undef CLEANUP_FN
+#endif
+
+#undef CAT
+#undef EXPAND_CAT
+#undef FUNC
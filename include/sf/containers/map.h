@@ -1,251 +1,406 @@
-#include <assert.h>
-#include <stdint.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-
-#pragma GCC diagnostic ignored "-Wunused-function"
-
-/***********************************
- * You should #define MAP_K & MAP_V as key/value types,
- * #define MAP_NAME as the desired type name for the map.
- * Optionally, #define:
- * - uint32_t (*HASH_FN)(const MAP_K)
- * - bool (*EQUAL_FN)(const MAP_K, const MAP_K)
- * - void (*CLEANUP_FN)(MAP_NAME *)
- * - void (*KCLEANUP)(MAP_K)
-***********************************/
-
-#ifndef MAP_NAME
-#error Undefined typename MAP_NAME
-#define MAP_NAME sf_map
-#endif
-#ifndef MAP_K
-#error Undefined type MAP_K
-#define MAP_K void *
-#endif
-#ifndef MAP_V
-#error Undefined type MAP_V
-#define MAP_V void *
-#endif
-
-#define EXPECTED_NAME EXPAND_CAT(MAP_NAME, _ex)
-#define EXPECTED_O MAP_V
-#include "sf/containers/expected.h"
-
-#define CAT(a, b) a##b
-#define EXPAND_CAT(a, b) CAT(a, b)
-#define FUNC(name) EXPAND_CAT(MAP_NAME, _##name)
-
-#define DEFAULT_BUCKETS 8
-#define SF_FNV1A_PRIME 0x01000193
-#define SF_FNV1A_SEED 0x811C9DC5
-
-#ifndef HASH_FN
-/// Default fnv1a hashing function for keys.
-static inline uint32_t FUNC(hash)(const MAP_K key) {
-    const unsigned char *head = (unsigned char *)&key;
-    size_t size = sizeof(MAP_K);
-    uint32_t hash = SF_FNV1A_SEED;
-    while (size--) {
-        const unsigned char cc = *head++;
-        hash = (cc ^ hash) * SF_FNV1A_PRIME;
-    }
-    return hash;
-}
-#define HASH_FN FUNC(hash)
-#endif
-
-/// A key/value pair with user defined types.
-#define BUCKET EXPAND_CAT(MAP_NAME, _bucket)
-typedef struct BUCKET {
-    MAP_K key;
-    MAP_V value;
-    struct BUCKET *next;
-} BUCKET;
-/// Helper function for pushing buckets.
-static inline BUCKET *FUNC(push_kv)(BUCKET *list, BUCKET *new) {
-    new->next = list;
-    return new;
-}
-
-/// A map that uses user defined types for keys/values.
-typedef struct MAP_NAME {
-    size_t bucket_count; /// Expands to reduce conflicts as the map grows.
-    size_t pair_count; /// The amount of key/value pairs currently held within the map.
-    BUCKET **buckets;
-} MAP_NAME;
-
-/// Creates the map with the specified type and name.
-static inline MAP_NAME FUNC(new)(void) {
-    return (MAP_NAME) {
-        .bucket_count = DEFAULT_BUCKETS,
-        .pair_count = 0,
-        .buckets = calloc(DEFAULT_BUCKETS, sizeof(BUCKET *)),
-    };
-}
-/// Clear a map, resetting it to the default state.
-static inline void FUNC(clear)(MAP_NAME *map) {
-    if (!map->buckets || !map->bucket_count)
-        return;
-
-    for (size_t i = 0; i < map->bucket_count; ++i) {
-        BUCKET *pair = map->buckets[i];
-        map->buckets[i] = NULL;
-
-        while (pair) {
-            BUCKET *next = pair->next;
-            free(pair);
-            pair = next;
-        }
-    }
-
-    if (map->bucket_count > DEFAULT_BUCKETS) {
-        map->bucket_count = DEFAULT_BUCKETS;
-        free(map->buckets);
-        map->buckets = calloc(map->bucket_count, sizeof(BUCKET *));
-    }
-}
-/// Free all of a map's resources.
-static inline void FUNC(free)(MAP_NAME *map) {
-    #ifdef CLEANUP_FN
-    CLEANUP_FN(map);
-    #endif
-    FUNC(clear)(map);
-    free(map->buckets);
-    map->buckets = NULL;
-    map->bucket_count = 0;
-    map->pair_count = 0;
-}
-/// Calculate the load of a map.
-static inline double FUNC(load)(const MAP_NAME *map, const size_t bucket_count) {
-    return (double)map->pair_count / (double)bucket_count;
-}
-/// Rehash a map when the load gets too high.
-static inline void FUNC(rehash)(MAP_NAME *map, const size_t new_bucket_count) {
-    if (!map->buckets || !map->bucket_count)
-        return;
-
-    BUCKET **old_buckets = map->buckets;
-    size_t old_count = map->bucket_count;
-
-    // Allocate new bucket array
-    map->buckets = calloc(new_bucket_count, sizeof(BUCKET *));
-    map->bucket_count = new_bucket_count;
-
-    // Reinsert all pairs
-    for (size_t i = 0; i < old_count; ++i) {
-        BUCKET *pair = old_buckets[i];
-        while (pair) {
-            BUCKET *next = pair->next;
-            uint32_t hash = HASH_FN(pair->key) % new_bucket_count;
-            pair->next = map->buckets[hash];
-            map->buckets[hash] = pair;
-            pair = next;
-        }
-    }
-
-    free(old_buckets);
-}
-
-#define EX EXPAND_CAT(MAP_NAME, _ex)
-/// Returns whether the key exists or not and writes to `out` on success.
-/// If `out` is null, simply return whether the key exists.
-static inline EX FUNC(get)(const MAP_NAME *map, MAP_K key) {
-    if (!map->buckets || !map->bucket_count)
-        return EXPAND_CAT(EX, _err)();
-    const uint32_t hash = HASH_FN(key) % map->bucket_count;
-
-    const BUCKET *seek = map->buckets[hash];
-    const void *s = seek; (void)s;
-    while (seek) {
-        #ifndef EQUAL_FN
-        if (key == seek->key)
-            break;
-        #else
-        if (EQUAL_FN(key, seek->key))
-            break;
-        #endif
-        seek = seek->next;
-    }
-
-    if (!seek)
-        return EXPAND_CAT(EX, _err)();
-
-    return EXPAND_CAT(EX, _ok)(seek->value);
-}
-/// Delete a value from a map by its key.
-static inline void FUNC(delete)(MAP_NAME *map, MAP_K key) {
-    if (!map->buckets || !map->bucket_count)
-        return;
-
-    const uint32_t hash = HASH_FN(key) % map->bucket_count;
-    BUCKET *seek = map->buckets[hash];
-    BUCKET *seek_p = NULL;
-    while (seek) {
-        #ifndef EQUAL_FN
-        if (key == seek->key) {
-        #else
-        if (EQUAL_FN(key, seek->key)) {
-        #endif
-            if (seek_p) seek_p->next = seek->next;
-            else map->buckets[hash] = seek->next;
-            #ifdef KCLEANUP
-            KCLEANUP(seek->key);
-            #endif
-            free(seek);
-            map->pair_count--;
-            break;
-        }
-        seek_p = seek;
-        seek = seek->next;
-    }
-}
-/// Set the value at the requested key, overriding any existing value.
-static inline void FUNC(set)(MAP_NAME *map, MAP_K key, MAP_V value) {
-    if (!map->buckets || !map->bucket_count)
-        return;
-    if (FUNC(get)(map, key).is_ok)
-        FUNC(delete)(map, key);
-
-    const uint32_t hash = HASH_FN(key) % map->bucket_count;
-    BUCKET *pair = malloc(sizeof(BUCKET));
-    *pair = (BUCKET) {
-        key,
-        value,
-        NULL
-    };
-    map->buckets[hash] = FUNC(push_kv)(map->buckets[hash], pair);
-    map->pair_count++;
-
-    if (FUNC(load)(map, map->bucket_count) > 0.75)
-        FUNC(rehash)(map, map->bucket_count * 2);
-}
-/// Loop over a map's key/value pairs and execute custom code with them.
-static inline void FUNC(foreach)(const MAP_NAME *map, void (*func)(void *ud, MAP_K key, MAP_V value), void *ud) {
-    if (!map->buckets || !map->bucket_count)
-        return;
-    for (size_t i = 0; i < map->bucket_count; ++i) {
-        BUCKET *p = map->buckets[i];
-        while (p) {
-            func(ud, p->key, p->value);
-            p = p->next;
-        }
-    }
-}
-
-#undef MAP_NAME
-#undef MAP_K
-#undef MAP_V
-#undef HASH_FN
-#undef EQUAL_FN
-#ifdef CLEANUP_FN
-#undef CLEANUP_FN
-#endif
-#ifdef KCLEANUP
-#undef KCLEANUP
-#endif
-
-#undef CAT
-#undef EXPAND_CAT
-#undef FUNC
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "sf/alloc.h"
+#include "sf/math.h"
+#ifdef MAP_POOL
+#include "sf/pool.h"
+#endif
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+/***********************************
+ * You should #define MAP_K & MAP_V as key/value types,
+ * #define MAP_NAME as the desired type name for the map.
+ * Optionally, #define:
+ * - uint64_t (*HASH_FN)(const MAP_K), whose low bits must be well mixed
+ * - bool (*EQUAL_FN)(const MAP_K, const MAP_K)
+ * - void (*CLEANUP_FN)(MAP_NAME *)
+ * - void (*KCLEANUP)(MAP_K)
+ * - MAP_INCREMENTAL, to spread rehashing across operations
+ * - size_t MAP_MIGRATE_STEP, buckets migrated per operation when incremental
+ * - MAP_POOL, to allocate pairs from a per-map sf_pool
+***********************************/
+
+#ifndef MAP_NAME
+#error Undefined typename MAP_NAME
+#define MAP_NAME sf_map
+#endif
+#ifndef MAP_K
+#error Undefined type MAP_K
+#define MAP_K void *
+#endif
+#ifndef MAP_V
+#error Undefined type MAP_V
+#define MAP_V void *
+#endif
+
+#define EXPECTED_NAME EXPAND_CAT(MAP_NAME, _ex)
+#define EXPECTED_O MAP_V
+#include "sf/containers/expected.h"
+
+#define CAT(a, b) a##b
+#define EXPAND_CAT(a, b) CAT(a, b)
+#define FUNC(name) EXPAND_CAT(MAP_NAME, _##name)
+
+#define DEFAULT_BUCKETS 8
+#if defined(MAP_INCREMENTAL) && !defined(MAP_MIGRATE_STEP)
+#define MAP_MIGRATE_STEP 16
+#endif
+
+#ifndef HASH_FN
+/// Default hashing function for keys, mixing their bytes with sf_hash64.
+static inline uint64_t FUNC(hash)(const MAP_K key) {
+    if (sizeof(MAP_K) <= sizeof(uint64_t)) {
+        uint64_t bits = 0;
+        memcpy(&bits, &key, sizeof(MAP_K) < sizeof(bits) ? sizeof(MAP_K) : sizeof(bits));
+        return sf_hash_u64(bits);
+    }
+    return sf_hash64(&key, sizeof(MAP_K));
+}
+#define HASH_FN FUNC(hash)
+#endif
+
+/// A key/value pair with user defined types.
+#define BUCKET EXPAND_CAT(MAP_NAME, _bucket)
+typedef struct BUCKET {
+    MAP_K key;
+    MAP_V value;
+    struct BUCKET *next;
+} BUCKET;
+/// Helper function for pushing buckets.
+static inline BUCKET *FUNC(push_kv)(BUCKET *list, BUCKET *new) {
+    new->next = list;
+    return new;
+}
+
+/// A map that uses user defined types for keys/values.
+typedef struct MAP_NAME {
+    size_t bucket_count; /// Expands to reduce conflicts as the map grows.
+    size_t pair_count; /// The amount of key/value pairs currently held within the map.
+    BUCKET **buckets;
+    const sf_allocator *alloc; /// Where buckets and pairs are allocated from, NULL for the C heap.
+    #ifdef MAP_POOL
+    sf_pool *pool; /// Where pairs are allocated from, released in bulk on clear.
+    #endif
+    #ifdef MAP_INCREMENTAL
+    size_t old_bucket_count; /// Size of the table being migrated from.
+    size_t migrated; /// The amount of old buckets already moved into `buckets`.
+    BUCKET **old_buckets; /// The table being migrated from, or NULL once rehashing finishes.
+    #endif
+} MAP_NAME;
+
+#ifdef MAP_INCREMENTAL
+// Lookups only migrate when incremental, so they need a mutable map.
+#define MAP_GET_T MAP_NAME
+#else
+#define MAP_GET_T const MAP_NAME
+#endif
+
+/// Creates the map with the specified type and name, allocating from `alloc`.
+static inline MAP_NAME FUNC(new_in)(const sf_allocator *alloc) {
+    return (MAP_NAME) {
+        .bucket_count = DEFAULT_BUCKETS,
+        .pair_count = 0,
+        .buckets = sf_calloc(alloc, DEFAULT_BUCKETS, sizeof(BUCKET *)),
+        .alloc = alloc,
+        #ifdef MAP_POOL
+        .pool = sf_pool_new_in(alloc, sizeof(BUCKET)),
+        #endif
+        #ifdef MAP_INCREMENTAL
+        .old_bucket_count = 0,
+        .migrated = 0,
+        .old_buckets = NULL,
+        #endif
+    };
+}
+/// Creates the map with the specified type and name.
+static inline MAP_NAME FUNC(new)(void) {
+    return FUNC(new_in)(NULL);
+}
+/// Allocate a single pair.
+static inline BUCKET *FUNC(alloc_pair)(MAP_NAME *map) {
+    #ifdef MAP_POOL
+    return sf_pool_alloc(map->pool);
+    #else
+    return sf_alloc(map->alloc, sizeof(BUCKET));
+    #endif
+}
+/// Free a single pair.
+static inline void FUNC(free_pair)(MAP_NAME *map, BUCKET *pair) {
+    #ifdef MAP_POOL
+    sf_pool_release(map->pool, pair);
+    #else
+    sf_free(map->alloc, pair, sizeof(BUCKET));
+    #endif
+}
+/// Free every pair of a bucket array, leaving it empty.
+static inline void FUNC(free_buckets)(MAP_NAME *map, BUCKET **buckets, const size_t bucket_count) {
+    #ifdef MAP_POOL
+    // Pairs are released with the pool's slabs instead of chain by chain.
+    (void)map;
+    memset(buckets, 0, bucket_count * sizeof(BUCKET *));
+    #else
+    for (size_t i = 0; i < bucket_count; ++i) {
+        BUCKET *pair = buckets[i];
+        buckets[i] = NULL;
+
+        while (pair) {
+            BUCKET *next = pair->next;
+            FUNC(free_pair)(map, pair);
+            pair = next;
+        }
+    }
+    #endif
+}
+/// Clear a map, resetting it to the default state.
+static inline void FUNC(clear)(MAP_NAME *map) {
+    if (!map->buckets || !map->bucket_count)
+        return;
+
+    FUNC(free_buckets)(map, map->buckets, map->bucket_count);
+    #ifdef MAP_INCREMENTAL
+    if (map->old_buckets) {
+        FUNC(free_buckets)(map, map->old_buckets, map->old_bucket_count);
+        sf_free(map->alloc, map->old_buckets, map->old_bucket_count * sizeof(BUCKET *));
+        map->old_buckets = NULL;
+        map->old_bucket_count = map->migrated = 0;
+    }
+    #endif
+    #ifdef MAP_POOL
+    sf_pool_reset(map->pool);
+    #endif
+    map->pair_count = 0;
+
+    if (map->bucket_count > DEFAULT_BUCKETS) {
+        sf_free(map->alloc, map->buckets, map->bucket_count * sizeof(BUCKET *));
+        map->bucket_count = DEFAULT_BUCKETS;
+        map->buckets = sf_calloc(map->alloc, map->bucket_count, sizeof(BUCKET *));
+    }
+}
+/// Free all of a map's resources.
+static inline void FUNC(free)(MAP_NAME *map) {
+    #ifdef CLEANUP_FN
+    CLEANUP_FN(map);
+    #endif
+    FUNC(clear)(map);
+    sf_free(map->alloc, map->buckets, map->bucket_count * sizeof(BUCKET *));
+    map->buckets = NULL;
+    #ifdef MAP_POOL
+    sf_pool_free(map->pool);
+    map->pool = NULL;
+    #endif
+    map->bucket_count = 0;
+    map->pair_count = 0;
+}
+/// Index of a key's bucket. Bucket counts are powers of two, so this masks rather than divides.
+static inline size_t FUNC(index)(const MAP_K key, const size_t bucket_count) {
+    return (size_t)HASH_FN(key) & (bucket_count - 1);
+}
+/// Calculate the load of a map.
+static inline double FUNC(load)(const MAP_NAME *map, const size_t bucket_count) {
+    return (double)map->pair_count / (double)bucket_count;
+}
+/// Move every pair of an old bucket into the current table.
+static inline void FUNC(move_bucket)(MAP_NAME *map, BUCKET *pair) {
+    while (pair) {
+        BUCKET *next = pair->next;
+        const size_t hash = FUNC(index)(pair->key, map->bucket_count);
+        pair->next = map->buckets[hash];
+        map->buckets[hash] = pair;
+        pair = next;
+    }
+}
+#ifdef MAP_INCREMENTAL
+/// Returns whether an incremental rehash is still in progress.
+static inline bool FUNC(migrating)(const MAP_NAME *map) {
+    return map->old_buckets != NULL;
+}
+/// Migrate up to `steps` buckets from the old table, pass SIZE_MAX to finish the rehash.
+/// Returns whether migration is still in progress.
+static inline bool FUNC(migrate)(MAP_NAME *map, size_t steps) {
+    if (!map->old_buckets)
+        return false;
+
+    while (steps-- && map->migrated < map->old_bucket_count) {
+        FUNC(move_bucket)(map, map->old_buckets[map->migrated]);
+        map->old_buckets[map->migrated++] = NULL;
+    }
+    if (map->migrated < map->old_bucket_count)
+        return true;
+
+    sf_free(map->alloc, map->old_buckets, map->old_bucket_count * sizeof(BUCKET *));
+    map->old_buckets = NULL;
+    map->old_bucket_count = map->migrated = 0;
+    return false;
+}
+#endif
+/// Rehash a map when the load gets too high.
+/// When incremental, this only swaps in the new table and pairs are moved over by later operations.
+static inline void FUNC(rehash)(MAP_NAME *map, const size_t new_bucket_count) {
+    if (!map->buckets || !map->bucket_count)
+        return;
+    #ifdef MAP_INCREMENTAL
+    FUNC(migrate)(map, SIZE_MAX);
+    #endif
+
+    BUCKET **old_buckets = map->buckets;
+    size_t old_count = map->bucket_count;
+
+    // Allocate new bucket array
+    map->buckets = sf_calloc(map->alloc, new_bucket_count, sizeof(BUCKET *));
+    map->bucket_count = new_bucket_count;
+
+    #ifdef MAP_INCREMENTAL
+    map->old_buckets = old_buckets;
+    map->old_bucket_count = old_count;
+    map->migrated = 0;
+    #else
+    // Reinsert all pairs
+    for (size_t i = 0; i < old_count; ++i)
+        FUNC(move_bucket)(map, old_buckets[i]);
+
+    sf_free(map->alloc, old_buckets, old_count * sizeof(BUCKET *));
+    #endif
+}
+
+#define EX EXPAND_CAT(MAP_NAME, _ex)
+/// Find the pair holding `key` within a bucket array.
+static inline BUCKET *FUNC(seek)(BUCKET *const *buckets, const size_t bucket_count, MAP_K key) {
+    BUCKET *seek = buckets[FUNC(index)(key, bucket_count)];
+    while (seek) {
+        #ifndef EQUAL_FN
+        if (key == seek->key)
+            break;
+        #else
+        if (EQUAL_FN(key, seek->key))
+            break;
+        #endif
+        seek = seek->next;
+    }
+    return seek;
+}
+/// Returns the value at `key` on success.
+static inline EX FUNC(get)(MAP_GET_T *map, MAP_K key) {
+    if (!map->buckets || !map->bucket_count)
+        return EXPAND_CAT(EX, _err)();
+    #ifdef MAP_INCREMENTAL
+    FUNC(migrate)(map, MAP_MIGRATE_STEP);
+    #endif
+
+    const BUCKET *seek = FUNC(seek)(map->buckets, map->bucket_count, key);
+    #ifdef MAP_INCREMENTAL
+    if (!seek && map->old_buckets)
+        seek = FUNC(seek)(map->old_buckets, map->old_bucket_count, key);
+    #endif
+
+    if (!seek)
+        return EXPAND_CAT(EX, _err)();
+
+    return EXPAND_CAT(EX, _ok)(seek->value);
+}
+/// Unlink and free the pair holding `key` within a bucket array.
+static inline bool FUNC(unlink)(MAP_NAME *map, BUCKET **buckets, const size_t bucket_count, MAP_K key) {
+    const size_t hash = FUNC(index)(key, bucket_count);
+    BUCKET *seek = buckets[hash];
+    BUCKET *seek_p = NULL;
+    while (seek) {
+        #ifndef EQUAL_FN
+        if (key == seek->key) {
+        #else
+        if (EQUAL_FN(key, seek->key)) {
+        #endif
+            if (seek_p) seek_p->next = seek->next;
+            else buckets[hash] = seek->next;
+            #ifdef KCLEANUP
+            KCLEANUP(seek->key);
+            #endif
+            FUNC(free_pair)(map, seek);
+            map->pair_count--;
+            return true;
+        }
+        seek_p = seek;
+        seek = seek->next;
+    }
+    return false;
+}
+/// Delete a value from a map by its key.
+static inline void FUNC(delete)(MAP_NAME *map, MAP_K key) {
+    if (!map->buckets || !map->bucket_count)
+        return;
+    #ifdef MAP_INCREMENTAL
+    FUNC(migrate)(map, MAP_MIGRATE_STEP);
+    if (!FUNC(unlink)(map, map->buckets, map->bucket_count, key) && map->old_buckets)
+        FUNC(unlink)(map, map->old_buckets, map->old_bucket_count, key);
+    #else
+    FUNC(unlink)(map, map->buckets, map->bucket_count, key);
+    #endif
+}
+/// Set the value at the requested key, overriding any existing value.
+static inline void FUNC(set)(MAP_NAME *map, MAP_K key, MAP_V value) {
+    if (!map->buckets || !map->bucket_count)
+        return;
+    if (FUNC(get)(map, key).is_ok)
+        FUNC(delete)(map, key);
+
+    const size_t hash = FUNC(index)(key, map->bucket_count);
+    BUCKET *pair = FUNC(alloc_pair)(map);
+    *pair = (BUCKET) {
+        key,
+        value,
+        NULL
+    };
+    map->buckets[hash] = FUNC(push_kv)(map->buckets[hash], pair);
+    map->pair_count++;
+
+    if (FUNC(load)(map, map->bucket_count) > 0.75)
+        FUNC(rehash)(map, map->bucket_count * 2);
+}
+/// Loop over a map's key/value pairs and execute custom code with them.
+static inline void FUNC(foreach)(const MAP_NAME *map, void (*func)(void *ud, MAP_K key, MAP_V value), void *ud) {
+    if (!map->buckets || !map->bucket_count)
+        return;
+    for (size_t i = 0; i < map->bucket_count; ++i) {
+        BUCKET *p = map->buckets[i];
+        while (p) {
+            func(ud, p->key, p->value);
+            p = p->next;
+        }
+    }
+    #ifdef MAP_INCREMENTAL
+    for (size_t i = map->migrated; map->old_buckets && i < map->old_bucket_count; ++i) {
+        BUCKET *p = map->old_buckets[i];
+        while (p) {
+            func(ud, p->key, p->value);
+            p = p->next;
+        }
+    }
+    #endif
+}
+
+#undef MAP_GET_T
+#ifdef MAP_POOL
+#undef MAP_POOL
+#endif
+#ifdef MAP_INCREMENTAL
+#undef MAP_INCREMENTAL
+#undef MAP_MIGRATE_STEP
+#endif
+
+#undef MAP_NAME
+#undef MAP_K
+#undef MAP_V
+#undef HASH_FN
+#undef EQUAL_FN
+#ifdef CLEANUP_FN
+#undef CLEANUP_FN
+#endif
+#ifdef KCLEANUP
+#undef KCLEANUP
+#endif
+
+#undef CAT
+#undef EXPAND_CAT
+#undef FUNC
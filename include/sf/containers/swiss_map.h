@@ -0,0 +1,332 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "sf/alloc.h"
+#include "sf/math.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+/***********************************
+ * An open addressing alternative to map.h.
+ * Keys and values are stored inline in a flat, power of two sized table,
+ * with one control byte per slot that is probed 16 slots at a time.
+ *
+ * You should #define MAP_K & MAP_V as key/value types,
+ * #define MAP_NAME as the desired type name for the map.
+ * Optionally, #define:
+ * - uint64_t (*HASH_FN)(const MAP_K), whose low bits must be well mixed
+ * - bool (*EQUAL_FN)(const MAP_K, const MAP_K)
+ * - void (*CLEANUP_FN)(MAP_NAME *)
+ * - void (*KCLEANUP)(MAP_K)
+***********************************/
+
+#ifndef SF_SWISS_GROUP
+#define SF_SWISS_GROUP
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SF_SWISS_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SF_SWISS_NEON
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// The amount of control bytes inspected per probe.
+#define SF_SWISS_WIDTH 16
+/// Control byte of an unused slot. Used slots hold the low 7 bits of their hash.
+#define SF_SWISS_EMPTY ((uint8_t)0x80)
+
+/// Returns a bitmask of the control bytes in the group at `ctrl` equal to `byte`.
+static inline uint32_t sf_swiss_match(const uint8_t *ctrl, const uint8_t byte) {
+#if defined(SF_SWISS_SSE2)
+    const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte)));
+#elif defined(SF_SWISS_NEON)
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(byte)), vld1q_u8(bits));
+    return (uint32_t)vaddv_u8(vget_low_u8(eq)) | ((uint32_t)vaddv_u8(vget_high_u8(eq)) << 8);
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < SF_SWISS_WIDTH; ++i)
+        mask |= (uint32_t)(ctrl[i] == byte) << i;
+    return mask;
+#endif
+}
+/// Returns a bitmask of the empty slots in the group at `ctrl`.
+static inline uint32_t sf_swiss_match_empty(const uint8_t *ctrl) {
+#if defined(SF_SWISS_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+    return sf_swiss_match(ctrl, SF_SWISS_EMPTY);
+#endif
+}
+/// Index of the lowest set bit. `mask` must not be 0.
+static inline uint32_t sf_swiss_ctz(const uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (uint32_t)i;
+#else
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+#endif // SF_SWISS_GROUP
+
+#ifndef MAP_NAME
+#error Undefined typename MAP_NAME
+#define MAP_NAME sf_swiss_map
+#endif
+#ifndef MAP_K
+#error Undefined type MAP_K
+#define MAP_K void *
+#endif
+#ifndef MAP_V
+#error Undefined type MAP_V
+#define MAP_V void *
+#endif
+
+#define EXPECTED_NAME EXPAND_CAT(MAP_NAME, _ex)
+#define EXPECTED_O MAP_V
+#include "sf/containers/expected.h"
+
+#define CAT(a, b) a##b
+#define EXPAND_CAT(a, b) CAT(a, b)
+#define FUNC(name) EXPAND_CAT(MAP_NAME, _##name)
+
+#define MIN_CAPACITY SF_SWISS_WIDTH
+
+#ifndef HASH_FN
+/// Default hashing function for keys, mixing their bytes with sf_hash64.
+static inline uint64_t FUNC(hash)(const MAP_K key) {
+    if (sizeof(MAP_K) <= sizeof(uint64_t)) {
+        uint64_t bits = 0;
+        memcpy(&bits, &key, sizeof(MAP_K) < sizeof(bits) ? sizeof(MAP_K) : sizeof(bits));
+        return sf_hash_u64(bits);
+    }
+    return sf_hash64(&key, sizeof(MAP_K));
+}
+#define HASH_FN FUNC(hash)
+#endif
+
+#ifndef EQUAL_FN
+#define KEY_EQ(a, b) ((a) == (b))
+#else
+#define KEY_EQ(a, b) EQUAL_FN(a, b)
+#endif
+
+/// A key/value pair stored inline in the table.
+#define SLOT EXPAND_CAT(MAP_NAME, _slot)
+typedef struct SLOT {
+    MAP_K key;
+    MAP_V value;
+} SLOT;
+
+/// An open addressing map that uses user defined types for keys/values.
+typedef struct MAP_NAME {
+    size_t capacity; /// Always a power of two, or 0 until the first insertion.
+    size_t pair_count; /// The amount of key/value pairs currently held within the map.
+    uint8_t *ctrl; /// One control byte per slot, followed by a mirror of the first group for wrap-around probing.
+    SLOT *slots;
+    const sf_allocator *alloc; /// Where the table is allocated from, NULL for the C heap.
+} MAP_NAME;
+
+/// Creates the map with the specified type and name, allocating from `alloc`.
+/// Note that the table is lazily allocated.
+static inline MAP_NAME FUNC(new_in)(const sf_allocator *alloc) {
+    return (MAP_NAME) {
+        .capacity = 0,
+        .pair_count = 0,
+        .ctrl = NULL,
+        .slots = NULL,
+        .alloc = alloc,
+    };
+}
+/// Creates the map with the specified type and name.
+static inline MAP_NAME FUNC(new)(void) {
+    return FUNC(new_in)(NULL);
+}
+/// Size of the single allocation backing a table of `capacity` slots.
+static inline size_t FUNC(table_size)(const size_t capacity) {
+    return capacity * sizeof(SLOT) + capacity + SF_SWISS_WIDTH;
+}
+/// Home slot of a hash, the start of its probe sequence.
+static inline size_t FUNC(home)(const MAP_NAME *map, const uint64_t hash) {
+    return (size_t)(hash >> 7) & (map->capacity - 1);
+}
+/// Control byte stored for a hash.
+static inline uint8_t FUNC(h2)(const uint64_t hash) {
+    return (uint8_t)(hash & 0x7F);
+}
+/// Write a control byte, keeping the mirrored tail in sync.
+static inline void FUNC(set_ctrl)(MAP_NAME *map, const size_t index, const uint8_t byte) {
+    map->ctrl[index] = byte;
+    if (index < SF_SWISS_WIDTH)
+        map->ctrl[map->capacity + index] = byte;
+}
+/// Find the first empty slot along a hash's probe sequence.
+static inline size_t FUNC(find_empty)(const MAP_NAME *map, const uint64_t hash) {
+    const size_t mask = map->capacity - 1;
+    size_t pos = FUNC(home)(map, hash);
+    for (;;) {
+        const uint32_t empty = sf_swiss_match_empty(map->ctrl + pos);
+        if (empty)
+            return (pos + sf_swiss_ctz(empty)) & mask;
+        pos = (pos + SF_SWISS_WIDTH) & mask;
+    }
+}
+/// Find the slot holding `key`, or SIZE_MAX if it isn't present.
+static inline size_t FUNC(find)(const MAP_NAME *map, const MAP_K key, const uint64_t hash) {
+    const size_t mask = map->capacity - 1;
+    const uint8_t h2 = FUNC(h2)(hash);
+    size_t pos = FUNC(home)(map, hash);
+    for (;;) {
+        const uint8_t *group = map->ctrl + pos;
+        for (uint32_t match = sf_swiss_match(group, h2); match; match &= match - 1) {
+            const size_t i = (pos + sf_swiss_ctz(match)) & mask;
+            if (KEY_EQ(key, map->slots[i].key))
+                return i;
+        }
+        // Runs never contain an empty slot, so an empty slot ends the search.
+        if (sf_swiss_match_empty(group))
+            return SIZE_MAX;
+        pos = (pos + SF_SWISS_WIDTH) & mask;
+    }
+}
+/// Resize the table to `capacity` slots, which must be a power of two that fits every pair.
+static inline void FUNC(rehash)(MAP_NAME *map, const size_t capacity) {
+    assert(capacity >= MIN_CAPACITY && (capacity & (capacity - 1)) == 0 && "Invalid capacity.");
+    const MAP_NAME old = *map;
+
+    SLOT *slots = sf_alloc(map->alloc, FUNC(table_size)(capacity));
+    assert(slots && "Out of memory");
+    if (!slots) exit(1);
+    map->slots = slots;
+    map->ctrl = (uint8_t *)(slots + capacity);
+    map->capacity = capacity;
+    memset(map->ctrl, SF_SWISS_EMPTY, capacity + SF_SWISS_WIDTH);
+
+    for (size_t i = 0; i < old.capacity; ++i) {
+        if (old.ctrl[i] == SF_SWISS_EMPTY)
+            continue;
+        const uint64_t hash = HASH_FN(old.slots[i].key);
+        const size_t dest = FUNC(find_empty)(map, hash);
+        FUNC(set_ctrl)(map, dest, FUNC(h2)(hash));
+        map->slots[dest] = old.slots[i];
+    }
+
+    if (old.slots)
+        sf_free(map->alloc, old.slots, FUNC(table_size)(old.capacity));
+}
+/// Ensure the map can hold `count` pairs without resizing.
+static inline void FUNC(reserve)(MAP_NAME *map, const size_t count) {
+    size_t capacity = map->capacity ? map->capacity : MIN_CAPACITY;
+    while (count > capacity / 4 * 3)
+        capacity *= 2;
+    if (capacity != map->capacity)
+        FUNC(rehash)(map, capacity);
+}
+/// Clear a map, keeping its table allocated for reuse.
+static inline void FUNC(clear)(MAP_NAME *map) {
+    if (!map->ctrl)
+        return;
+    memset(map->ctrl, SF_SWISS_EMPTY, map->capacity + SF_SWISS_WIDTH);
+    map->pair_count = 0;
+}
+/// Free all of a map's resources.
+static inline void FUNC(free)(MAP_NAME *map) {
+    #ifdef CLEANUP_FN
+    CLEANUP_FN(map);
+    #endif
+    if (map->slots)
+        sf_free(map->alloc, map->slots, FUNC(table_size)(map->capacity));
+    *map = FUNC(new_in)(map->alloc);
+}
+
+#define EX EXPAND_CAT(MAP_NAME, _ex)
+/// Returns the value at `key` on success.
+static inline EX FUNC(get)(const MAP_NAME *map, MAP_K key) {
+    if (!map->pair_count)
+        return EXPAND_CAT(EX, _err)();
+    const size_t i = FUNC(find)(map, key, HASH_FN(key));
+    if (i == SIZE_MAX)
+        return EXPAND_CAT(EX, _err)();
+    return EXPAND_CAT(EX, _ok)(map->slots[i].value);
+}
+/// Delete a value from a map by its key.
+/// Later slots of the probe run are shifted back into the hole, so no tombstones are left behind.
+static inline void FUNC(delete)(MAP_NAME *map, MAP_K key) {
+    if (!map->pair_count)
+        return;
+    size_t hole = FUNC(find)(map, key, HASH_FN(key));
+    if (hole == SIZE_MAX)
+        return;
+    #ifdef KCLEANUP
+    KCLEANUP(map->slots[hole].key);
+    #endif
+
+    const size_t mask = map->capacity - 1;
+    for (size_t i = (hole + 1) & mask; map->ctrl[i] != SF_SWISS_EMPTY; i = (i + 1) & mask) {
+        // A pair may only move back if the hole doesn't come before its home slot.
+        const size_t home = FUNC(home)(map, HASH_FN(map->slots[i].key));
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            map->slots[hole] = map->slots[i];
+            FUNC(set_ctrl)(map, hole, map->ctrl[i]);
+            hole = i;
+        }
+    }
+    FUNC(set_ctrl)(map, hole, SF_SWISS_EMPTY);
+    map->pair_count--;
+}
+/// Set the value at the requested key, overriding any existing value.
+static inline void FUNC(set)(MAP_NAME *map, MAP_K key, MAP_V value) {
+    const uint64_t hash = HASH_FN(key);
+    if (map->pair_count) {
+        const size_t i = FUNC(find)(map, key, hash);
+        if (i != SIZE_MAX) {
+            #ifdef KCLEANUP
+            KCLEANUP(map->slots[i].key);
+            #endif
+            map->slots[i] = (SLOT) { key, value };
+            return;
+        }
+    }
+
+    FUNC(reserve)(map, map->pair_count + 1);
+    const size_t i = FUNC(find_empty)(map, hash);
+    FUNC(set_ctrl)(map, i, FUNC(h2)(hash));
+    map->slots[i] = (SLOT) { key, value };
+    map->pair_count++;
+}
+/// Loop over a map's key/value pairs and execute custom code with them.
+static inline void FUNC(foreach)(const MAP_NAME *map, void (*func)(void *ud, MAP_K key, MAP_V value), void *ud) {
+    for (size_t i = 0; i < map->capacity; ++i)
+        if (map->ctrl[i] != SF_SWISS_EMPTY)
+            func(ud, map->slots[i].key, map->slots[i].value);
+}
+
+#undef EX
+#undef SLOT
+#undef KEY_EQ
+#undef MIN_CAPACITY
+
+#undef MAP_NAME
+#undef MAP_K
+#undef MAP_V
+#undef HASH_FN
+#undef EQUAL_FN
+#ifdef CLEANUP_FN
+#undef CLEANUP_FN
+#endif
+#ifdef KCLEANUP
+#undef KCLEANUP
+#endif
+
+#undef CAT
+#undef EXPAND_CAT
+#undef FUNC
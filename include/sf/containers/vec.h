@@ -1,206 +1,371 @@
-#include <assert.h>
-#include <stdint.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#pragma GCC diagnostic ignored "-Wunused-function"
-
-/***********************************
- * You should #define VEC_T as a value type,
- * #define VEC_NAME as the desired type name for the vec.
- * Optionally, define
- * - void (*CLEANUP_FN)(MAP_NAME *)
- * - type VSIZE_T
-***********************************/
-
-#ifndef VEC_NAME
-#error Undefined typename VEC_NAME
-#define VEC_NAME sf_vec
-#endif
-#ifndef VEC_T
-#error Undefined type VEC_T
-#define VEC_T void *
-#endif
-
-#ifdef VSIZE_T
-#ifndef VSIZE_MAX
-#error Undefined size VSIZE_MAX
-#endif
-#endif
-
-#ifndef VSIZE_T
-#define VSIZE_T size_t
-#define VSIZE_MAX SIZE_MAX
-#endif
-
-#define CAT(a, b) a##b
-#define EXPAND_CAT(a, b) CAT(a, b)
-#define FUNC(name) EXPAND_CAT(VEC_NAME, _##name)
-
-#define INITIAL_SIZE 4
-
-/// A generic dynamic vec. Be aware that data may move around the heap,
-/// and the size of the vec may not always be equal to the amount of
-/// elements in it.
-typedef struct VEC_NAME {
-    VSIZE_T slots; /// The amount of currently available slots.
-    VSIZE_T count; /// The amount of currently used slots.
-    VEC_T *data;
-    VEC_T *top;
-} VEC_NAME;
-
-/// Create a new vec.
-/// Note that vecs are lazily allocated.
-static inline VEC_NAME FUNC(new)(void) {
-    return (VEC_NAME) {
-        .slots = 0,
-        .count = 0,
-        .data = NULL,
-        .top = NULL,
-    };
-}
-/// Allocate a new vec.
-/// Differs from new in that it explicitly allocates `count` elements.
-/// Initializes all elements to `def`.
-static inline VEC_NAME FUNC(alloc)(VSIZE_T count, VEC_T def) {
-    VEC_NAME v = (VEC_NAME) {
-        .slots = count,
-        .count = count,
-        .data = malloc(sizeof(VEC_T) * count),
-        .top = NULL,
-    };
-
-    for (VSIZE_T i = 0; i < count; ++i)
-        memcpy(v.data + i, &def, sizeof(VEC_T));
-    v.top = v.data + count - 1;
-
-    return v;
-}
-/// Clean up after a vec's resources.
-static inline void FUNC(free)(VEC_NAME *vec) {
-    #ifdef CLEANUP_FN
-    CLEANUP_FN(vec);
-    #endif
-    free(vec->data);
-    vec->slots = 0;
-    vec->count = 0;
-    vec->data = NULL;
-    vec->top = NULL;
-}
-/// Push an element to the end of a vec.
-static inline void FUNC(push)(VEC_NAME *vec, const VEC_T value) {
-    if (!vec->data || !vec->slots) {
-        vec->data = calloc(INITIAL_SIZE, sizeof(VEC_T));
-        vec->slots = INITIAL_SIZE;
-    }
-
-    if (vec->count == vec->slots) { // Vector is full, double size.
-        VEC_T *n = realloc(vec->data, (vec->slots *= 2) * sizeof(VEC_T));
-        assert(n && "Out of memory");
-        if (!n) exit(1);
-        vec->data = n;
-    }
-
-    memcpy(vec->data + vec->count, &value, sizeof(VEC_T));
-    vec->count++;
-
-    vec->top = vec->count == 0 ? vec->data : vec->data + vec->count - 1;
-}
-/// Append elements to the end of a vec.
-static inline void FUNC(append)(VEC_NAME *vec, const VEC_T *values, VSIZE_T size) {
-    for (VSIZE_T i = 0; i < size; ++i)
-        FUNC(push)(vec, values[i]);
-}
-/// Pop an element from the end of a vec.
-static inline VEC_T FUNC(pop)(VEC_NAME *vec) {
-    assert(vec->count > 0 && "Vec is empty.");
-    if (vec->count == 0)
-        return (VEC_T){0};
-
-    vec->count--;
-    VEC_T data = *(vec->data + vec->count);
-    if (vec->slots > INITIAL_SIZE && vec->count <= vec->slots / 4) { // Reduce size if possible
-        VEC_T *n = realloc(vec->data, (vec->slots /= 2) * sizeof(VEC_T));
-        assert(n && "Out of memory");
-        if (!n) exit(1);
-        vec->data = n;
-    }
-
-    vec->top = vec->count == 0 ? vec->data : vec->data + vec->count - 1;
-    return data;
-}
-/// Insert an element at a specified index.
-static inline void FUNC(insert)(VEC_NAME *vec, const VSIZE_T index, const VEC_T value) {
-    assert(index <= vec->count && "Index out of bounds of vec.");
-    if (index > vec->count)
-        return;
-
-    if (!vec->data || !vec->slots) {
-        vec->data = calloc(INITIAL_SIZE, sizeof(VEC_T));
-        assert(vec->data && "Out of memory");
-        if (!vec->data) exit(1);
-        vec->slots = INITIAL_SIZE;
-    }
-    if (index == vec->count) {
-        FUNC(push)(vec, value);
-        return;
-    }
-
-    if (vec->count == vec->slots) {
-        VSIZE_T new_slots = vec->slots * 2;
-        VEC_T *n = realloc(vec->data, new_slots * sizeof(VEC_T));
-        assert(n && "Out of memory");
-        if (!n) exit(1);
-        vec->data = n;
-        vec->slots = new_slots;
-    }
-
-    memmove(
-        vec->data + index + 1,
-        vec->data + index,
-        sizeof(VEC_T) * (size_t)(vec->count - index)
-    );
-    memcpy(vec->data + index, &value, sizeof(VEC_T));
-    vec->count++;
-
-    vec->top = vec->count == 0 ? vec->data : vec->data + vec->count - 1;
-}
-/// Set the value at a specified index.
-static inline void FUNC(set)(const VEC_NAME *vec, const VSIZE_T index, VEC_T data) {
-    assert(index < vec->count && "Index out of bounds of vec.");
-    if (index >= vec->count)
-        return;
-    vec->data[index] = data;
-}
-/// Get the value at a specified index.
-static inline VEC_T FUNC(get)(const VEC_NAME *vec, const VSIZE_T index) {
-    assert(index < vec->count && "Index out of bounds of vec.");
-    if (index >= vec->count)
-        return (VEC_T){0};
-    return *(vec->data + index);
-}
-/// Delete the value at the specified index.
-static inline void FUNC(delete)(VEC_NAME *vec, const VSIZE_T index) {
-    assert(index < vec->count && "Index out of bounds of vec.");
-    vec->count--;
-    if (vec->count - index > 0)
-        memmove(vec->data + index, vec->data + (index + 1), (vec->count - index) * (sizeof(VEC_T)));
-    if (vec->slots > INITIAL_SIZE && vec->count <= vec->slots / 2) // Reduce size if possible
-        vec->data = realloc(vec->data, (vec->slots /= 2) * sizeof(VEC_T));
-    vec->top = vec->count == 0 ? vec->data : vec->data + vec->count - 1;
-}
-
-#undef VEC_NAME
-#undef VEC_T
-
-#undef CAT
-#undef EXPAND_CAT
-#undef FUNC
-#ifdef CLEANUP_FN
-#undef CLEANUP_FN
-#endif
-#ifdef VSIZE_T
-#undef VSIZE_T
-#undef VSIZE_MAX
-#endif
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sf/alloc.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+/***********************************
+ * You should #define VEC_T as a value type,
+ * #define VEC_NAME as the desired type name for the vec.
+ * Optionally, define
+ * - void (*CLEANUP_FN)(MAP_NAME *)
+ * - type VSIZE_T
+ * - VEC_NO_SHRINK to keep memory when elements are removed, until shrink_to_fit
+ * - VEC_INLINE as an amount of elements stored inside the vec before it allocates.
+ *   Inline elements have no stable address, so such vecs have no `top` and their
+ *   `data` is NULL until they spill to the heap, use FUNC(items) to reach the elements.
+***********************************/
+
+#ifndef VEC_NAME
+#error Undefined typename VEC_NAME
+#define VEC_NAME sf_vec
+#endif
+#ifndef VEC_T
+#error Undefined type VEC_T
+#define VEC_T void *
+#endif
+
+#ifdef VSIZE_T
+#ifndef VSIZE_MAX
+#error Undefined size VSIZE_MAX
+#endif
+#endif
+
+#ifndef VSIZE_T
+#define VSIZE_T size_t
+#define VSIZE_MAX SIZE_MAX
+#endif
+
+#define CAT(a, b) a##b
+#define EXPAND_CAT(a, b) CAT(a, b)
+#define FUNC(name) EXPAND_CAT(VEC_NAME, _##name)
+
+#define INITIAL_SIZE 4
+
+#ifdef VEC_INLINE
+#define VEC_MIN_SLOTS (VEC_INLINE > INITIAL_SIZE ? VEC_INLINE : INITIAL_SIZE)
+#else
+#define VEC_MIN_SLOTS INITIAL_SIZE
+#endif
+
+/// A generic dynamic vec. Be aware that data may move around the heap,
+/// and the size of the vec may not always be equal to the amount of
+/// elements in it.
+typedef struct VEC_NAME {
+    VSIZE_T slots; /// The amount of currently available slots.
+    VSIZE_T count; /// The amount of currently used slots.
+    VSIZE_T reserved; /// Slots kept when elements are removed, as last requested by reserve.
+    VEC_T *data;
+#ifdef VEC_INLINE
+    const sf_allocator *alloc; /// Where `data` is allocated from, NULL for the C heap.
+    VEC_T inline_data[VEC_INLINE]; /// The elements while `data` is NULL.
+#else
+    VEC_T *top;
+    const sf_allocator *alloc; /// Where `data` is allocated from, NULL for the C heap.
+#endif
+} VEC_NAME;
+
+/// Create a new vec.
+/// Note that vecs are lazily allocated.
+static inline VEC_NAME FUNC(new)(void) {
+#ifdef VEC_INLINE
+    return (VEC_NAME) {
+        .slots = VEC_INLINE,
+        .count = 0,
+        .reserved = 0,
+        .data = NULL,
+        .alloc = NULL,
+    };
+#else
+    return (VEC_NAME) {
+        .slots = 0,
+        .count = 0,
+        .reserved = 0,
+        .data = NULL,
+        .top = NULL,
+        .alloc = NULL,
+    };
+#endif
+}
+/// Create a new vec that allocates from `alloc`.
+static inline VEC_NAME FUNC(new_in)(const sf_allocator *alloc) {
+    VEC_NAME v = FUNC(new)();
+    v.alloc = alloc;
+    return v;
+}
+/// Clean up after a vec's resources.
+static inline void FUNC(free)(VEC_NAME *vec) {
+    #ifdef CLEANUP_FN
+    CLEANUP_FN(vec);
+    #endif
+    if (vec->data)
+        sf_free(vec->alloc, vec->data, sizeof(VEC_T) * (size_t)vec->slots);
+    const sf_allocator *alloc = vec->alloc;
+    *vec = FUNC(new_in)(alloc);
+}
+/// The elements, wherever they are stored.
+static inline VEC_T *FUNC(items)(const VEC_NAME *vec) {
+#ifdef VEC_INLINE
+    return vec->data ? vec->data : (VEC_T *)vec->inline_data;
+#else
+    return vec->data;
+#endif
+}
+/// Point `top` at the last element.
+static inline void FUNC(update_top)(VEC_NAME *vec) {
+#ifdef VEC_INLINE
+    (void)vec;
+#else
+    vec->top = vec->count == 0 ? vec->data : vec->data + vec->count - 1;
+#endif
+}
+/// Move the elements to an allocation of exactly `slots`, at least `count`. Returns false when out of memory.
+static inline bool FUNC(set_slots)(VEC_NAME *vec, const VSIZE_T slots) {
+#ifdef VEC_INLINE
+    if (slots <= VEC_INLINE) {
+        if (vec->data) {
+            memcpy(vec->inline_data, vec->data, sizeof(VEC_T) * (size_t)vec->count);
+            sf_free(vec->alloc, vec->data, sizeof(VEC_T) * (size_t)vec->slots);
+            vec->data = NULL;
+        }
+        vec->slots = VEC_INLINE;
+        return true;
+    }
+    if (!vec->data) {
+        const size_t bytes = (size_t)slots * sizeof(VEC_T);
+        if (bytes / sizeof(VEC_T) != (size_t)slots)
+            return false;
+        VEC_T *data = sf_alloc(vec->alloc, bytes);
+        if (!data)
+            return false;
+        memcpy(data, vec->inline_data, sizeof(VEC_T) * (size_t)vec->count);
+        vec->data = data;
+        vec->slots = slots;
+        return true;
+    }
+#endif
+    const size_t bytes = (size_t)slots * sizeof(VEC_T);
+    if (bytes / sizeof(VEC_T) != (size_t)slots)
+        return false;
+    VEC_T *data = vec->data
+        ? sf_realloc(vec->alloc, vec->data, (size_t)vec->slots * sizeof(VEC_T), bytes)
+        : sf_alloc(vec->alloc, bytes);
+    if (!data)
+        return false;
+    vec->data = data;
+    vec->slots = slots;
+    FUNC(update_top)(vec);
+    return true;
+}
+/// Make room for at least `needed` elements, doubling the slots so repeated growth is amortized O(1).
+static inline bool FUNC(grow)(VEC_NAME *vec, const VSIZE_T needed) {
+    if (needed <= vec->slots)
+        return true;
+    VSIZE_T slots = vec->slots < VEC_MIN_SLOTS ? VEC_MIN_SLOTS : vec->slots;
+    while (slots < needed)
+        slots = slots > VSIZE_MAX / 2 ? VSIZE_MAX : slots * 2;
+    return FUNC(set_slots)(vec, slots);
+}
+/// Give memory back once at most a quarter of the slots are used. Halving leaves room for the count to
+/// double again, so a vec hovering around one size doesn't reallocate on every push and removal.
+static inline void FUNC(shrink_if_sparse)(VEC_NAME *vec) {
+#ifndef VEC_NO_SHRINK
+    if (vec->count > vec->slots / 4)
+        return;
+    VSIZE_T slots = vec->slots;
+    while (slots > VEC_MIN_SLOTS && vec->count <= slots / 4 && slots / 2 >= vec->reserved)
+        slots /= 2;
+    // Failing to shrink just keeps the larger allocation.
+    if (slots != vec->slots)
+        FUNC(set_slots)(vec, slots);
+#else
+    (void)vec;
+#endif
+}
+/// Allocate a new vec.
+/// Differs from new in that it explicitly allocates `count` elements.
+/// Initializes all elements to `def`.
+static inline VEC_NAME FUNC(alloc)(VSIZE_T count, VEC_T def) {
+    VEC_NAME v = FUNC(new)();
+    if (count > v.slots) {
+        const bool allocated = FUNC(set_slots)(&v, count);
+        assert(allocated && "Out of memory");
+        if (!allocated) exit(1);
+    }
+    VEC_T *items = FUNC(items)(&v);
+    for (VSIZE_T i = 0; i < count; ++i)
+        memcpy(items + i, &def, sizeof(VEC_T));
+    v.count = count;
+    FUNC(update_top)(&v);
+
+    return v;
+}
+/// Make room for `additional` more elements, which removing elements won't give back until shrink_to_fit.
+/// Returns false when out of memory.
+static inline bool FUNC(reserve)(VEC_NAME *vec, const VSIZE_T additional) {
+    if (additional > VSIZE_MAX - vec->count)
+        return false;
+    const VSIZE_T needed = vec->count + additional;
+    if (needed > vec->slots && !FUNC(set_slots)(vec, needed))
+        return false;
+    vec->reserved = needed;
+    return true;
+}
+/// Set the amount of elements, initializing new ones to `def`. Returns false when out of memory.
+static inline bool FUNC(resize)(VEC_NAME *vec, const VSIZE_T count, const VEC_T def) {
+    if (!FUNC(grow)(vec, count))
+        return false;
+    VEC_T *items = FUNC(items)(vec);
+    for (VSIZE_T i = vec->count; i < count; ++i)
+        memcpy(items + i, &def, sizeof(VEC_T));
+    vec->count = count;
+    FUNC(shrink_if_sparse)(vec);
+    FUNC(update_top)(vec);
+    return true;
+}
+/// Shrink the allocation to exactly the elements in use, and forget any reserve.
+static inline void FUNC(shrink_to_fit)(VEC_NAME *vec) {
+    vec->reserved = 0;
+    if (vec->count == vec->slots || !vec->data)
+        return;
+#ifdef VEC_INLINE
+    if (vec->count <= VEC_INLINE) {
+        FUNC(set_slots)(vec, vec->count);
+        return;
+    }
+#endif
+    if (vec->count == 0) {
+        sf_free(vec->alloc, vec->data, (size_t)vec->slots * sizeof(VEC_T));
+        vec->data = NULL;
+        vec->slots = 0;
+        FUNC(update_top)(vec);
+        return;
+    }
+    FUNC(set_slots)(vec, vec->count);
+}
+/// Push an element to the end of a vec.
+static inline void FUNC(push)(VEC_NAME *vec, const VEC_T value) {
+    if (vec->count == vec->slots) {
+        const bool grown = FUNC(grow)(vec, vec->count + 1);
+        assert(grown && "Out of memory");
+        if (!grown) exit(1);
+    }
+
+    memcpy(FUNC(items)(vec) + vec->count, &value, sizeof(VEC_T));
+    vec->count++;
+
+    FUNC(update_top)(vec);
+}
+/// Insert `size` elements at a specified index with one copy. `values` must not point into the vec.
+/// Returns false when out of memory.
+static inline bool FUNC(insert_range)(VEC_NAME *vec, const VSIZE_T index, const VEC_T *values, const VSIZE_T size) {
+    assert(index <= vec->count && "Index out of bounds of vec.");
+    if (index > vec->count || size > VSIZE_MAX - vec->count)
+        return false;
+    if (size == 0)
+        return true;
+    if (!FUNC(grow)(vec, vec->count + size))
+        return false;
+    VEC_T *items = FUNC(items)(vec);
+    memmove(items + index + size, items + index, sizeof(VEC_T) * (size_t)(vec->count - index));
+    memcpy(items + index, values, sizeof(VEC_T) * (size_t)size);
+    vec->count += size;
+    FUNC(update_top)(vec);
+    return true;
+}
+/// Append elements to the end of a vec with one copy. `values` must not point into the vec.
+/// Returns false when out of memory.
+static inline bool FUNC(append)(VEC_NAME *vec, const VEC_T *values, const VSIZE_T size) {
+    return FUNC(insert_range)(vec, vec->count, values, size);
+}
+/// Pop an element from the end of a vec.
+static inline VEC_T FUNC(pop)(VEC_NAME *vec) {
+    assert(vec->count > 0 && "Vec is empty.");
+    if (vec->count == 0)
+        return (VEC_T){0};
+
+    vec->count--;
+    VEC_T data = FUNC(items)(vec)[vec->count];
+    FUNC(shrink_if_sparse)(vec);
+
+    FUNC(update_top)(vec);
+    return data;
+}
+/// Insert an element at a specified index.
+static inline void FUNC(insert)(VEC_NAME *vec, const VSIZE_T index, const VEC_T value) {
+    assert(index <= vec->count && "Index out of bounds of vec.");
+    if (index > vec->count)
+        return;
+
+    if (vec->count == vec->slots) {
+        const bool grown = FUNC(grow)(vec, vec->count + 1);
+        assert(grown && "Out of memory");
+        if (!grown) exit(1);
+    }
+
+    VEC_T *items = FUNC(items)(vec);
+    memmove(
+        items + index + 1,
+        items + index,
+        sizeof(VEC_T) * (size_t)(vec->count - index)
+    );
+    memcpy(items + index, &value, sizeof(VEC_T));
+    vec->count++;
+
+    FUNC(update_top)(vec);
+}
+/// Set the value at a specified index.
+static inline void FUNC(set)(const VEC_NAME *vec, const VSIZE_T index, VEC_T data) {
+    assert(index < vec->count && "Index out of bounds of vec.");
+    if (index >= vec->count)
+        return;
+    FUNC(items)(vec)[index] = data;
+}
+/// Get the value at a specified index.
+static inline VEC_T FUNC(get)(const VEC_NAME *vec, const VSIZE_T index) {
+    assert(index < vec->count && "Index out of bounds of vec.");
+    if (index >= vec->count)
+        return (VEC_T){0};
+    return FUNC(items)(vec)[index];
+}
+/// Delete `size` elements starting at the specified index, with one move of the ones after them.
+static inline void FUNC(delete_range)(VEC_NAME *vec, const VSIZE_T index, const VSIZE_T size) {
+    assert(index <= vec->count && size <= vec->count - index && "Range out of bounds of vec.");
+    if (index > vec->count || size > vec->count - index)
+        return;
+    VEC_T *items = FUNC(items)(vec);
+    memmove(items + index, items + index + size, sizeof(VEC_T) * (size_t)(vec->count - index - size));
+    vec->count -= size;
+    FUNC(shrink_if_sparse)(vec);
+    FUNC(update_top)(vec);
+}
+/// Delete the value at the specified index.
+static inline void FUNC(delete)(VEC_NAME *vec, const VSIZE_T index) {
+    assert(index < vec->count && "Index out of bounds of vec.");
+    FUNC(delete_range)(vec, index, 1);
+}
+
+#undef VEC_NAME
+#undef VEC_T
+#ifdef VEC_NO_SHRINK
+#undef VEC_NO_SHRINK
+#endif
+#ifdef VEC_INLINE
+#undef VEC_INLINE
+#endif
+#undef VEC_MIN_SLOTS
+
+#undef CAT
+#undef EXPAND_CAT
+#undef FUNC
+#ifdef CLEANUP_FN
+#undef CLEANUP_FN
+#endif
+#ifdef VSIZE_T
+#undef VSIZE_T
+#undef VSIZE_MAX
+#endif
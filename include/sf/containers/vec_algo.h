@@ -0,0 +1,346 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sf/alloc.h"
+#include "sf/thread.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+/***********************************
+ * Sorting and searching for a vec, include after the vec itself.
+ * You should #define VEC_NAME & VEC_T the same as for the vec.
+ * Optionally, define
+ * - bool (*LESS_FN)(const VEC_T, const VEC_T), defaulting to `<`
+ * - VEC_RADIX_KEY(x) as an unsigned integer ordered like the elements, to generate radix_sort.
+ *   Use x itself for unsigned integers, or sf_radix_i32/i64/f32/f64 for signed and floating point ones.
+***********************************/
+
+#ifndef VEC_NAME
+#error Undefined typename VEC_NAME
+#define VEC_NAME sf_vec
+#endif
+#ifndef VEC_T
+#error Undefined type VEC_T
+#define VEC_T void *
+#endif
+
+#ifndef SF_VEC_ALGO_KEYS
+#define SF_VEC_ALGO_KEYS
+/// Radix key of a signed integer, flipping the sign bit so negatives order first.
+static inline uint32_t sf_radix_i32(const int32_t value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+/// Radix key of a signed integer, flipping the sign bit so negatives order first.
+static inline uint64_t sf_radix_i64(const int64_t value) {
+    return (uint64_t)value ^ 0x8000000000000000u;
+}
+/// Radix key of a float, flipping every bit of negatives so they order first and in reverse.
+static inline uint32_t sf_radix_f32(const float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+/// Radix key of a double, flipping every bit of negatives so they order first and in reverse.
+static inline uint64_t sf_radix_f64(const double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits & 0x8000000000000000u ? ~bits : bits | 0x8000000000000000u;
+}
+#endif // SF_VEC_ALGO_KEYS
+
+#define CAT(a, b) a##b
+#define EXPAND_CAT(a, b) CAT(a, b)
+#define FUNC(name) EXPAND_CAT(VEC_NAME, _##name)
+
+/// Ranges this short are insertion sorted.
+#define SORT_SMALL 16
+/// Vecs shorter than this are sorted on the calling thread by sort_parallel.
+#define SORT_PARALLEL_MIN 65536
+/// The most threads sort_parallel runs on.
+#define SORT_MAX_THREADS 64
+
+#ifndef LESS_FN
+/// Default ordering of elements.
+static inline bool FUNC(less)(const VEC_T a, const VEC_T b) {
+    return a < b;
+}
+#define LESS_FN FUNC(less)
+#endif
+
+static inline void FUNC(swap)(VEC_T *a, VEC_T *b) {
+    const VEC_T t = *a;
+    *a = *b;
+    *b = t;
+}
+static inline void FUNC(insertion_sort)(VEC_T *items, const size_t count) {
+    for (size_t i = 1; i < count; ++i) {
+        const VEC_T value = items[i];
+        size_t j = i;
+        for (; j > 0 && LESS_FN(value, items[j - 1]); --j)
+            items[j] = items[j - 1];
+        items[j] = value;
+    }
+}
+static inline void FUNC(sift_down)(VEC_T *items, size_t root, const size_t count) {
+    for (size_t child; (child = root * 2 + 1) < count; root = child) {
+        if (child + 1 < count && LESS_FN(items[child], items[child + 1]))
+            ++child;
+        if (!LESS_FN(items[root], items[child]))
+            return;
+        FUNC(swap)(items + root, items + child);
+    }
+}
+static inline void FUNC(heap_sort)(VEC_T *items, const size_t count) {
+    for (size_t i = count / 2; i-- > 0;)
+        FUNC(sift_down)(items, i, count);
+    for (size_t end = count; end-- > 1;) {
+        FUNC(swap)(items, items + end);
+        FUNC(sift_down)(items, 0, end);
+    }
+}
+/// Quicksort with a median of three pivot, switching to heapsort past `depth` levels
+/// so adversarial inputs stay O(n log n). Recurses into the smaller side only.
+static void FUNC(introsort)(VEC_T *items, size_t count, unsigned depth) {
+    while (count > SORT_SMALL) {
+        if (depth-- == 0) {
+            FUNC(heap_sort)(items, count);
+            return;
+        }
+        // Ordering the first, middle and last elements makes both scans below stop in bounds.
+        const size_t mid = count / 2;
+        if (LESS_FN(items[mid], items[0]))
+            FUNC(swap)(items + mid, items);
+        if (LESS_FN(items[count - 1], items[mid])) {
+            FUNC(swap)(items + count - 1, items + mid);
+            if (LESS_FN(items[mid], items[0]))
+                FUNC(swap)(items + mid, items);
+        }
+        const VEC_T pivot = items[mid];
+        size_t i = 0, j = count - 1;
+        for (;;) {
+            while (LESS_FN(items[i], pivot))
+                ++i;
+            while (LESS_FN(pivot, items[j]))
+                --j;
+            if (i >= j)
+                break;
+            FUNC(swap)(items + i++, items + j--);
+        }
+        const size_t split = j + 1;
+        if (split < count - split) {
+            FUNC(introsort)(items, split, depth);
+            items += split;
+            count -= split;
+        } else {
+            FUNC(introsort)(items + split, count - split, depth);
+            count = split;
+        }
+    }
+    FUNC(insertion_sort)(items, count);
+}
+/// Sort `count` elements in place. Not stable.
+static inline void FUNC(sort_items)(VEC_T *items, const size_t count) {
+    unsigned depth = 0;
+    for (size_t n = count; n > 1; n >>= 1)
+        depth += 2;
+    FUNC(introsort)(items, count, depth);
+}
+/// Sort a vec in place with an inlined comparison. Not stable.
+static inline void FUNC(sort)(VEC_NAME *vec) {
+    FUNC(sort_items)(FUNC(items)(vec), (size_t)vec->count);
+}
+
+/// Index of the first element not less than `value` in a sorted vec, or count if there is none.
+/// The loop has a fixed trip count and no data dependent branch, so it doesn't mispredict.
+static inline size_t FUNC(lower_bound)(const VEC_NAME *vec, const VEC_T value) {
+    const VEC_T *items = FUNC(items)(vec), *base = items;
+    size_t n = (size_t)vec->count;
+    if (n == 0)
+        return 0;
+    while (n > 1) {
+        const size_t half = n / 2;
+        base = LESS_FN(base[half], value) ? base + half : base;
+        n -= half;
+    }
+    return (size_t)(base - items) + LESS_FN(*base, value);
+}
+/// Index of the first element greater than `value` in a sorted vec, or count if there is none.
+static inline size_t FUNC(upper_bound)(const VEC_NAME *vec, const VEC_T value) {
+    const VEC_T *items = FUNC(items)(vec), *base = items;
+    size_t n = (size_t)vec->count;
+    if (n == 0)
+        return 0;
+    while (n > 1) {
+        const size_t half = n / 2;
+        base = LESS_FN(value, base[half]) ? base : base + half;
+        n -= half;
+    }
+    return (size_t)(base - items) + !LESS_FN(value, *base);
+}
+
+#ifdef VEC_RADIX_KEY
+/// Stable LSD radix sort on VEC_RADIX_KEY, one counting pass for every key byte and one scatter
+/// for every byte that differs between elements. Returns false when out of memory for the scratch copy.
+static inline bool FUNC(radix_sort)(VEC_NAME *vec) {
+    VEC_T *items = FUNC(items)(vec);
+    const size_t count = (size_t)vec->count;
+    const size_t key_bytes = sizeof(VEC_RADIX_KEY(items[0]));
+    assert(key_bytes <= sizeof(uint64_t) && "Radix keys are at most 64 bits.");
+    if (count < 2)
+        return true;
+    VEC_T *scratch = sf_alloc(vec->alloc, count * sizeof(VEC_T));
+    if (!scratch)
+        return false;
+
+    size_t counts[sizeof(uint64_t)][256];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t key = (uint64_t)VEC_RADIX_KEY(items[i]);
+        for (size_t b = 0; b < key_bytes; ++b)
+            ++counts[b][(key >> (b * 8)) & 0xFF];
+    }
+    VEC_T *src = items, *dst = scratch;
+    const uint64_t first = (uint64_t)VEC_RADIX_KEY(items[0]);
+    for (size_t b = 0; b < key_bytes; ++b) {
+        size_t *offsets = counts[b];
+        // A byte every element shares doesn't reorder anything.
+        if (offsets[(first >> (b * 8)) & 0xFF] == count)
+            continue;
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; ++d) {
+            const size_t n = offsets[d];
+            offsets[d] = offset;
+            offset += n;
+        }
+        for (size_t i = 0; i < count; ++i)
+            dst[offsets[((uint64_t)VEC_RADIX_KEY(src[i]) >> (b * 8)) & 0xFF]++] = src[i];
+        VEC_T *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != items)
+        memcpy(items, src, count * sizeof(VEC_T));
+    sf_free(vec->alloc, scratch, count * sizeof(VEC_T));
+    return true;
+}
+#endif // VEC_RADIX_KEY
+
+/// A slice of sort_parallel's work: sorting [lo, hi) of `src`, or merging [lo, mid) and [mid, hi)
+/// of `src` into `dst`, for the outputs from `first` to `last`.
+typedef struct {
+    VEC_T *src, *dst;
+    size_t lo, mid, hi;
+    size_t first, last;
+} FUNC(sort_job);
+
+/// How many of the first `k` merged elements come from `a`, the rest coming from `b`.
+/// Ties go to `a`, which keeps merges stable.
+static inline size_t FUNC(merge_split)(const VEC_T *a, const size_t na, const VEC_T *b, const size_t nb, const size_t k) {
+    size_t lo = k > nb ? k - nb : 0, hi = k < na ? k : na;
+    while (lo < hi) {
+        const size_t i = lo + (hi - lo) / 2;
+        if (!LESS_FN(b[k - i - 1], a[i]))
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+static void FUNC(sort_task)(void *ud) {
+    FUNC(sort_job) *job = ud;
+    FUNC(sort_items)(job->src + job->lo, job->hi - job->lo);
+}
+static void FUNC(merge_task)(void *ud) {
+    FUNC(sort_job) *job = ud;
+    const VEC_T *a = job->src + job->lo, *b = job->src + job->mid;
+    const size_t na = job->mid - job->lo, nb = job->hi - job->mid;
+    size_t i = FUNC(merge_split)(a, na, b, nb, job->first), j = job->first - i;
+    const size_t ai = FUNC(merge_split)(a, na, b, nb, job->last), bj = job->last - ai;
+    VEC_T *out = job->dst + job->lo + job->first;
+    while (i < ai && j < bj)
+        *out++ = LESS_FN(b[j], a[i]) ? b[j++] : a[i++];
+    while (i < ai)
+        *out++ = a[i++];
+    while (j < bj)
+        *out++ = b[j++];
+}
+/// Run every job, on started threads and the calling one.
+static inline void FUNC(run_jobs)(void (*task)(void *), FUNC(sort_job) *jobs, const size_t count) {
+    sf_thread threads[SORT_MAX_THREADS];
+    size_t started = 0;
+    while (started + 1 < count && sf_thread_start(&threads[started], task, jobs + started + 1))
+        ++started;
+    // Jobs that didn't get a thread run here.
+    for (size_t i = started + 1; i < count; ++i)
+        task(jobs + i);
+    task(jobs);
+    for (size_t i = 0; i < started; ++i)
+        sf_thread_join(threads[i]);
+}
+/// Sort a vec with a merge sort across `threads` threads, or one per processor when 0.
+/// Each thread introsorts a chunk, then the chunks are merged in pairs, with every merge split
+/// evenly between the threads so the last ones don't run on a single core.
+/// Stable between chunks but not within them. Returns false when out of memory for the scratch copy.
+static inline bool FUNC(sort_parallel)(VEC_NAME *vec, size_t threads) {
+    VEC_T *items = FUNC(items)(vec);
+    const size_t count = (size_t)vec->count;
+    if (threads == 0)
+        threads = sf_cpu_count();
+    if (threads > SORT_MAX_THREADS)
+        threads = SORT_MAX_THREADS;
+    if (threads < 2 || count < SORT_PARALLEL_MIN) {
+        FUNC(sort_items)(items, count);
+        return true;
+    }
+    VEC_T *scratch = sf_alloc(vec->alloc, count * sizeof(VEC_T));
+    if (!scratch)
+        return false;
+
+    FUNC(sort_job) jobs[SORT_MAX_THREADS];
+    size_t width = (count + threads - 1) / threads;
+    for (size_t t = 0; t < threads; ++t) {
+        const size_t lo = t * width < count ? t * width : count;
+        jobs[t] = (FUNC(sort_job)){ items, NULL, lo, 0, lo + width < count ? lo + width : count, 0, 0 };
+    }
+    FUNC(run_jobs)(FUNC(sort_task), jobs, threads);
+
+    VEC_T *src = items, *dst = scratch;
+    for (; width < count; width *= 2) {
+        const size_t pairs = (count + width * 2 - 1) / (width * 2);
+        const size_t parts = threads / pairs > 1 ? threads / pairs : 1;
+        size_t n = 0;
+        for (size_t p = 0; p < pairs; ++p) {
+            const size_t lo = p * width * 2;
+            const size_t mid = lo + width < count ? lo + width : count;
+            const size_t hi = mid + width < count ? mid + width : count;
+            for (size_t part = 0; part < parts; ++part)
+                jobs[n++] = (FUNC(sort_job)){
+                    src, dst, lo, mid, hi, (hi - lo) * part / parts, (hi - lo) * (part + 1) / parts
+                };
+        }
+        FUNC(run_jobs)(FUNC(merge_task), jobs, n);
+        VEC_T *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != items)
+        memcpy(items, src, count * sizeof(VEC_T));
+    sf_free(vec->alloc, scratch, count * sizeof(VEC_T));
+    return true;
+}
+
+#undef VEC_NAME
+#undef VEC_T
+#undef LESS_FN
+#ifdef VEC_RADIX_KEY
+#undef VEC_RADIX_KEY
+#endif
+#undef SORT_SMALL
+#undef SORT_PARALLEL_MIN
+#undef SORT_MAX_THREADS
+
+#undef CAT
+#undef EXPAND_CAT
+#undef FUNC
@@ -1,31 +1,154 @@
-#ifndef FILES_H
-#define FILES_H
-
-#include "sf/containers/buffer.h"
-#include "sf/str.h"
-#include "export.h"
-
-typedef enum {
-    SF_FILE_NOT_FOUND,
-    SF_OPEN_FAILURE,
-    SF_READ_FAILURE,
-} sf_fs_err;
-
-#define EXPECTED_NAME sf_fs_ex
-#define EXPECTED_E sf_fs_err
-#include "sf/containers/expected.h"
-
-#define EXPECTED_NAME sf_fsb_ex
-#define EXPECTED_O sf_buffer
-#define EXPECTED_E sf_fs_err
-#include "sf/containers/expected.h"
-
-/// Get the size of a file at the specified path. Returns -1 if the file doesn't exist.
-EXPORT long sf_file_size(sf_str path);
-#define sf_file_exists(path) (sf_file_size(path) >= 0)
-/// Load a file into a preallocated buffer. Returns an error result on failure.
-EXPORT sf_fs_ex sf_load_file(uint8_t *out, sf_str path);
-/// Load a file as an sf_buffer.
-EXPORT sf_fsb_ex sf_file_buffer(sf_str path);
-
-#endif // FILES_H
+#ifndef FILES_H
+#define FILES_H
+
+#include <stdio.h>
+#include "sf/containers/buffer.h"
+#include "sf/str.h"
+#include "export.h"
+
+typedef enum {
+    SF_FILE_NOT_FOUND,
+    SF_OPEN_FAILURE,
+    SF_READ_FAILURE,
+    SF_MAP_FAILURE,
+    SF_EOF, // A reader has no more data
+    SF_WRITE_FAILURE,
+    SF_SYNC_FAILURE, // Data couldn't be made durable
+} sf_fs_err;
+
+/// Hints for how a mapped file will be accessed.
+typedef enum {
+    SF_MAP_SEQUENTIAL = (1 << 0), // Read ahead aggressively and drop pages behind the reader.
+    SF_MAP_RANDOM     = (1 << 1), // Disable read ahead.
+    SF_MAP_WILLNEED   = (1 << 2), // Start paging the whole file in now.
+    SF_MAP_HUGEPAGES  = (1 << 3), // Back the mapping with huge pages where supported.
+    SF_MAP_POPULATE   = (1 << 4), // Fault every page in before returning.
+} sf_map_flag;
+
+#define EXPECTED_NAME sf_fs_ex
+#define EXPECTED_E sf_fs_err
+#include "sf/containers/expected.h"
+
+#define EXPECTED_NAME sf_fsb_ex
+#define EXPECTED_O sf_buffer
+#define EXPECTED_E sf_fs_err
+#include "sf/containers/expected.h"
+
+#define EXPECTED_NAME sf_fss_ex
+#define EXPECTED_O sf_str
+#define EXPECTED_E sf_fs_err
+#include "sf/containers/expected.h"
+
+/// Default amount of bytes a reader pulls from its file at once.
+#define SF_READER_CHUNK_SIZE (64 * 1024)
+
+/// Streams a file in fixed size chunks through one reusable buffer,
+/// so memory stays bounded by the chunk size (or the longest line) instead of the file size.
+typedef struct {
+    FILE *file;
+    sf_buffer chunk; /// Storage for the bytes read but not yet consumed.
+    size_t chunk_size;
+    size_t start, end; /// The unconsumed bytes of `chunk`.
+    uint64_t offset; /// File offset of the next read.
+    bool eof;
+} sf_file_reader;
+
+#define EXPECTED_NAME sf_fsr_ex
+#define EXPECTED_O sf_file_reader
+#define EXPECTED_E sf_fs_err
+#include "sf/containers/expected.h"
+
+/// Get the size of a file at the specified path. Returns -1 if the file doesn't exist.
+EXPORT long sf_file_size(sf_str path);
+#define sf_file_exists(path) (sf_file_size(path) >= 0)
+/// Load a file into a preallocated buffer. Returns an error result on failure.
+EXPORT sf_fs_ex sf_load_file(uint8_t *out, sf_str path);
+/// Load a file as an sf_buffer.
+EXPORT sf_fsb_ex sf_file_buffer(sf_str path);
+/// Map a file into memory as a read-only sf_buffer, paged in lazily as it is read.
+/// `flags` is a combination of sf_map_flag. Unmap with sf_buffer_clear.
+EXPORT sf_fsb_ex sf_file_map(sf_str path, uint32_t flags);
+/// Change the access hints of a buffer returned by sf_file_map.
+EXPORT void sf_file_advise(const sf_buffer *buffer, uint32_t flags);
+
+/// Open a file for streaming. `chunk_size` 0 uses SF_READER_CHUNK_SIZE.
+EXPORT sf_fsr_ex sf_file_reader_open(sf_str path, size_t chunk_size);
+/// Close a reader's file and free its buffer.
+EXPORT void sf_file_reader_close(sf_file_reader *reader);
+/// Read the next chunk of at most `chunk_size` bytes. Fails with SF_EOF once the file is exhausted.
+/// The view is not null terminated and is only valid until the next read.
+EXPORT sf_fss_ex sf_file_reader_next(sf_file_reader *reader);
+/// Read the next line without its line ending ("\n" or "\r\n"). Fails with SF_EOF once the file is exhausted.
+/// The view is not null terminated and is only valid until the next read.
+EXPORT sf_fss_ex sf_file_reader_next_line(sf_file_reader *reader);
+
+/// Default amount of bytes a writer accumulates before writing them out as one block.
+#define SF_WRITER_BLOCK_SIZE (64 * 1024)
+/// Default amount of commits a group committing writer batches into one sync.
+#define SF_WRITER_GROUP_SIZE 32
+
+/// Flags for opening a file writer.
+typedef enum {
+    SF_WRITE_APPEND       = (1 << 0), // Append to the file instead of truncating it. With SF_WRITE_ATOMIC, the
+                                      // temporary file starts as a copy of the file, so close keeps its contents.
+    SF_WRITE_ATOMIC       = (1 << 1), // Write to a uniquely named temporary file next to the path, replacing the
+                                      // path on close. The replacement keeps the file's permissions and is
+                                      // always synced, along with its directory.
+    SF_WRITE_SYNC         = (1 << 2), // Sync the file to disk on every commit and on close.
+    SF_WRITE_GROUP_COMMIT = (1 << 3), // Only sync every `group_size` commits.
+} sf_write_flag;
+
+/// Writes a file through a block sized buffer, so small writes turn into few large system calls.
+/// Not thread safe.
+typedef struct {
+    int fd;
+    sf_buffer block; /// Bytes written but not yet flushed, at most `block_size`.
+    uint32_t flags;
+    sf_str path;
+    sf_str temp_path; /// Where an atomic writer writes until it is closed, `path` with a random suffix.
+    size_t group_size; /// Commits per sync with SF_WRITE_GROUP_COMMIT, may be changed at any time.
+    size_t commits; /// Commits since the last sync.
+} sf_file_writer;
+
+#define EXPECTED_NAME sf_fsw_ex
+#define EXPECTED_O sf_file_writer
+#define EXPECTED_E sf_fs_err
+#include "sf/containers/expected.h"
+
+/// Open a file for writing. `block_size` 0 uses SF_WRITER_BLOCK_SIZE.
+/// `flags` is a combination of sf_write_flag.
+EXPORT sf_fsw_ex sf_file_writer_open(sf_str path, size_t block_size, uint32_t flags);
+/// Write bytes, buffering them until a full block can be written.
+EXPORT sf_fs_ex sf_file_writer_write(sf_file_writer *writer, const void *data, size_t size);
+/// Write the contents of several buffers with as few system calls as possible.
+EXPORT sf_fs_ex sf_file_writer_writev(sf_file_writer *writer, const sf_buffer *buffers, size_t count);
+/// Write out every buffered byte.
+EXPORT sf_fs_ex sf_file_writer_flush(sf_file_writer *writer);
+/// Flush and, with SF_WRITE_SYNC, make everything written so far durable.
+/// Group committing writers only sync every `group_size` commits.
+EXPORT sf_fs_ex sf_file_writer_commit(sf_file_writer *writer);
+/// Flush, sync if requested and close the file. Atomic writers replace their path only if everything succeeded.
+EXPORT sf_fs_ex sf_file_writer_close(sf_file_writer *writer);
+/// Close without flushing. Atomic writers leave their path untouched.
+EXPORT void sf_file_writer_abort(sf_file_writer *writer);
+
+/// Flags for loading a batch of files.
+typedef enum {
+    SF_BATCH_CONTIGUOUS = (1 << 0), // Load every file into one shared allocation.
+} sf_batch_flag;
+
+/// The files loaded by sf_fs_batch_load.
+typedef struct {
+    sf_fsb_ex *results; /// One result per path, in the order they were given.
+    size_t count;
+    uint8_t *backing; /// The storage every buffer points into with SF_BATCH_CONTIGUOUS, otherwise NULL.
+    size_t backing_size;
+} sf_fs_batch;
+
+/// Load many files concurrently, through io_uring where available and a pool of threads otherwise.
+/// `flags` is a combination of sf_batch_flag. Buffers in a contiguous batch are only freed by sf_fs_batch_free.
+EXPORT sf_fs_batch sf_fs_batch_load(const sf_str *paths, size_t count, uint32_t flags);
+/// Free every buffer of a batch.
+EXPORT void sf_fs_batch_free(sf_fs_batch *batch);
+
+#endif // FILES_H
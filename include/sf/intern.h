@@ -0,0 +1,25 @@
+#ifndef SF_INTERN_H
+#define SF_INTERN_H
+
+#include <stddef.h>
+#include "export.h"
+#include "sf/str.h"
+
+/// Independently locked parts of the intern table, so threads interning different strings rarely contend.
+#define SF_INTERN_SHARDS 16
+
+/// Get the interned copy of a string, adding it to the process wide intern table if it isn't there yet.
+/// The result is flagged SF_STR_INTERNED | SF_STR_CONST and lives until sf_intern_free, so equal
+/// interned strings compare by pointer and hash without reading their bytes. Thread safe.
+EXPORT sf_str sf_intern(sf_str string);
+/// Intern a c-string.
+static inline sf_str sf_intern_cstr(const char *string) { return sf_intern(sf_ref(string)); }
+/// Get the interned copy of a string without adding it. Returns SF_STR_EMPTY if it was never interned.
+EXPORT sf_str sf_intern_find(sf_str string);
+/// The amount of distinct strings interned.
+EXPORT size_t sf_intern_count(void);
+/// Release every interned string, invalidating them all.
+/// Must not race with any other use of the table.
+EXPORT void sf_intern_free(void);
+
+#endif // SF_INTERN_H
@@ -1,81 +1,359 @@
-#ifndef NUMERICS_H
-#define NUMERICS_H
-
-#include <stddef.h>
-#include <stdint.h>
-#define SF_FNV1A_PRIME 0x01000193
-#define SF_FNV1A_SEED 0x811C9DC5
-
-#ifndef min
-#define min(a, b) ((a) < (b) ? (a) : (b))
-#endif
-
-#ifndef max
-#define max(a, b) ((a) > (b) ? (a) : (b))
-#endif
-
-/// A single point in 2d space.
-typedef struct {
-    float x, y;
-} sf_vec2;
-/// Adds two vec2s together and returns the result.
-static inline sf_vec2 sf_vec2_add(const sf_vec2 first, const sf_vec2 second) {
-    return (sf_vec2){first.x + second.x, first.y + second.y};
-}
-/// Subtracts two vec2s and returns the result.
-static inline sf_vec2 sf_vec2_sub(const sf_vec2 first, const sf_vec2 second) {
-    return (sf_vec2){first.x - second.x, first.y - second.y};
-}
-/// Multiplies a vec2 by a factor of vec3.
-static inline sf_vec2 sf_vec2_multv(const sf_vec2 first, const sf_vec2 factor) {
-    return (sf_vec2){first.x * factor.x, first.y * factor.y};
-}
-/// Multiplies a vec2 by a factor of float.
-static inline sf_vec2 sf_vec2_multf(const sf_vec2 first, const float factor) {
-    return (sf_vec2){first.x * factor, first.y * factor};
-}
-
-/// A single point in 3d space.
-typedef struct {
-    float x, y, z;
-} sf_vec3;
-/// Adds two vec3s together and returns the result.
-static inline sf_vec3 sf_vec3_add(const sf_vec3 first, const sf_vec3 second) {
-    return (sf_vec3){first.x + second.x, first.y + second.y, first.z + second.z};
-}
-/// Subtracts two vec3s and returns the result.
-static inline sf_vec3 sf_vec3_sub(const sf_vec3 first, const sf_vec3 second) {
-    return (sf_vec3){first.x - second.x, first.y - second.y, first.z - second.z};
-}
-/// Multiplies a vec3 by a factor of vec3.
-static inline sf_vec3 sf_vec3_multv(const sf_vec3 first, const sf_vec3 factor) {
-    return (sf_vec3){first.x * factor.x, first.y * factor.y, first.z * factor.z};
-}
-/// Multiplies a vec3 by a factor of float.
-static inline sf_vec3 sf_vec3_multf(const sf_vec3 first, const float factor) {
-    return (sf_vec3){first.x * factor, first.y * factor, first.z * factor};
-}
-
-/// A representation of a transformation in 3d space.
-typedef struct sf_transform {
-    sf_vec3 position;
-    sf_vec3 rotation;
-    sf_vec3 scale;
-
-    struct sf_transform *parent;
-} sf_transform;
-#define SF_TRANSFORM_IDENTITY ((sf_transform){{0, 0, 0}, {0, 0, 0}, {1, 1, 1}, NULL})
-
-/// Hash a buffer of `size` bytes with the fnv1a algorithm.
-uint32_t sf_fnv1a(const void *data, size_t size);
-
-/// Generates random bytes at the buffer specified.
-//TODO: EXPORT void sf_rand(uint8_t *buffer, size_t size);
-/// Generates a random float in the specified inclusive range.
-//TODO: EXPORT float sf_randf(float min, float max);
-/// Generates a random integer in the specified inclusive range.
-//TODO: EXPORT int64_t sf_randi(int64_t min, int64_t max);
-/// Generates a random unsigned integer in the specified inclusive range.
-//TODO: EXPORT uint64_t sf_randu(uint64_t min, uint64_t max);
-
-#endif // NUMERICS_H
+#ifndef NUMERICS_H
+#define NUMERICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "sf/alloc.h"
+#define SF_FNV1A_PRIME 0x01000193
+#define SF_FNV1A_SEED 0x811C9DC5
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+/// A single point in 2d space.
+typedef struct {
+    float x, y;
+} sf_vec2;
+/// Adds two vec2s together and returns the result.
+static inline sf_vec2 sf_vec2_add(const sf_vec2 first, const sf_vec2 second) {
+    return (sf_vec2){first.x + second.x, first.y + second.y};
+}
+/// Subtracts two vec2s and returns the result.
+static inline sf_vec2 sf_vec2_sub(const sf_vec2 first, const sf_vec2 second) {
+    return (sf_vec2){first.x - second.x, first.y - second.y};
+}
+/// Multiplies a vec2 by a factor of vec3.
+static inline sf_vec2 sf_vec2_multv(const sf_vec2 first, const sf_vec2 factor) {
+    return (sf_vec2){first.x * factor.x, first.y * factor.y};
+}
+/// Multiplies a vec2 by a factor of float.
+static inline sf_vec2 sf_vec2_multf(const sf_vec2 first, const float factor) {
+    return (sf_vec2){first.x * factor, first.y * factor};
+}
+
+/// A single point in 3d space.
+typedef struct {
+    float x, y, z;
+} sf_vec3;
+/// Adds two vec3s together and returns the result.
+static inline sf_vec3 sf_vec3_add(const sf_vec3 first, const sf_vec3 second) {
+    return (sf_vec3){first.x + second.x, first.y + second.y, first.z + second.z};
+}
+/// Subtracts two vec3s and returns the result.
+static inline sf_vec3 sf_vec3_sub(const sf_vec3 first, const sf_vec3 second) {
+    return (sf_vec3){first.x - second.x, first.y - second.y, first.z - second.z};
+}
+/// Multiplies a vec3 by a factor of vec3.
+static inline sf_vec3 sf_vec3_multv(const sf_vec3 first, const sf_vec3 factor) {
+    return (sf_vec3){first.x * factor.x, first.y * factor.y, first.z * factor.z};
+}
+/// Multiplies a vec3 by a factor of float.
+static inline sf_vec3 sf_vec3_multf(const sf_vec3 first, const float factor) {
+    return (sf_vec3){first.x * factor, first.y * factor, first.z * factor};
+}
+
+/// Many vec2s stored as one array per component, so batch kernels can work on several of them at once.
+/// Kernels process `len` elements and accept any arrays at least that long; the ones from sf_vec2_soa_new
+/// are 32 byte aligned. The output of a kernel may be one of its inputs.
+typedef struct {
+    float *x, *y;
+    size_t len; /// Must stay as allocated until freed. Copy the struct to process fewer elements.
+    void *block; /// The allocation holding the arrays, NULL if they are borrowed.
+    const sf_allocator *alloc; /// Where `block` is allocated from, NULL for the C heap.
+} sf_vec2_soa;
+
+/// Allocate `len` zeroed vec2s from `alloc`. All arrays are NULL when out of memory.
+EXPORT sf_vec2_soa sf_vec2_soa_new_in(const sf_allocator *alloc, size_t len);
+/// Allocate `len` zeroed vec2s. All arrays are NULL when out of memory.
+static inline sf_vec2_soa sf_vec2_soa_new(const size_t len) {
+    return sf_vec2_soa_new_in(NULL, len);
+}
+/// Free the arrays, if they were allocated by sf_vec2_soa_new.
+EXPORT void sf_vec2_soa_free(sf_vec2_soa *soa);
+/// Read element `i`.
+static inline sf_vec2 sf_vec2_soa_get(const sf_vec2_soa *soa, const size_t i) {
+    return (sf_vec2){soa->x[i], soa->y[i]};
+}
+/// Write element `i`.
+static inline void sf_vec2_soa_set(const sf_vec2_soa *soa, const size_t i, const sf_vec2 value) {
+    soa->x[i] = value.x;
+    soa->y[i] = value.y;
+}
+/// Copy `soa->len` vec2s in from an array of structs.
+EXPORT void sf_vec2_soa_from_aos(sf_vec2_soa *soa, const sf_vec2 *vectors);
+/// Copy all vec2s out to an array of structs of at least `soa->len`.
+EXPORT void sf_vec2_soa_to_aos(const sf_vec2_soa *soa, sf_vec2 *vectors);
+/// out = first + second, elementwise.
+EXPORT void sf_vec2_soa_add(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *second);
+/// out = first - second, elementwise.
+EXPORT void sf_vec2_soa_sub(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *second);
+/// out = first * factor, componentwise.
+EXPORT void sf_vec2_soa_multv(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *factor);
+/// out = first * factor, scaling every vector.
+EXPORT void sf_vec2_soa_multf(sf_vec2_soa *out, const sf_vec2_soa *first, float factor);
+/// out = first + second * factor, like stepping positions by velocities over a time step.
+EXPORT void sf_vec2_soa_fma(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *second, float factor);
+/// Write the dot product of each pair of vectors to `out`, an array of at least `first->len` floats.
+EXPORT void sf_vec2_soa_dot(float *out, const sf_vec2_soa *first, const sf_vec2_soa *second);
+/// Write the length of each vector to `out`, an array of at least `vectors->len` floats.
+EXPORT void sf_vec2_soa_length(float *out, const sf_vec2_soa *vectors);
+/// Scale each vector to length 1. Vectors of length 0 become 0.
+EXPORT void sf_vec2_soa_normalize(sf_vec2_soa *out, const sf_vec2_soa *vectors);
+
+/// Many vec3s stored as one array per component, see sf_vec2_soa.
+typedef struct {
+    float *x, *y, *z;
+    size_t len; /// Must stay as allocated until freed. Copy the struct to process fewer elements.
+    void *block; /// The allocation holding the arrays, NULL if they are borrowed.
+    const sf_allocator *alloc; /// Where `block` is allocated from, NULL for the C heap.
+} sf_vec3_soa;
+
+/// Allocate `len` zeroed vec3s from `alloc`. All arrays are NULL when out of memory.
+EXPORT sf_vec3_soa sf_vec3_soa_new_in(const sf_allocator *alloc, size_t len);
+/// Allocate `len` zeroed vec3s. All arrays are NULL when out of memory.
+static inline sf_vec3_soa sf_vec3_soa_new(const size_t len) {
+    return sf_vec3_soa_new_in(NULL, len);
+}
+/// Free the arrays, if they were allocated by sf_vec3_soa_new.
+EXPORT void sf_vec3_soa_free(sf_vec3_soa *soa);
+/// Read element `i`.
+static inline sf_vec3 sf_vec3_soa_get(const sf_vec3_soa *soa, const size_t i) {
+    return (sf_vec3){soa->x[i], soa->y[i], soa->z[i]};
+}
+/// Write element `i`.
+static inline void sf_vec3_soa_set(const sf_vec3_soa *soa, const size_t i, const sf_vec3 value) {
+    soa->x[i] = value.x;
+    soa->y[i] = value.y;
+    soa->z[i] = value.z;
+}
+/// Copy `soa->len` vec3s in from an array of structs.
+EXPORT void sf_vec3_soa_from_aos(sf_vec3_soa *soa, const sf_vec3 *vectors);
+/// Copy all vec3s out to an array of structs of at least `soa->len`.
+EXPORT void sf_vec3_soa_to_aos(const sf_vec3_soa *soa, sf_vec3 *vectors);
+/// out = first + second, elementwise.
+EXPORT void sf_vec3_soa_add(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *second);
+/// out = first - second, elementwise.
+EXPORT void sf_vec3_soa_sub(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *second);
+/// out = first * factor, componentwise.
+EXPORT void sf_vec3_soa_multv(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *factor);
+/// out = first * factor, scaling every vector.
+EXPORT void sf_vec3_soa_multf(sf_vec3_soa *out, const sf_vec3_soa *first, float factor);
+/// out = first + second * factor, like stepping positions by velocities over a time step.
+EXPORT void sf_vec3_soa_fma(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *second, float factor);
+/// Write the dot product of each pair of vectors to `out`, an array of at least `first->len` floats.
+EXPORT void sf_vec3_soa_dot(float *out, const sf_vec3_soa *first, const sf_vec3_soa *second);
+/// Write the length of each vector to `out`, an array of at least `vectors->len` floats.
+EXPORT void sf_vec3_soa_length(float *out, const sf_vec3_soa *vectors);
+/// Scale each vector to length 1. Vectors of length 0 become 0.
+EXPORT void sf_vec3_soa_normalize(sf_vec3_soa *out, const sf_vec3_soa *vectors);
+
+/// A rotation in 3d space, as a unit quaternion.
+typedef struct {
+    float x, y, z, w;
+} sf_quat;
+#define SF_QUAT_IDENTITY ((sf_quat){0, 0, 0, 1})
+/// A rotation by euler angles in radians, around x first, then y, then z.
+EXPORT sf_quat sf_quat_from_euler(sf_vec3 radians);
+/// A rotation of `radians` around a unit length axis.
+EXPORT sf_quat sf_quat_from_axis(sf_vec3 axis, float radians);
+/// Combines two rotations, `second` applied first and then `first`.
+static inline sf_quat sf_quat_mul(const sf_quat first, const sf_quat second) {
+    return (sf_quat){
+        first.w * second.x + first.x * second.w + first.y * second.z - first.z * second.y,
+        first.w * second.y - first.x * second.z + first.y * second.w + first.z * second.x,
+        first.w * second.z + first.x * second.y - first.y * second.x + first.z * second.w,
+        first.w * second.w - first.x * second.x - first.y * second.y - first.z * second.z,
+    };
+}
+/// Rotates a vec3 by a quaternion.
+static inline sf_vec3 sf_quat_rotate(const sf_quat rotation, const sf_vec3 vector) {
+    // v + 2w(q x v) + 2(q x (q x v)), with q the vector part of the quaternion.
+    const sf_vec3 t = {
+        2 * (rotation.y * vector.z - rotation.z * vector.y),
+        2 * (rotation.z * vector.x - rotation.x * vector.z),
+        2 * (rotation.x * vector.y - rotation.y * vector.x),
+    };
+    return (sf_vec3){
+        vector.x + rotation.w * t.x + rotation.y * t.z - rotation.z * t.y,
+        vector.y + rotation.w * t.y + rotation.z * t.x - rotation.x * t.z,
+        vector.z + rotation.w * t.z + rotation.x * t.y - rotation.y * t.x,
+    };
+}
+
+/// A 4x4 matrix of floats in column major order, `m[column * 4 + row]`.
+typedef struct {
+    float m[16];
+} sf_mat4;
+#define SF_MAT4_IDENTITY ((sf_mat4){{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}})
+/// Multiplies two matrices, the result applies `second` first and then `first`.
+EXPORT sf_mat4 sf_mat4_mul(sf_mat4 first, sf_mat4 second);
+/// A matrix that scales, then rotates, then translates.
+EXPORT sf_mat4 sf_mat4_from_trs(sf_vec3 position, sf_quat rotation, sf_vec3 scale);
+/// Transforms a point by a matrix, including its translation.
+static inline sf_vec3 sf_mat4_transform_point(const sf_mat4 *matrix, const sf_vec3 point) {
+    const float *m = matrix->m;
+    return (sf_vec3){
+        m[0] * point.x + m[4] * point.y + m[8] * point.z + m[12],
+        m[1] * point.x + m[5] * point.y + m[9] * point.z + m[13],
+        m[2] * point.x + m[6] * point.y + m[10] * point.z + m[14],
+    };
+}
+
+/// A representation of a transformation in 3d space.
+typedef struct sf_transform {
+    sf_vec3 position;
+    sf_vec3 rotation; /// Euler angles in radians, see sf_quat_from_euler.
+    sf_vec3 scale;
+
+    struct sf_transform *parent;
+} sf_transform;
+#define SF_TRANSFORM_IDENTITY ((sf_transform){{0, 0, 0}, {0, 0, 0}, {1, 1, 1}, NULL})
+/// The matrix of a transform relative to its parent.
+EXPORT sf_mat4 sf_transform_local(const sf_transform *transform);
+/// The matrix of a transform relative to the world, composed up its parent chain.
+/// Use an sf_transform_graph to keep many of these up to date.
+EXPORT sf_mat4 sf_transform_world(const sf_transform *transform);
+
+/// Handle of a node in an sf_transform_graph. Handles stay valid until their node is removed.
+typedef uint32_t sf_transform_id;
+/// The parent of root nodes, and the handle returned when adding a node fails.
+#define SF_TRANSFORM_NONE UINT32_MAX
+
+/// A hierarchy of transforms with cached world matrices.
+/// Nodes are stored in flat arrays with every parent before its children, so updating the world matrices
+/// is one pass in memory order that recomputes only changed nodes and their descendants.
+typedef struct {
+    sf_mat4 *worlds; /// World matrix of each slot, as of the last update.
+    sf_transform *locals; /// Local transform of each slot, their `parent` pointers are unused.
+    uint32_t *parents; /// Slot of each slot's parent, always lower than its own. SF_TRANSFORM_NONE for roots.
+    uint32_t *ids; /// Handle of the node in each slot.
+    uint32_t *slots; /// Slot of each handle, or the next free handle for removed ones.
+    uint8_t *flags; /// Dirty and scratch flags of each slot.
+    size_t count, capacity;
+    size_t first_dirty; /// No slot before this one changed since the last update.
+    sf_transform_id free_id; /// Most recently freed handle, SF_TRANSFORM_NONE if there is none.
+    const sf_allocator *alloc; /// Where the arrays are allocated from, NULL for the C heap.
+} sf_transform_graph;
+
+/// Create an empty graph.
+EXPORT sf_transform_graph sf_transform_graph_new(void);
+/// Create an empty graph allocating from `alloc`.
+EXPORT sf_transform_graph sf_transform_graph_new_in(const sf_allocator *alloc);
+/// Free a graph and all its nodes.
+EXPORT void sf_transform_graph_free(sf_transform_graph *graph);
+/// Add a node under `parent`, or a root with SF_TRANSFORM_NONE. Returns SF_TRANSFORM_NONE when out of memory.
+EXPORT sf_transform_id sf_transform_graph_add(sf_transform_graph *graph, sf_transform_id parent, sf_transform local);
+/// Remove a node along with all its descendants.
+EXPORT void sf_transform_graph_remove(sf_transform_graph *graph, sf_transform_id id);
+/// Replace a node's local transform.
+EXPORT void sf_transform_graph_set_local(sf_transform_graph *graph, sf_transform_id id, sf_transform local);
+/// Move a node and its descendants under `parent`, or make it a root with SF_TRANSFORM_NONE.
+/// Returns false and changes nothing if `parent` is the node itself or one of its descendants.
+EXPORT bool sf_transform_graph_set_parent(sf_transform_graph *graph, sf_transform_id id, sf_transform_id parent);
+/// Recompute the world matrices of every node changed since the last update, and of their descendants.
+EXPORT void sf_transform_graph_update(sf_transform_graph *graph);
+/// A node's local transform.
+static inline const sf_transform *sf_transform_graph_local(const sf_transform_graph *graph, const sf_transform_id id) {
+    return &graph->locals[graph->slots[id]];
+}
+/// A node's world matrix as of the last sf_transform_graph_update.
+static inline const sf_mat4 *sf_transform_graph_world(const sf_transform_graph *graph, const sf_transform_id id) {
+    return &graph->worlds[graph->slots[id]];
+}
+
+/// Hash a buffer of `size` bytes with the fnv1a algorithm.
+uint32_t sf_fnv1a(const void *data, size_t size);
+
+/// Seed of sf_hash64, and so of sf_str_hash and the containers' default hashes.
+/// Set a secret one through the SF_HASH_SEED CMake option when hashing untrusted keys, so colliding keys
+/// can't be precomputed. It must match between the library and everything using it, as the library
+/// stores hashes too, like sf_intern's, so don't define it in application code alone.
+#ifndef SF_HASH_SEED
+#define SF_HASH_SEED 0x9E3779B97F4A7C15ull
+#endif
+
+/// Hash `size` bytes into 64 well mixed bits, 16 to 48 bytes at a time (a wyhash variant).
+/// Hashes are meant for use within a process, they differ between little and big endian machines.
+EXPORT uint64_t sf_hash64_seeded(const void *data, size_t size, uint64_t seed);
+/// Hash `size` bytes with SF_HASH_SEED.
+static inline uint64_t sf_hash64(const void *data, const size_t size) {
+    return sf_hash64_seeded(data, size, SF_HASH_SEED);
+}
+/// Hash a single integer, faster than sf_hash64 on its bytes.
+static inline uint64_t sf_hash_u64(uint64_t value) {
+    value ^= SF_HASH_SEED;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+/// Incremental hashing of data that arrives in pieces.
+/// Any split of the same bytes hashes the same as sf_hash64_seeded on all of them at once.
+typedef struct {
+    uint64_t seed, initial_seed;
+    uint64_t lanes[2]; /// Extra accumulators for 48 byte blocks.
+    uint64_t total; /// Bytes hashed so far.
+    size_t pending; /// Bytes waiting in `buffer` after the 16 byte history.
+    uint8_t buffer[16 + 48]; /// The last 16 bytes of the previous block, then the bytes of the next one.
+} sf_hash_state;
+
+/// Start hashing with `seed`.
+EXPORT void sf_hash_init(sf_hash_state *state, uint64_t seed);
+/// Hash `size` more bytes.
+EXPORT void sf_hash_update(sf_hash_state *state, const void *data, size_t size);
+/// The hash of everything passed to sf_hash_update so far. More can still be added afterwards.
+EXPORT uint64_t sf_hash_final(const sf_hash_state *state);
+
+/// State of a xoshiro256** pseudo random number generator. Fast and statistically strong, not for secrets.
+typedef struct {
+    uint64_t s[4];
+} sf_rng;
+
+/// A generator seeded from any 64-bit value. Equal seeds give equal sequences on every platform.
+EXPORT sf_rng sf_rng_new(uint64_t seed);
+/// Next 64 random bits.
+static inline uint64_t sf_rng_next(sf_rng *rng) {
+    uint64_t *s = rng->s;
+    const uint64_t x = s[1] * 5;
+    const uint64_t result = ((x << 7) | (x >> 57)) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+/// Advance a generator by 2^128 steps, to split one seed into streams that never overlap.
+EXPORT void sf_rng_jump(sf_rng *rng);
+/// Fill `size` bytes with random bits. Large buffers are filled by several streams in parallel.
+EXPORT void sf_rng_bytes(sf_rng *rng, void *buffer, size_t size);
+/// A uniformly distributed integer in [0, bound), without modulo bias. `bound` must not be 0.
+EXPORT uint64_t sf_rng_below(sf_rng *rng, uint64_t bound);
+/// A uniformly distributed unsigned integer in the inclusive range.
+EXPORT uint64_t sf_rng_uint(sf_rng *rng, uint64_t min, uint64_t max);
+/// A uniformly distributed signed integer in the inclusive range.
+EXPORT int64_t sf_rng_int(sf_rng *rng, int64_t min, int64_t max);
+/// A random float in the inclusive range, from 2^24 + 1 evenly spaced steps.
+EXPORT float sf_rng_float(sf_rng *rng, float min, float max);
+
+/// Seed the calling thread's default generator, which is otherwise seeded from the time on first use.
+EXPORT void sf_rand_seed(uint64_t seed);
+/// Generates random bytes at the buffer specified, from the calling thread's default generator.
+EXPORT void sf_rand(void *buffer, size_t size);
+/// Generates a random float in the specified inclusive range.
+EXPORT float sf_randf(float min, float max);
+/// Generates a random integer in the specified inclusive range.
+EXPORT int64_t sf_randi(int64_t min, int64_t max);
+/// Generates a random unsigned integer in the specified inclusive range.
+EXPORT uint64_t sf_randu(uint64_t min, uint64_t max);
+
+#endif // NUMERICS_H
@@ -0,0 +1,58 @@
+#ifndef SF_NUM_H
+#define SF_NUM_H
+
+#include <stdint.h>
+#include "export.h"
+#include "sf/str.h"
+#include "sf/containers/buffer.h"
+
+/// Bytes every number fits in when formatted, including the null terminator.
+#define SF_NUM_BUFFER_SIZE 32
+
+typedef enum {
+    SF_NUM_EMPTY, // No characters to parse.
+    SF_NUM_INVALID, // Not a number, or a number followed by other characters.
+    SF_NUM_OVERFLOW, // A number out of the type's range.
+    SF_NUM_ALLOC_FAIL, // Out of memory copying an unusually long float to round it.
+} sf_num_err;
+
+#define EXPECTED_NAME sf_u64_ex
+#define EXPECTED_O uint64_t
+#define EXPECTED_E sf_num_err
+#include "sf/containers/expected.h"
+
+#define EXPECTED_NAME sf_i64_ex
+#define EXPECTED_O int64_t
+#define EXPECTED_E sf_num_err
+#include "sf/containers/expected.h"
+
+#define EXPECTED_NAME sf_f64_ex
+#define EXPECTED_O double
+#define EXPECTED_E sf_num_err
+#include "sf/containers/expected.h"
+
+/// Format an unsigned integer in decimal into `buffer`, null terminated. Returns a view of `buffer`.
+EXPORT sf_str sf_u64_to_str(uint64_t value, char buffer[SF_NUM_BUFFER_SIZE]);
+/// Format a signed integer in decimal into `buffer`, null terminated. Returns a view of `buffer`.
+EXPORT sf_str sf_i64_to_str(int64_t value, char buffer[SF_NUM_BUFFER_SIZE]);
+/// Format the shortest decimal that parses back to exactly `value` into `buffer`, null terminated.
+/// Returns a view of `buffer`. Numbers from 1e-7 up to 1e21 are written out in full, like "0.25" or "1500",
+/// others in scientific notation, like "1e+21" or "2.5e-8". Infinities and NaN are "inf", "-inf" and "nan".
+EXPORT sf_str sf_f64_to_str(double value, char buffer[SF_NUM_BUFFER_SIZE]);
+
+/// Parse a whole string as an unsigned decimal integer, with an optional '+'.
+EXPORT sf_u64_ex sf_str_to_u64(sf_str string);
+/// Parse a whole string as a signed decimal integer, with an optional '+' or '-'.
+EXPORT sf_i64_ex sf_str_to_i64(sf_str string);
+/// Parse a whole string as a decimal floating point number, like "-1.5", ".5" or "2e10", or "inf" and "nan".
+/// Results are correctly rounded and don't depend on the C locale.
+EXPORT sf_f64_ex sf_str_to_f64(sf_str string);
+
+/// Append an unsigned integer in decimal to a buffer, without a null terminator.
+EXPORT sf_buffer_ex sf_buffer_insert_u64(sf_buffer *buffer, uint64_t value);
+/// Append a signed integer in decimal to a buffer, without a null terminator.
+EXPORT sf_buffer_ex sf_buffer_insert_i64(sf_buffer *buffer, int64_t value);
+/// Append the shortest round trip decimal of a double to a buffer, without a null terminator.
+EXPORT sf_buffer_ex sf_buffer_insert_f64(sf_buffer *buffer, double value);
+
+#endif // SF_NUM_H
@@ -0,0 +1,48 @@
+#ifndef SF_POOL_H
+#define SF_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "sf/alloc.h"
+#include "sf/thread.h"
+
+/// Objects each thread caches per pool before returning them to the shared free list.
+#define SF_POOL_MAGAZINE 32
+/// Default size of the slabs objects are carved from.
+#define SF_POOL_SLAB_SIZE (64 * 1024)
+
+/// A fixed size object allocator.
+/// Objects are carved out of large slabs and recycled through a free list,
+/// with a small per-thread magazine in front of it so most allocations and frees never lock.
+/// Objects cached by a thread that exits are only reclaimed when the pool is reset or freed.
+typedef struct sf_pool {
+    size_t object_size;
+    size_t slab_size;
+    struct sf_pool_slot *slot; /// Outlives the pool, so thread caches can check it is still alive.
+    uint64_t id; /// The slot's generation, bumped by every reset so stale thread caches are never used.
+    sf_mutex lock;
+    void *free_list; /// Released objects shared between threads.
+    void *slabs; /// Every slab, released in bulk.
+    uint8_t *bump, *bump_end; /// The uncarved remainder of the newest slab.
+    const sf_allocator *backing; /// Where slabs come from, NULL for the C heap.
+} sf_pool;
+
+/// Create a pool handing out objects of `object_size` bytes.
+EXPORT sf_pool *sf_pool_new(size_t object_size);
+/// Create a pool whose slabs (and the pool itself) are allocated from `backing`.
+EXPORT sf_pool *sf_pool_new_in(const sf_allocator *backing, size_t object_size);
+/// Release every slab and the pool itself, invalidating all of its objects.
+EXPORT void sf_pool_free(sf_pool *pool);
+/// Release every slab, invalidating all objects but keeping the pool usable.
+EXPORT void sf_pool_reset(sf_pool *pool);
+
+/// Take an object from a pool. Returns NULL when out of memory.
+EXPORT void *sf_pool_alloc(sf_pool *pool);
+/// Return an object to the pool it came from. May be called from any thread.
+EXPORT void sf_pool_release(sf_pool *pool, void *object);
+
+/// Wrap a pool as an sf_allocator. Allocations must fit in the pool's object size.
+EXPORT sf_allocator sf_pool_allocator(sf_pool *pool);
+
+#endif // SF_POOL_H
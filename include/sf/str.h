@@ -1,58 +1,161 @@
-#ifndef STRINGS_H
-#define STRINGS_H
-
-#include <stdint.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdbool.h>
-#include "export.h"
-#include "sf/math.h"
-
-/// Bitfield of flags to define aspects about a `sf_str`
-#define SF_STR_NONE (uint8_t)(1u << 0)
-#define SF_STR_EMPTYF (uint8_t)(1u << 1)
-#define SF_STR_CONST (uint8_t)(1u << 2)
-#define SF_STR_LIT (uint8_t)(1u << 3)
-
-/// A simple string wrapper with length.
-typedef struct {
-    char *c_str;
-    size_t len;
-    uint8_t flags;
-} sf_str;
-#define SF_STR_EMPTY (sf_str) { NULL, 0, SF_STR_EMPTYF }
-
-#define sf_lit(literal) ((sf_str) { .c_str = (char *)(literal), .len = sizeof(literal) - 1, .flags = SF_STR_CONST | SF_STR_LIT })
-#define sf_ref(cstr) ((cstr) ? (sf_str) { .c_str = (char *)(cstr), .len = strlen(cstr), .flags = SF_STR_CONST } : SF_STR_EMPTY)
-#define sf_own(cstr) ((cstr) ? (sf_str) { .c_str = (char *)(cstr), .len = strlen(cstr), .flags = SF_STR_NONE } : SF_STR_EMPTY)
-
-#define sf_islit(string) ((string).flags & SF_STR_LIT)
-#define sf_isempty(string) ((string).flags & SF_STR_EMPTYF)
-/// Create a new string with format specifiers.
-EXPORT sf_str sf_str_fmt(const char *format, ...);
-/// Allocate space for and join two strings together.
-EXPORT sf_str sf_str_join(const sf_str str1, const sf_str str2);
-/// Reallocates and appends to a string. Do not call this on a literal.
-EXPORT void sf_str_append(sf_str *str1, const sf_str str2);
-/// Allocates and duplicates a new string from an existing one.
-EXPORT sf_str sf_str_dup(const sf_str string);
-/// Duplicate a c-string into a sf_str.
-static inline sf_str sf_str_cdup(const char *string) { return sf_str_dup(sf_ref(string)); }
-
-/// Returns 0 if two strings are lexographically equal.
-EXPORT int sf_str_cmp(sf_str str1, const sf_str str2);
-/// Returns true if two strings are lexographically equal.
-static inline bool sf_str_eq(const sf_str str1, const sf_str str2) { return sf_str_cmp(str1, str2) == 0; }
-
-/// Free a string (static inlined for simplicity)
-static inline void sf_str_free(sf_str string) {
-    if (!(string.flags & SF_STR_CONST || string.flags & SF_STR_LIT)) {
-        free(string.c_str);
-        string.len = 0;
-    }
-}
-
-/// Hash a string
-static inline uint32_t sf_str_hash(const sf_str string) { return sf_fnv1a(string.c_str, string.len); }
-
-#endif // STRINGS_H
+#ifndef STRINGS_H
+#define STRINGS_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "export.h"
+#include "sf/math.h"
+#include "sf/alloc.h"
+
+/// Bitfield of flags to define aspects about a `sf_str`
+#define SF_STR_NONE (uint8_t)(1u << 0)
+#define SF_STR_EMPTYF (uint8_t)(1u << 1)
+#define SF_STR_CONST (uint8_t)(1u << 2)
+#define SF_STR_LIT (uint8_t)(1u << 3)
+/// Owned by the intern table (see sf/intern.h): equal strings share one pointer and the hash is stored before the bytes.
+#define SF_STR_INTERNED (uint8_t)(1u << 4)
+/// Stored inside the sf_str itself rather than behind `c_str` (SF_STR_SSO builds only).
+#define SF_STR_INLINE (uint8_t)(1u << 5)
+/// `hash` holds the string's sf_str_hash. Cleared by anything that changes the bytes.
+#define SF_STR_HASHED (uint8_t)(1u << 6)
+
+#ifdef SF_STR_SSO
+/// Bytes a string can store inline, including its null terminator.
+#define SF_STR_SSO_SIZE 16
+/// A simple string wrapper with length.
+/// Strings created by this library that are shorter than SF_STR_SSO_SIZE are stored inline and
+/// flagged SF_STR_INLINE, their bytes must be accessed through sf_cstr.
+typedef struct {
+    size_t len;
+    union {
+        char *c_str;
+        char sso[SF_STR_SSO_SIZE];
+    };
+    uint64_t hash; /// Only valid when flagged SF_STR_HASHED.
+    uint8_t flags;
+} sf_str;
+/// The bytes of a string, wherever they are stored.
+#define sf_cstr(string) (((string).flags & SF_STR_INLINE) ? (string).sso : (string).c_str)
+#else
+/// A simple string wrapper with length.
+typedef struct {
+    char *c_str;
+    size_t len;
+    uint64_t hash; /// Only valid when flagged SF_STR_HASHED.
+    uint8_t flags;
+} sf_str;
+/// The bytes of a string, wherever they are stored.
+#define sf_cstr(string) ((string).c_str)
+#endif
+#define SF_STR_EMPTY (sf_str) { .c_str = NULL, .len = 0, .flags = SF_STR_EMPTYF }
+
+#define sf_lit(literal) ((sf_str) { .c_str = (char *)(literal), .len = sizeof(literal) - 1, .flags = SF_STR_CONST | SF_STR_LIT })
+#define sf_ref(cstr) ((cstr) ? (sf_str) { .c_str = (char *)(cstr), .len = strlen(cstr), .flags = SF_STR_CONST } : SF_STR_EMPTY)
+#define sf_own(cstr) ((cstr) ? (sf_str) { .c_str = (char *)(cstr), .len = strlen(cstr), .flags = SF_STR_NONE } : SF_STR_EMPTY)
+
+#define sf_islit(string) ((string).flags & SF_STR_LIT)
+#define sf_isempty(string) ((string).flags & SF_STR_EMPTYF)
+#define sf_isinterned(string) ((string).flags & SF_STR_INTERNED)
+#define sf_isinline(string) ((string).flags & SF_STR_INLINE)
+/// True for strings without any bytes, like SF_STR_EMPTY or a failed allocation.
+#define sf_isnull(string) (!sf_isinline(string) && !(string).c_str)
+/// Create a new string with format specifiers.
+EXPORT sf_str sf_str_fmt(const char *format, ...);
+/// Create a new string with format specifiers, allocated from `alloc`.
+EXPORT sf_str sf_str_fmt_in(const sf_allocator *alloc, const char *format, ...);
+/// `sf_str_fmt_in` taking a va_list.
+EXPORT sf_str sf_str_vfmt_in(const sf_allocator *alloc, const char *format, va_list args);
+/// Allocate space for and join two strings together.
+EXPORT sf_str sf_str_join(const sf_str str1, const sf_str str2);
+/// Join two strings together into space allocated from `alloc`.
+EXPORT sf_str sf_str_join_in(const sf_allocator *alloc, const sf_str str1, const sf_str str2);
+/// Reallocates and appends to a string. Do not call this on a literal.
+EXPORT void sf_str_append(sf_str *str1, const sf_str str2);
+/// Appends to a string that was allocated from `alloc`.
+EXPORT void sf_str_append_in(const sf_allocator *alloc, sf_str *str1, const sf_str str2);
+/// Allocates and duplicates a new string from an existing one.
+EXPORT sf_str sf_str_dup(const sf_str string);
+/// Duplicates a string into space allocated from `alloc`.
+EXPORT sf_str sf_str_dup_in(const sf_allocator *alloc, const sf_str string);
+/// Duplicate a c-string into a sf_str.
+static inline sf_str sf_str_cdup(const char *string) { return sf_str_dup(sf_ref(string)); }
+
+/// Compare two strings byte by byte, like memcmp. Returns 0 if they are equal,
+/// a negative value if `str1` orders first and a positive value otherwise.
+EXPORT int sf_str_cmp(sf_str str1, const sf_str str2);
+/// Returns true if two strings are lexographically equal.
+/// Two interned strings are equal only if they are the same pointer, two hashed ones only if their hashes match.
+static inline bool sf_str_eq(const sf_str str1, const sf_str str2) {
+    if (str1.flags & str2.flags & SF_STR_INTERNED)
+        return str1.c_str == str2.c_str;
+    if (str1.flags & str2.flags & SF_STR_HASHED && str1.hash != str2.hash)
+        return false;
+    return str1.len == str2.len && (str1.len == 0 || memcmp(sf_cstr(str1), sf_cstr(str2), str1.len) == 0);
+}
+
+/// Returned by searches that found nothing.
+#define SF_STR_NPOS SIZE_MAX
+
+/// Index of the first occurrence of `needle`, or SF_STR_NPOS.
+EXPORT size_t sf_str_find(sf_str string, sf_str needle);
+/// Index of the first occurrence of `c`, or SF_STR_NPOS.
+EXPORT size_t sf_str_find_char(sf_str string, char c);
+/// Index of the first byte that is any of the bytes in `set`, or SF_STR_NPOS.
+EXPORT size_t sf_str_find_any(sf_str string, sf_str set);
+/// Amount of non-overlapping occurrences of `needle`.
+EXPORT size_t sf_str_count(sf_str string, sf_str needle);
+/// Amount of occurrences of `c`.
+EXPORT size_t sf_str_count_char(sf_str string, char c);
+
+/// A view of `len` bytes from `offset`, clamped to the string. Views aren't null terminated and don't own their bytes,
+/// except that views of inline strings are small inline copies.
+EXPORT sf_str sf_str_sub(sf_str string, size_t offset, size_t len);
+/// Take the view up to the next `delim` from `rest`, advancing `rest` past it.
+/// Returns false once every piece was taken. Empty pieces are kept, so "a,,b" splits into "a", "" and "b".
+EXPORT bool sf_str_split_next(sf_str *rest, sf_str delim, sf_str *piece);
+/// Take the next view between any of the bytes in `delims` from `rest`, advancing `rest` past it.
+/// Returns false once no tokens are left. Runs of delimiters are skipped, so tokens are never empty.
+EXPORT bool sf_str_tokenize_next(sf_str *rest, sf_str delims, sf_str *token);
+/// Split a string on `delim` into at most `max` views. Returns the amount of pieces written.
+EXPORT size_t sf_str_split(sf_str string, sf_str delim, sf_str *out, size_t max);
+/// A view without leading and trailing ASCII whitespace.
+EXPORT sf_str sf_str_trim(sf_str string);
+/// A view without leading ASCII whitespace.
+EXPORT sf_str sf_str_trim_left(sf_str string);
+/// A view without trailing ASCII whitespace.
+EXPORT sf_str sf_str_trim_right(sf_str string);
+
+/// Free a string that was allocated from `alloc`.
+static inline void sf_str_free_in(const sf_allocator *alloc, sf_str string) {
+    if (!(string.flags & (SF_STR_CONST | SF_STR_LIT | SF_STR_INLINE)) && string.c_str)
+        sf_free(alloc, string.c_str, string.len + 1);
+}
+/// Free a string (static inlined for simplicity)
+static inline void sf_str_free(sf_str string) {
+    if (!(string.flags & (SF_STR_CONST | SF_STR_LIT | SF_STR_INLINE))) {
+        free(string.c_str);
+        string.len = 0;
+    }
+}
+
+/// Hash a string. Interned and hashed strings return their stored hash.
+static inline uint64_t sf_str_hash(const sf_str string) {
+    if (string.flags & SF_STR_INTERNED)
+        return ((const uint64_t *)(const void *)string.c_str)[-1];
+    if (string.flags & SF_STR_HASHED)
+        return string.hash;
+    return sf_hash64(sf_cstr(string), string.len);
+}
+/// Hash a string, storing the hash in it so copies of it made afterwards hash and compare without rescanning.
+static inline uint64_t sf_str_hash_cached(sf_str *string) {
+    if (!(string->flags & SF_STR_HASHED)) {
+        string->hash = sf_str_hash(*string);
+        string->flags |= SF_STR_HASHED;
+    }
+    return string->hash;
+}
+
+#endif // STRINGS_H
@@ -0,0 +1,62 @@
+#ifndef SF_STRBUF_H
+#define SF_STRBUF_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "export.h"
+#include "sf/alloc.h"
+#include "sf/str.h"
+
+/// Capacity a string builder starts at once it is first appended to.
+#define SF_STRBUF_MIN_CAPACITY 32
+
+/// A string builder. Appends grow the allocation geometrically and are amortized O(1),
+/// the contents are always null terminated once anything was appended.
+typedef struct {
+    char *ptr;
+    size_t len;
+    size_t capacity; /// Bytes allocated, including room for the null terminator.
+    const sf_allocator *alloc; /// Where `ptr` is allocated from, NULL for the C heap.
+} sf_strbuf;
+
+/// Create an empty string builder. Nothing is allocated until the first append.
+EXPORT sf_strbuf sf_strbuf_new(void);
+/// Create an empty string builder allocating from `alloc`.
+EXPORT sf_strbuf sf_strbuf_new_in(const sf_allocator *alloc);
+/// Free a builder's contents.
+EXPORT void sf_strbuf_free(sf_strbuf *sb);
+/// Empty a builder, keeping its allocation.
+EXPORT void sf_strbuf_clear(sf_strbuf *sb);
+/// Make room for `additional` more bytes. Returns false when out of memory.
+EXPORT bool sf_strbuf_reserve(sf_strbuf *sb, size_t additional);
+
+/// Append a string. Returns false when out of memory, as do all appends.
+EXPORT bool sf_strbuf_append(sf_strbuf *sb, sf_str string);
+/// Append a single character.
+EXPORT bool sf_strbuf_append_char(sf_strbuf *sb, char c);
+/// Append a signed integer in decimal.
+EXPORT bool sf_strbuf_append_int(sf_strbuf *sb, int64_t value);
+/// Append an unsigned integer in decimal.
+EXPORT bool sf_strbuf_append_uint(sf_strbuf *sb, uint64_t value);
+/// Append the shortest decimal that parses back to exactly `value`, see sf_f64_to_str.
+EXPORT bool sf_strbuf_append_double(sf_strbuf *sb, double value);
+/// Append a floating point number with `precision` digits after the decimal point (at most 9).
+/// Magnitudes too large for that, infinities and NaN are written as by sf_strbuf_append_double.
+EXPORT bool sf_strbuf_append_float(sf_strbuf *sb, double value, unsigned precision);
+/// Append with format specifiers.
+EXPORT bool sf_strbuf_appendf(sf_strbuf *sb, const char *format, ...);
+/// `sf_strbuf_appendf` taking a va_list.
+EXPORT bool sf_strbuf_vappendf(sf_strbuf *sb, const char *format, va_list args);
+
+/// A view of the contents so far, valid until the next append.
+static inline sf_str sf_strbuf_view(const sf_strbuf *sb) {
+    return (sf_str) { .c_str = sb->ptr ? sb->ptr : (char *)"", .len = sb->len, .flags = SF_STR_CONST };
+}
+/// Hand the contents over as a string owned by the builder's allocator, leaving the builder empty.
+/// The allocation is trimmed in place rather than copied. Free the result with sf_str_free_in.
+/// Returns SF_STR_EMPTY, keeping the builder's contents, if trimming runs out of memory.
+EXPORT sf_str sf_strbuf_finish(sf_strbuf *sb);
+
+#endif // SF_STRBUF_H
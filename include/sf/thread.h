@@ -0,0 +1,53 @@
+#ifndef SF_THREAD_H
+#define SF_THREAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "export.h"
+
+#ifdef _WIN32
+/// A lightweight mutual exclusion lock.
+typedef struct {
+    void *lock; // SRWLOCK
+} sf_mutex;
+/// A handle to a running thread.
+typedef struct {
+    void *handle;
+} sf_thread;
+#define SF_MUTEX_INIT { NULL }
+#else
+#include <pthread.h>
+/// A lightweight mutual exclusion lock.
+typedef struct {
+    pthread_mutex_t lock;
+} sf_mutex;
+/// A handle to a running thread.
+typedef struct {
+    pthread_t handle;
+} sf_thread;
+#define SF_MUTEX_INIT { PTHREAD_MUTEX_INITIALIZER }
+#endif
+
+#ifdef _MSC_VER
+#define sf_thread_local __declspec(thread)
+#else
+#define sf_thread_local _Thread_local
+#endif
+
+/// Initialize a mutex. Statically allocated mutexes can use SF_MUTEX_INIT instead.
+EXPORT void sf_mutex_init(sf_mutex *mutex);
+/// Release a mutex's resources.
+EXPORT void sf_mutex_destroy(sf_mutex *mutex);
+/// Block until the mutex is acquired.
+EXPORT void sf_mutex_lock(sf_mutex *mutex);
+/// Release a mutex held by the calling thread.
+EXPORT void sf_mutex_unlock(sf_mutex *mutex);
+
+/// Start a thread running `func(ud)`. Returns false if the thread couldn't be created.
+EXPORT bool sf_thread_start(sf_thread *thread, void (*func)(void *ud), void *ud);
+/// Wait for a thread to finish.
+EXPORT void sf_thread_join(sf_thread thread);
+/// The amount of logical processors available, at least 1.
+EXPORT size_t sf_cpu_count(void);
+
+#endif // SF_THREAD_H
@@ -0,0 +1,200 @@
+#include <assert.h>
+#include <stdarg.h>
+#include "sf/arena.h"
+#include "sanitizers.h"
+
+#ifdef SF_ASAN
+/// Poisoned gap left after each allocation so overruns are caught.
+#define REDZONE 16
+#else
+#define REDZONE 0
+#endif
+
+#define MAX_ALIGN _Alignof(max_align_t)
+#define HEADER_SIZE ((sizeof(sf_arena_chunk) + MAX_ALIGN - 1) & ~(MAX_ALIGN - 1))
+
+static inline uint8_t *chunk_data(sf_arena_chunk *chunk) {
+    return (uint8_t *)chunk + HEADER_SIZE;
+}
+
+/// Take a chunk of at least `min_size` usable bytes, preferring the spare.
+static sf_arena_chunk *chunk_new(sf_arena *arena, const size_t min_size) {
+    sf_arena_chunk *chunk = arena->spare;
+    if (chunk && chunk->size >= min_size) {
+        arena->spare = NULL;
+    } else {
+        const size_t size = max(arena->chunk_size, min_size);
+        if (size > SIZE_MAX - HEADER_SIZE)
+            return NULL;
+        chunk = sf_alloc(arena->backing, HEADER_SIZE + size);
+        if (!chunk)
+            return NULL;
+        chunk->size = size;
+        __asan_poison_memory_region(chunk_data(chunk), size);
+    }
+    chunk->prev = NULL;
+    chunk->used = 0;
+    return chunk;
+}
+
+/// Return a chunk, keeping the larger of it and the current spare.
+static void chunk_release(sf_arena *arena, sf_arena_chunk *chunk) {
+    __asan_poison_memory_region(chunk_data(chunk), chunk->size);
+    if (arena->spare && arena->spare->size >= chunk->size) {
+        sf_free(arena->backing, chunk, HEADER_SIZE + chunk->size);
+        return;
+    }
+    if (arena->spare)
+        sf_free(arena->backing, arena->spare, HEADER_SIZE + arena->spare->size);
+    arena->spare = chunk;
+}
+
+sf_arena sf_arena_new(const size_t chunk_size) {
+    return sf_arena_new_in(NULL, chunk_size);
+}
+
+sf_arena sf_arena_new_in(const sf_allocator *backing, const size_t chunk_size) {
+    return (sf_arena) {
+        .head = NULL,
+        .spare = NULL,
+        .last = NULL,
+        .chunk_size = chunk_size ? chunk_size : SF_ARENA_CHUNK_SIZE,
+        .backing = backing,
+    };
+}
+
+void sf_arena_free(sf_arena *arena) {
+    sf_arena_restore(arena, (sf_arena_mark) { NULL, 0 });
+    if (arena->spare)
+        sf_free(arena->backing, arena->spare, HEADER_SIZE + arena->spare->size);
+    arena->spare = NULL;
+}
+
+void sf_arena_reset(sf_arena *arena) {
+    sf_arena_chunk *first = arena->head;
+    while (first && first->prev)
+        first = first->prev;
+    sf_arena_restore(arena, (sf_arena_mark) { first, 0 });
+}
+
+void *sf_arena_alloc(sf_arena *arena, const size_t size) {
+    return sf_arena_alloc_aligned(arena, size, MAX_ALIGN);
+}
+
+void *sf_arena_alloc_aligned(sf_arena *arena, const size_t size, const size_t align) {
+    assert(align && !(align & (align - 1)) && "Alignment must be a power of two.");
+    sf_arena_chunk *chunk = arena->head;
+    size_t start = 0;
+    if (chunk) {
+        const uintptr_t base = (uintptr_t)chunk_data(chunk);
+        start = (size_t)(((base + chunk->used + align - 1) & ~(uintptr_t)(align - 1)) - base);
+    }
+
+    if (!chunk || start + REDZONE > chunk->size || chunk->size - start - REDZONE < size) {
+        if (size > SIZE_MAX - align - REDZONE)
+            return NULL;
+        chunk = chunk_new(arena, size + align + REDZONE);
+        if (!chunk)
+            return NULL;
+        chunk->prev = arena->head;
+        arena->head = chunk;
+
+        const uintptr_t base = (uintptr_t)chunk_data(chunk);
+        start = (size_t)(((base + align - 1) & ~(uintptr_t)(align - 1)) - base);
+    }
+
+    uint8_t *ptr = chunk_data(chunk) + start;
+    chunk->used = start + size + REDZONE;
+    __asan_unpoison_memory_region(ptr, size);
+    arena->last = ptr;
+    return ptr;
+}
+
+sf_arena_mark sf_arena_save(const sf_arena *arena) {
+    return (sf_arena_mark) {
+        .chunk = arena->head,
+        .used = arena->head ? arena->head->used : 0,
+    };
+}
+
+void sf_arena_restore(sf_arena *arena, const sf_arena_mark mark) {
+    while (arena->head && arena->head != mark.chunk) {
+        sf_arena_chunk *prev = arena->head->prev;
+        chunk_release(arena, arena->head);
+        arena->head = prev;
+    }
+    if (arena->head && arena->head->used > mark.used) {
+        __asan_poison_memory_region(chunk_data(arena->head) + mark.used, arena->head->used - mark.used);
+        arena->head->used = mark.used;
+    }
+    arena->last = NULL;
+}
+
+static void *arena_alloc(void *ud, const size_t size) {
+    return sf_arena_alloc(ud, size);
+}
+
+static void *arena_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    sf_arena *arena = ud;
+    if (ptr && ptr == arena->last) {
+        // The most recent allocation can grow or shrink in place.
+        sf_arena_chunk *chunk = arena->head;
+        const size_t start = (size_t)((uint8_t *)ptr - chunk_data(chunk));
+        if (chunk->size - start - REDZONE >= size) {
+            if (size < old_size)
+                __asan_poison_memory_region((uint8_t *)ptr + size, old_size - size);
+            else
+                __asan_unpoison_memory_region(ptr, size);
+            chunk->used = start + size + REDZONE;
+            return ptr;
+        }
+    }
+
+    void *out = sf_arena_alloc(arena, size);
+    if (out && ptr)
+        memcpy(out, ptr, min(old_size, size));
+    return out;
+}
+
+static void arena_free(void *ud, void *ptr, const size_t size) {
+    sf_arena *arena = ud;
+    if (!ptr || ptr != arena->last)
+        return;
+    sf_arena_chunk *chunk = arena->head;
+    __asan_poison_memory_region(ptr, size);
+    chunk->used = (size_t)((uint8_t *)ptr - chunk_data(chunk));
+    arena->last = NULL;
+}
+
+sf_allocator sf_arena_allocator(sf_arena *arena) {
+    return (sf_allocator) {
+        .alloc = arena_alloc,
+        .realloc = arena_realloc,
+        .free = arena_free,
+        .ud = arena,
+    };
+}
+
+sf_str sf_str_fmt_arena(sf_arena *arena, const char *format, ...) {
+    const sf_allocator alloc = sf_arena_allocator(arena);
+    va_list arglist;
+    va_start(arglist, format);
+    sf_str out = sf_str_vfmt_in(&alloc, format, arglist);
+    va_end(arglist);
+    out.flags = (uint8_t)(SF_STR_CONST | (out.flags & SF_STR_INLINE));
+    return out;
+}
+
+sf_str sf_str_join_arena(sf_arena *arena, const sf_str str1, const sf_str str2) {
+    const sf_allocator alloc = sf_arena_allocator(arena);
+    sf_str out = sf_str_join_in(&alloc, str1, str2);
+    out.flags = (uint8_t)(SF_STR_CONST | (out.flags & SF_STR_INLINE));
+    return out;
+}
+
+sf_str sf_str_dup_arena(sf_arena *arena, const sf_str string) {
+    const sf_allocator alloc = sf_arena_allocator(arena);
+    sf_str out = sf_str_dup_in(&alloc, string);
+    out.flags = (uint8_t)(SF_STR_CONST | (out.flags & (SF_STR_INLINE | SF_STR_HASHED)));
+    return out;
+}
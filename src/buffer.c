@@ -1,83 +1,140 @@
-#include <stdlib.h>
-#include <string.h>
-#include "sf/containers/buffer.h"
-#include "sf/math.h"
-
-sf_buffer sf_buffer_fixed(const size_t size) {
-    uint8_t *dat = calloc(1, size);
-    return (sf_buffer) {
-        .size = size,
-        .ptr = dat,
-        .head = dat,
-        .flags = 0,
-    };
-}
-
-sf_buffer sf_buffer_grow(void) {
-    return (sf_buffer) {
-        .size = 0,
-        .ptr = NULL,
-        .head = NULL,
-        .flags = SF_BUFFER_GROW | SF_BUFFER_EMPTY,
-    };
-}
-
-sf_buffer sf_buffer_own(uint8_t *existing, const size_t size) {
-    return (sf_buffer) {
-        .size = size,
-        .ptr = existing,
-        .head = existing,
-        .flags = 0,
-    };
-}
-
-sf_buffer_ex sf_buffer_insert(sf_buffer *buffer, const void *const ptr, const size_t size) {
-    const size_t offset = (size_t)(buffer->ptr + buffer->size - buffer->head);
-    if (offset < size) {
-        if (buffer->flags & SF_BUFFER_EMPTY) {
-            buffer->size = size;
-            buffer->ptr = malloc(size);
-            buffer->head = buffer->ptr;
-            buffer->flags &= (uint8_t)~SF_BUFFER_EMPTY;
-        } else if (buffer->flags & SF_BUFFER_GROW) {
-            const long long ofs = buffer->head - buffer->ptr;
-            buffer->size += size - offset;
-            void *p = realloc(buffer->ptr, buffer->size);
-            if (p == NULL)
-                return sf_buffer_ex_err(SF_BUFFER_ALLOC_FAIL);
-            buffer->ptr = p;
-            buffer->head = buffer->ptr + ofs;
-        } else return sf_buffer_ex_err(SF_BUFFER_FULL);
-    }
-
-    memcpy(buffer->head, ptr, size);
-    buffer->head += size;
-    return sf_buffer_ex_ok();
-}
-
-void sf_buffer_seek(sf_buffer *buffer, const sf_buffer_handle handle, const int64_t offset) {
-    switch (handle) {
-        case SF_BUFFER_START:
-            buffer->head = buffer->ptr + min((size_t)offset, buffer->size);
-            break;
-        case SF_BUFFER_END:
-            buffer->head = buffer->ptr + buffer->size - min((size_t)offset, buffer->size);
-            break;
-    }
-}
-
-void sf_buffer_clear(sf_buffer *buffer) {
-    free(buffer->ptr);
-    buffer->ptr = buffer->head = NULL;
-    buffer->size = 0;
-    buffer->flags |= SF_BUFFER_EMPTY;
-}
-
-sf_buffer_ex sf_buffer_read(sf_buffer *buffer, void *dest, const size_t bytes) {
-    if ((uint64_t)(buffer->ptr + buffer->size - buffer->head) < bytes)
-        return sf_buffer_ex_err(SF_BUFFER_OOB);
-
-    memcpy(dest, buffer->head, bytes);
-    buffer->head += bytes;
-    return sf_buffer_ex_ok();
-}
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sf/containers/buffer.h"
+#include "sf/math.h"
+
+sf_buffer sf_buffer_fixed(const size_t size) {
+    return sf_buffer_fixed_in(NULL, size);
+}
+
+sf_buffer sf_buffer_fixed_in(const sf_allocator *alloc, const size_t size) {
+    uint8_t *dat = sf_calloc(alloc, 1, size);
+    return (sf_buffer) {
+        .size = size,
+        .capacity = size,
+        .ptr = dat,
+        .head = dat,
+        .flags = 0,
+        .alloc = alloc,
+    };
+}
+
+sf_buffer sf_buffer_grow(void) {
+    return sf_buffer_grow_in(NULL);
+}
+
+sf_buffer sf_buffer_grow_in(const sf_allocator *alloc) {
+    return (sf_buffer) {
+        .size = 0,
+        .capacity = 0,
+        .ptr = NULL,
+        .head = NULL,
+        .flags = SF_BUFFER_GROW | SF_BUFFER_EMPTY,
+        .alloc = alloc,
+    };
+}
+
+sf_buffer sf_buffer_own(uint8_t *existing, const size_t size) {
+    return (sf_buffer) {
+        .size = size,
+        .capacity = size,
+        .ptr = existing,
+        .head = existing,
+        .flags = 0,
+        .alloc = NULL,
+    };
+}
+
+sf_buffer_ex sf_buffer_reserve(sf_buffer *buffer, const size_t capacity) {
+    if (buffer->flags & SF_BUFFER_READONLY)
+        return sf_buffer_ex_err(SF_BUFFER_NOT_WRITABLE);
+    if (capacity <= buffer->capacity)
+        return sf_buffer_ex_ok();
+    if (!(buffer->flags & (SF_BUFFER_GROW | SF_BUFFER_EMPTY)))
+        return sf_buffer_ex_err(SF_BUFFER_FULL);
+
+    const size_t ofs = (size_t)(buffer->head - buffer->ptr);
+    uint8_t *p = buffer->ptr
+        ? sf_realloc(buffer->alloc, buffer->ptr, buffer->capacity, capacity)
+        : sf_alloc(buffer->alloc, capacity);
+    if (p == NULL)
+        return sf_buffer_ex_err(SF_BUFFER_ALLOC_FAIL);
+    buffer->capacity = capacity;
+    buffer->ptr = p;
+    buffer->head = buffer->ptr + ofs;
+    buffer->flags &= (uint8_t)~SF_BUFFER_EMPTY;
+    return sf_buffer_ex_ok();
+}
+
+/// Make room for `size` bytes at the head, growing geometrically so repeated inserts stay amortized O(1).
+static sf_buffer_ex ensure(sf_buffer *buffer, const size_t size) {
+    if (buffer->flags & SF_BUFFER_READONLY)
+        return sf_buffer_ex_err(SF_BUFFER_NOT_WRITABLE);
+    const size_t offset = (size_t)(buffer->head - buffer->ptr);
+    if (buffer->capacity - offset >= size)
+        return sf_buffer_ex_ok();
+    if (size > SIZE_MAX - offset)
+        return sf_buffer_ex_err(SF_BUFFER_ALLOC_FAIL);
+
+    const size_t needed = offset + size;
+    size_t capacity = max(buffer->capacity, (size_t)SF_BUFFER_MIN_CAPACITY);
+    while (capacity < needed)
+        capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+    return sf_buffer_reserve(buffer, capacity);
+}
+
+sf_buffer_ex sf_buffer_insert(sf_buffer *buffer, const void *const ptr, const size_t size) {
+    const sf_buffer_ex room = ensure(buffer, size);
+    if (!room.is_ok)
+        return room;
+
+    memcpy(buffer->head, ptr, size);
+    sf_buffer_commit(buffer, size);
+    return sf_buffer_ex_ok();
+}
+
+sf_buffer_prep_ex sf_buffer_prepare(sf_buffer *buffer, const size_t size) {
+    const sf_buffer_ex room = ensure(buffer, size);
+    if (!room.is_ok)
+        return sf_buffer_prep_ex_err(room.err);
+    return sf_buffer_prep_ex_ok(buffer->head);
+}
+
+void sf_buffer_commit(sf_buffer *buffer, const size_t size) {
+    assert(buffer->capacity - (size_t)(buffer->head - buffer->ptr) >= size && "Commit past the prepared space.");
+    buffer->head += size;
+    buffer->size = max(buffer->size, (size_t)(buffer->head - buffer->ptr));
+}
+
+void sf_buffer_seek(sf_buffer *buffer, const sf_buffer_handle handle, const int64_t offset) {
+    switch (handle) {
+        case SF_BUFFER_START:
+            buffer->head = buffer->ptr + min((size_t)offset, buffer->size);
+            break;
+        case SF_BUFFER_END:
+            buffer->head = buffer->ptr + buffer->size - min((size_t)offset, buffer->size);
+            break;
+    }
+}
+
+void sf_buffer_clear(sf_buffer *buffer) {
+    if (buffer->ptr)
+        sf_free(buffer->alloc, buffer->ptr, buffer->capacity);
+    buffer->ptr = buffer->head = NULL;
+    buffer->size = buffer->capacity = 0;
+    buffer->flags |= SF_BUFFER_EMPTY;
+}
+
+uint64_t sf_buffer_hash(const sf_buffer *buffer) {
+    return sf_hash64(buffer->ptr, buffer->size);
+}
+
+sf_buffer_ex sf_buffer_read(sf_buffer *buffer, void *dest, const size_t bytes) {
+    if ((uint64_t)(buffer->ptr + buffer->size - buffer->head) < bytes)
+        return sf_buffer_ex_err(SF_BUFFER_OOB);
+
+    memcpy(dest, buffer->head, bytes);
+    buffer->head += bytes;
+    return sf_buffer_ex_ok();
+}
@@ -0,0 +1,71 @@
+#ifndef SF_CPU_H
+#define SF_CPU_H
+
+// Internal helpers for picking vectorized code paths at runtime.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define SF_CPU_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles any intrinsic without per-function targets.
+#define SF_TARGET_AVX2
+#else
+#define SF_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/// True if the running CPU and OS support AVX2.
+static inline bool cpu_has_avx2(void) {
+#if defined(SF_CPU_X86) && defined(_MSC_VER)
+    static int cached = -1;
+    if (cached < 0) {
+        int info[4];
+        bool avx2 = false;
+        __cpuid(info, 0);
+        if (info[0] >= 7) {
+            __cpuid(info, 1);
+            // The OS must save the upper halves of the registers too.
+            if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6) {
+                __cpuidex(info, 7, 0);
+                avx2 = info[1] & (1 << 5);
+            }
+        }
+        cached = avx2;
+    }
+    return cached;
+#elif defined(SF_CPU_X86)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+/// Index of the lowest set bit. `mask` must not be 0.
+static inline uint32_t cpu_ctz32(const uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (uint32_t)i;
+#else
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+/// Amount of set bits.
+static inline uint32_t cpu_popcount32(uint32_t mask) {
+#ifdef _MSC_VER
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    return (((mask + (mask >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+#else
+    return (uint32_t)__builtin_popcount(mask);
+#endif
+}
+
+#endif // SF_CPU_H
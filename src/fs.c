@@ -1,50 +1,953 @@
-#include <stdio.h>
-#include <sys/stat.h>
-#include "sf/fs.h"
-#include "sf/containers/buffer.h"
-
-long sf_file_size(const sf_str path) {
-    struct stat s;
-    if (stat(path.c_str, &s) == -1)
-        return -1;
-    return s.st_size;
-}
-
-sf_fs_ex sf_load_file(uint8_t *out, const sf_str path) {
-    const long size = sf_file_size(path);
-    if (size < 0)
-        return sf_fs_ex_err(SF_FILE_NOT_FOUND);
-    FILE *f = fopen(path.c_str, "rb");
-    if (!f)
-        return sf_fs_ex_err(SF_OPEN_FAILURE);
-
-    // Read into buffer
-    if (fread(out, (size_t)size, 1, f) < 1) {
-        fclose(f);
-        return sf_fs_ex_err(SF_READ_FAILURE);
-    }
-    fclose(f);
-
-    return sf_fs_ex_ok();
-}
-
-sf_fsb_ex sf_file_buffer(sf_str path) {
-    const long size = sf_file_size(path);
-    if (size < 0)
-        return sf_fsb_ex_err(SF_FILE_NOT_FOUND);
-    FILE *f = fopen(path.c_str, "rb");
-    if (!f)
-        return sf_fsb_ex_err(SF_OPEN_FAILURE);
-    sf_buffer out = sf_buffer_fixed((size_t)size);
-    sf_buffer_seek(&out, SF_BUFFER_START, 0);
-
-    // Read into buffer
-    if (fread(out.ptr, (size_t)size, 1, f) < 1) {
-        fclose(f);
-        sf_buffer_clear(&out);
-        return sf_fsb_ex_err(SF_READ_FAILURE);
-    }
-    fclose(f);
-
-    return sf_fsb_ex_ok(out);
-}
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "sf/fs.h"
+#include "sf/containers/buffer.h"
+#include "sf/math.h"
+#include "sf/thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#define sys_open(path) _open(path, _O_RDONLY | _O_BINARY)
+#define sys_read(fd, dest, size) _read(fd, dest, (unsigned)(size))
+#define sys_close _close
+#define sys_fstat _fstat64
+#define sys_stat_path _stat64
+#define sys_create(path, append) _open(path, _O_WRONLY | _O_CREAT | _O_BINARY | ((append) ? _O_APPEND : _O_TRUNC), _S_IREAD | _S_IWRITE)
+#define sys_create_new(path) _open(path, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE)
+#define sys_write(fd, src, size) _write(fd, src, (unsigned)(size))
+#define sys_fsync _commit
+#define sys_getpid _getpid
+typedef struct _stat64 sys_stat;
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define sys_open(path) open(path, O_RDONLY)
+#define sys_read read
+#define sys_close close
+#define sys_fstat fstat
+#define sys_stat_path stat
+#define sys_create(path, append) open(path, O_WRONLY | O_CREAT | ((append) ? O_APPEND : O_TRUNC), 0666)
+#define sys_create_new(path) open(path, O_WRONLY | O_CREAT | O_EXCL, 0666)
+#define sys_write write
+#define sys_fsync fsync
+#define sys_getpid getpid
+typedef struct stat sys_stat;
+#endif
+
+#ifdef SF_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+long sf_file_size(const sf_str path) {
+    struct stat s;
+    if (stat(sf_cstr(path), &s) == -1)
+        return -1;
+    return s.st_size;
+}
+
+sf_fs_ex sf_load_file(uint8_t *out, const sf_str path) {
+    const long size = sf_file_size(path);
+    if (size < 0)
+        return sf_fs_ex_err(SF_FILE_NOT_FOUND);
+    FILE *f = fopen(sf_cstr(path), "rb");
+    if (!f)
+        return sf_fs_ex_err(SF_OPEN_FAILURE);
+
+    // Read into buffer
+    if (fread(out, (size_t)size, 1, f) < 1) {
+        fclose(f);
+        return sf_fs_ex_err(SF_READ_FAILURE);
+    }
+    fclose(f);
+
+    return sf_fs_ex_ok();
+}
+
+sf_fsb_ex sf_file_buffer(sf_str path) {
+    const long size = sf_file_size(path);
+    if (size < 0)
+        return sf_fsb_ex_err(SF_FILE_NOT_FOUND);
+    FILE *f = fopen(sf_cstr(path), "rb");
+    if (!f)
+        return sf_fsb_ex_err(SF_OPEN_FAILURE);
+    sf_buffer out = sf_buffer_fixed((size_t)size);
+    sf_buffer_seek(&out, SF_BUFFER_START, 0);
+
+    // Read into buffer
+    if (fread(out.ptr, (size_t)size, 1, f) < 1) {
+        fclose(f);
+        sf_buffer_clear(&out);
+        return sf_fsb_ex_err(SF_READ_FAILURE);
+    }
+    fclose(f);
+
+    return sf_fsb_ex_ok(out);
+}
+
+#if defined(POSIX_FADV_SEQUENTIAL) && !defined(_WIN32)
+#define SF_HAVE_FADVISE
+#else
+// Placeholders for the advice passed to read_ahead, which does nothing here.
+#define POSIX_FADV_SEQUENTIAL 0
+#define POSIX_FADV_WILLNEED 0
+#endif
+
+/// Hint the kernel to read ahead from `offset`, so the next chunk is loading while this one is parsed.
+static void read_ahead(const sf_file_reader *reader, const int advice) {
+#ifdef SF_HAVE_FADVISE
+    posix_fadvise(fileno(reader->file), (off_t)reader->offset, (off_t)reader->chunk_size * 2, advice);
+#else
+    (void)reader, (void)advice;
+#endif
+}
+
+sf_fsr_ex sf_file_reader_open(const sf_str path, const size_t chunk_size) {
+    FILE *f = fopen(sf_cstr(path), "rb");
+    if (!f)
+        return sf_fsr_ex_err(errno == ENOENT ? SF_FILE_NOT_FOUND : SF_OPEN_FAILURE);
+    // Chunks are read straight into our buffer, stdio's own buffer would only add a copy.
+    setvbuf(f, NULL, _IONBF, 0);
+
+    sf_file_reader reader = {
+        .file = f,
+        .chunk = sf_buffer_grow(),
+        .chunk_size = chunk_size ? chunk_size : SF_READER_CHUNK_SIZE,
+        .start = 0,
+        .end = 0,
+        .offset = 0,
+        .eof = false,
+    };
+    if (!sf_buffer_reserve(&reader.chunk, reader.chunk_size).is_ok) {
+        fclose(f);
+        return sf_fsr_ex_err(SF_READ_FAILURE);
+    }
+    read_ahead(&reader, POSIX_FADV_SEQUENTIAL);
+    return sf_fsr_ex_ok(reader);
+}
+
+void sf_file_reader_close(sf_file_reader *reader) {
+    if (reader->file)
+        fclose(reader->file);
+    reader->file = NULL;
+    sf_buffer_clear(&reader->chunk);
+    reader->start = reader->end = 0;
+}
+
+/// Move the unconsumed bytes to the front of the buffer and read another chunk after them.
+/// Sets `eof` once the file runs out.
+static sf_fs_ex fill(sf_file_reader *reader) {
+    sf_buffer *chunk = &reader->chunk;
+    const size_t pending = reader->end - reader->start;
+    if (pending && reader->start)
+        memmove(chunk->ptr, chunk->ptr + reader->start, pending);
+    reader->start = 0;
+    reader->end = pending;
+
+    // Only a line longer than the buffer makes it grow, doubling so long lines stay linear.
+    if (chunk->capacity - pending < reader->chunk_size) {
+        const size_t capacity = max(pending + reader->chunk_size, chunk->capacity * 2);
+        if (!sf_buffer_reserve(chunk, capacity).is_ok)
+            return sf_fs_ex_err(SF_READ_FAILURE);
+    }
+
+    const size_t read = fread(chunk->ptr + pending, 1, reader->chunk_size, reader->file);
+    if (read < reader->chunk_size) {
+        if (ferror(reader->file))
+            return sf_fs_ex_err(SF_READ_FAILURE);
+        reader->eof = true;
+    }
+    reader->end += read;
+    reader->offset += read;
+    chunk->size = reader->end;
+    if (!reader->eof)
+        read_ahead(reader, POSIX_FADV_WILLNEED);
+    return sf_fs_ex_ok();
+}
+
+/// A view of `len` unconsumed bytes, consuming `consumed` bytes.
+static sf_str take(sf_file_reader *reader, const size_t len, const size_t consumed) {
+    const sf_str out = { .c_str = (char *)reader->chunk.ptr + reader->start, .len = len, .flags = SF_STR_CONST };
+    reader->start += consumed;
+    return out;
+}
+
+sf_fss_ex sf_file_reader_next(sf_file_reader *reader) {
+    if (reader->start == reader->end) {
+        if (reader->eof)
+            return sf_fss_ex_err(SF_EOF);
+        const sf_fs_ex res = fill(reader);
+        if (!res.is_ok)
+            return sf_fss_ex_err(res.err);
+        if (reader->start == reader->end)
+            return sf_fss_ex_err(SF_EOF);
+    }
+    const size_t len = min(reader->end - reader->start, reader->chunk_size);
+    return sf_fss_ex_ok(take(reader, len, len));
+}
+
+sf_fss_ex sf_file_reader_next_line(sf_file_reader *reader) {
+    size_t scanned = 0;
+    for (;;) {
+        const uint8_t *line = reader->chunk.ptr + reader->start;
+        const size_t pending = reader->end - reader->start;
+        const uint8_t *nl = pending > scanned ? memchr(line + scanned, '\n', pending - scanned) : NULL;
+        if (nl) {
+            size_t len = (size_t)(nl - line);
+            if (len && line[len - 1] == '\r')
+                --len;
+            return sf_fss_ex_ok(take(reader, len, (size_t)(nl - line) + 1));
+        }
+
+        if (reader->eof) {
+            // The last line may not end in a newline.
+            if (!pending)
+                return sf_fss_ex_err(SF_EOF);
+            return sf_fss_ex_ok(take(reader, pending, pending));
+        }
+        // The line continues into the next chunk, only the new bytes need scanning.
+        scanned = pending;
+        const sf_fs_ex res = fill(reader);
+        if (!res.is_ok)
+            return sf_fss_ex_err(res.err);
+    }
+}
+
+// Mapped buffers carry this allocator so sf_buffer_clear unmaps them, they can never grow.
+static void *mapping_alloc(void *ud, const size_t size) {
+    (void)ud, (void)size;
+    return NULL;
+}
+static void *mapping_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    (void)ud, (void)ptr, (void)old_size, (void)size;
+    return NULL;
+}
+static void mapping_free(void *ud, void *ptr, const size_t size) {
+    (void)ud;
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(ptr);
+#else
+    munmap(ptr, size);
+#endif
+}
+static const sf_allocator mapping = { mapping_alloc, mapping_realloc, mapping_free, NULL };
+
+/// A read-only buffer over `size` mapped bytes.
+static sf_buffer mapped_buffer(uint8_t *ptr, const size_t size) {
+    return (sf_buffer) {
+        .size = size,
+        .capacity = size,
+        .ptr = ptr,
+        .head = ptr,
+        .flags = (uint8_t)(SF_BUFFER_READONLY | (ptr ? 0 : SF_BUFFER_EMPTY)),
+        .alloc = &mapping,
+    };
+}
+
+#ifdef _WIN32
+
+sf_fsb_ex sf_file_map(const sf_str path, const uint32_t flags) {
+    DWORD attributes = FILE_ATTRIBUTE_NORMAL;
+    if (flags & SF_MAP_SEQUENTIAL) attributes |= FILE_FLAG_SEQUENTIAL_SCAN;
+    if (flags & SF_MAP_RANDOM) attributes |= FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(sf_cstr(path), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, attributes, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return sf_fsb_ex_err(GetLastError() == ERROR_FILE_NOT_FOUND ? SF_FILE_NOT_FOUND : SF_OPEN_FAILURE);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return sf_fsb_ex_err(SF_READ_FAILURE);
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        return sf_fsb_ex_ok(mapped_buffer(NULL, 0));
+    }
+
+    // The view keeps the mapping alive, so both handles can be closed straight away.
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    uint8_t *ptr = map ? MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (map) CloseHandle(map);
+    CloseHandle(file);
+    if (!ptr)
+        return sf_fsb_ex_err(SF_MAP_FAILURE);
+
+    const sf_buffer out = mapped_buffer(ptr, (size_t)size.QuadPart);
+    sf_file_advise(&out, flags);
+    return sf_fsb_ex_ok(out);
+}
+
+void sf_file_advise(const sf_buffer *buffer, const uint32_t flags) {
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    if (buffer->ptr && flags & SF_MAP_WILLNEED) {
+        WIN32_MEMORY_RANGE_ENTRY range = { buffer->ptr, buffer->capacity };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    (void)buffer, (void)flags;
+#endif
+}
+
+#else
+
+sf_fsb_ex sf_file_map(const sf_str path, const uint32_t flags) {
+    const int fd = open(sf_cstr(path), O_RDONLY);
+    if (fd < 0)
+        return sf_fsb_ex_err(errno == ENOENT ? SF_FILE_NOT_FOUND : SF_OPEN_FAILURE);
+
+    struct stat s;
+    if (fstat(fd, &s) == -1) {
+        close(fd);
+        return sf_fsb_ex_err(SF_READ_FAILURE);
+    }
+    if (s.st_size == 0) {
+        close(fd);
+        return sf_fsb_ex_ok(mapped_buffer(NULL, 0));
+    }
+
+    int map_flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (flags & SF_MAP_POPULATE)
+        map_flags |= MAP_POPULATE;
+#endif
+    // The mapping outlives the descriptor, so it can be closed straight away.
+    void *ptr = mmap(NULL, (size_t)s.st_size, PROT_READ, map_flags, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return sf_fsb_ex_err(SF_MAP_FAILURE);
+
+    const sf_buffer out = mapped_buffer(ptr, (size_t)s.st_size);
+    sf_file_advise(&out, flags);
+    return sf_fsb_ex_ok(out);
+}
+
+void sf_file_advise(const sf_buffer *buffer, const uint32_t flags) {
+    if (!buffer->ptr)
+        return;
+    if (flags & SF_MAP_SEQUENTIAL)
+        madvise(buffer->ptr, buffer->capacity, MADV_SEQUENTIAL);
+    if (flags & SF_MAP_RANDOM)
+        madvise(buffer->ptr, buffer->capacity, MADV_RANDOM);
+    if (flags & SF_MAP_WILLNEED)
+        madvise(buffer->ptr, buffer->capacity, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    if (flags & SF_MAP_HUGEPAGES)
+        madvise(buffer->ptr, buffer->capacity, MADV_HUGEPAGE);
+#endif
+}
+
+#endif
+
+static sf_fs_err open_err(void) {
+    return errno == ENOENT ? SF_FILE_NOT_FOUND : SF_OPEN_FAILURE;
+}
+
+/// Write exactly `size` bytes to `fd`.
+static bool write_exact(const int fd, const uint8_t *src, size_t size) {
+    while (size) {
+        const int64_t n = (int64_t)sys_write(fd, src, min(size, (size_t)1 << 30));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        src += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+/// Bytes waiting in a writer's block.
+static size_t pending(const sf_file_writer *writer) {
+    return (size_t)(writer->block.head - writer->block.ptr);
+}
+
+/// Drop the first `size` bytes of a writer's block, once they are written.
+static void writer_drop(sf_file_writer *writer, const size_t size) {
+    const size_t left = pending(writer) - size;
+    if (left && size)
+        memmove(writer->block.ptr, writer->block.ptr + size, left);
+    sf_buffer_seek(&writer->block, SF_BUFFER_START, (int64_t)left);
+}
+
+/// Make everything written to a writer's file durable, counting as a commit.
+static sf_fs_ex writer_sync(sf_file_writer *writer) {
+    writer->commits = 0;
+    return sys_fsync(writer->fd) == 0 ? sf_fs_ex_ok() : sf_fs_ex_err(SF_SYNC_FAILURE);
+}
+
+/// Make a rename in the directory holding `path` durable.
+static bool sync_parent(const sf_str path) {
+#ifdef _WIN32
+    (void)path; // MoveFileEx with MOVEFILE_WRITE_THROUGH already waited for it.
+    return true;
+#else
+    const char *slash = strrchr(sf_cstr(path), '/');
+    sf_str dir = slash ? sf_str_fmt("%.*s", (int)(slash - sf_cstr(path) + 1), sf_cstr(path)) : sf_str_cdup(".");
+    const int fd = !sf_isnull(dir) ? open(sf_cstr(dir), O_RDONLY) : -1;
+    sf_str_free(dir);
+    if (fd < 0)
+        return false;
+    const bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+/// Free everything a writer owns.
+static void writer_release(sf_file_writer *writer) {
+    if (writer->fd >= 0)
+        sys_close(writer->fd);
+    writer->fd = -1;
+    sf_buffer_clear(&writer->block);
+    sf_str_free(writer->path);
+    sf_str_free(writer->temp_path);
+    writer->path = writer->temp_path = SF_STR_EMPTY;
+}
+
+/// Copy the file an atomic appending writer replaces into its temporary file,
+/// using the writer's empty block as scratch. A missing file leaves it empty.
+static sf_fs_ex writer_seed(sf_file_writer *writer) {
+    const int fd = sys_open(sf_cstr(writer->path));
+    if (fd < 0)
+        return errno == ENOENT ? sf_fs_ex_ok() : sf_fs_ex_err(SF_OPEN_FAILURE);
+    sf_fs_err err = SF_EOF;
+    for (;;) {
+        const int64_t n = (int64_t)sys_read(fd, writer->block.ptr, min(writer->block.capacity, (size_t)1 << 30));
+        if (n <= 0) {
+            if (n < 0)
+                err = SF_READ_FAILURE;
+            break;
+        }
+        if (!write_exact(writer->fd, writer->block.ptr, (size_t)n)) {
+            err = SF_WRITE_FAILURE;
+            break;
+        }
+    }
+    sys_close(fd);
+    return err == SF_EOF ? sf_fs_ex_ok() : sf_fs_ex_err(err);
+}
+
+/// Create an atomic writer's temporary file next to its path, under a name no other writer holds.
+/// It takes the permissions of the file it replaces, if there is one.
+static int writer_create_temp(sf_file_writer *writer) {
+    uint64_t name = (uint64_t)time(NULL) ^ (uint64_t)sys_getpid() << 32 ^ (uint64_t)(uintptr_t)writer;
+    int fd = -1;
+    for (int attempt = 0; fd < 0 && attempt < 16; ++attempt) {
+        name = sf_hash_u64(name + (uint64_t)attempt);
+        sf_str_free(writer->temp_path);
+        writer->temp_path = sf_str_fmt("%s.%016llx.tmp", sf_cstr(writer->path), (unsigned long long)name);
+        if (sf_isnull(writer->temp_path))
+            return -1;
+        fd = sys_create_new(sf_cstr(writer->temp_path));
+        if (fd < 0 && errno != EEXIST)
+            return -1;
+    }
+#ifndef _WIN32
+    struct stat s;
+    if (fd >= 0 && stat(sf_cstr(writer->path), &s) == 0 && fchmod(fd, s.st_mode & 07777) != 0) {
+        close(fd);
+        remove(sf_cstr(writer->temp_path));
+        return -1;
+    }
+#endif
+    return fd;
+}
+
+sf_fsw_ex sf_file_writer_open(const sf_str path, const size_t block_size, const uint32_t flags) {
+    const bool atomic = flags & SF_WRITE_ATOMIC;
+    sf_file_writer writer = {
+        .fd = -1,
+        .block = sf_buffer_fixed(block_size ? block_size : SF_WRITER_BLOCK_SIZE),
+        .flags = flags,
+        .path = sf_str_dup(path),
+        .temp_path = SF_STR_EMPTY,
+        .group_size = SF_WRITER_GROUP_SIZE,
+        .commits = 0,
+    };
+    if (!writer.block.ptr || sf_isnull(writer.path)) {
+        writer_release(&writer);
+        return sf_fsw_ex_err(SF_WRITE_FAILURE);
+    }
+
+    // An atomic writer starts from a new temporary file, which an appending one
+    // fills with the current contents so the rename on close keeps them.
+    writer.fd = atomic ? writer_create_temp(&writer) : sys_create(sf_cstr(writer.path), flags & SF_WRITE_APPEND);
+    if (writer.fd < 0) {
+        const sf_fs_err err = open_err();
+        writer_release(&writer);
+        return sf_fsw_ex_err(err);
+    }
+    if (atomic && flags & SF_WRITE_APPEND) {
+        const sf_fs_ex seeded = writer_seed(&writer);
+        if (!seeded.is_ok) {
+            sf_file_writer_abort(&writer);
+            return sf_fsw_ex_err(seeded.err);
+        }
+    }
+    return sf_fsw_ex_ok(writer);
+}
+
+sf_fs_ex sf_file_writer_write(sf_file_writer *writer, const void *data, size_t size) {
+    const uint8_t *src = data;
+    const size_t block_size = writer->block.capacity;
+    const size_t space = block_size - pending(writer);
+    if (size < space) {
+        sf_buffer_insert(&writer->block, src, size);
+        return sf_fs_ex_ok();
+    }
+
+    // Top up and write the current block, then write whole blocks straight from `data`.
+    if (pending(writer)) {
+        sf_buffer_insert(&writer->block, src, space);
+        src += space;
+        size -= space;
+        const sf_fs_ex res = sf_file_writer_flush(writer);
+        if (!res.is_ok)
+            return res;
+    }
+    const size_t direct = size - size % block_size;
+    if (direct && !write_exact(writer->fd, src, direct))
+        return sf_fs_ex_err(SF_WRITE_FAILURE);
+    sf_buffer_insert(&writer->block, src + direct, size - direct);
+    return sf_fs_ex_ok();
+}
+
+sf_fs_ex sf_file_writer_writev(sf_file_writer *writer, const sf_buffer *buffers, const size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+        total += buffers[i].size;
+    if (total < writer->block.capacity - pending(writer)) {
+        for (size_t i = 0; i < count; ++i)
+            if (buffers[i].size)
+                sf_buffer_insert(&writer->block, buffers[i].ptr, buffers[i].size);
+        return sf_fs_ex_ok();
+    }
+
+#ifdef _WIN32
+    sf_fs_ex res = sf_file_writer_flush(writer);
+    for (size_t i = 0; res.is_ok && i < count; ++i)
+        if (!write_exact(writer->fd, buffers[i].ptr, buffers[i].size))
+            res = sf_fs_ex_err(SF_WRITE_FAILURE);
+    return res;
+#else
+    // Gather the buffered block and every buffer into as few writev calls as possible.
+    // The block's bytes are only dropped once written, so a failure leaves the rest in it.
+    enum { BATCH = 64 };
+    struct iovec iov[BATCH];
+    int used = 0;
+    size_t block = pending(writer), block_written = 0;
+    if (block)
+        iov[used++] = (struct iovec) { writer->block.ptr, block };
+
+    for (size_t i = 0; i <= count; ++i) {
+        if (i < count && buffers[i].size)
+            iov[used++] = (struct iovec) { buffers[i].ptr, buffers[i].size };
+        if (used == BATCH || (i == count && used)) {
+            struct iovec *next = iov;
+            while (used) {
+                ssize_t n = writev(writer->fd, next, used);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0) {
+                    writer_drop(writer, block_written);
+                    return sf_fs_ex_err(SF_WRITE_FAILURE);
+                }
+                const size_t from_block = min(block - block_written, (size_t)n);
+                block_written += from_block;
+                // Skip past whatever was written, a short write resumes mid buffer.
+                for (; used && (size_t)n >= next->iov_len; ++next, --used)
+                    n -= (ssize_t)next->iov_len;
+                if (used) {
+                    next->iov_base = (uint8_t *)next->iov_base + n;
+                    next->iov_len -= (size_t)n;
+                }
+            }
+        }
+    }
+    writer_drop(writer, block_written);
+    return sf_fs_ex_ok();
+#endif
+}
+
+sf_fs_ex sf_file_writer_flush(sf_file_writer *writer) {
+    // Bytes leave the block only once written, a failed flush can be retried.
+    while (pending(writer)) {
+        const int64_t n = (int64_t)sys_write(writer->fd, writer->block.ptr, min(pending(writer), (size_t)1 << 30));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return sf_fs_ex_err(SF_WRITE_FAILURE);
+        writer_drop(writer, (size_t)n);
+    }
+    return sf_fs_ex_ok();
+}
+
+sf_fs_ex sf_file_writer_commit(sf_file_writer *writer) {
+    const sf_fs_ex res = sf_file_writer_flush(writer);
+    if (!res.is_ok || !(writer->flags & SF_WRITE_SYNC))
+        return res;
+    if (writer->flags & SF_WRITE_GROUP_COMMIT && ++writer->commits < writer->group_size)
+        return res;
+    return writer_sync(writer);
+}
+
+sf_fs_ex sf_file_writer_close(sf_file_writer *writer) {
+    const bool atomic = writer->flags & SF_WRITE_ATOMIC;
+    sf_fs_ex res = sf_file_writer_flush(writer);
+    // The temporary file must be on disk before the rename can expose it.
+    if (res.is_ok && writer->flags & (SF_WRITE_SYNC | SF_WRITE_ATOMIC))
+        res = writer_sync(writer);
+    sys_close(writer->fd);
+    writer->fd = -1;
+
+    if (atomic) {
+#ifdef _WIN32
+        const bool renamed = res.is_ok && MoveFileExA(sf_cstr(writer->temp_path), sf_cstr(writer->path),
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+        const bool renamed = res.is_ok && rename(sf_cstr(writer->temp_path), sf_cstr(writer->path)) == 0;
+#endif
+        if (res.is_ok && !renamed)
+            res = sf_fs_ex_err(SF_WRITE_FAILURE);
+        if (!renamed)
+            remove(sf_cstr(writer->temp_path));
+        // Without syncing the directory, the rename itself could be lost.
+        else if (!sync_parent(writer->path))
+            res = sf_fs_ex_err(SF_SYNC_FAILURE);
+    }
+    writer_release(writer);
+    return res;
+}
+
+void sf_file_writer_abort(sf_file_writer *writer) {
+    if (writer->fd >= 0) {
+        sys_close(writer->fd);
+        writer->fd = -1;
+        if (writer->flags & SF_WRITE_ATOMIC)
+            remove(sf_cstr(writer->temp_path));
+    }
+    writer_release(writer);
+}
+
+/// Files a worker claims at once, and the depth of its io_uring queue.
+#define BATCH_BLOCK 32
+/// Alignment of each file inside a contiguous batch.
+#define BATCH_ALIGN 16
+
+typedef enum {
+    BATCH_LOAD, // Load each file into its own buffer.
+    BATCH_STAT, // Record each file's size in `sizes`.
+    BATCH_READ, // Read each file into `backing` at `offsets`.
+} batch_phase;
+
+/// Work shared between a batch's threads.
+typedef struct {
+    const sf_str *paths;
+    sf_fsb_ex *results;
+    size_t count;
+    batch_phase phase;
+    size_t *sizes;
+    size_t *offsets;
+    uint8_t *backing;
+    sf_mutex lock;
+    size_t next;
+} batch_job;
+
+// Buffers of a contiguous batch carry this allocator, their storage is freed once with the batch.
+static void *borrowed_alloc(void *ud, const size_t size) {
+    (void)ud, (void)size;
+    return NULL;
+}
+static void *borrowed_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    (void)ud, (void)ptr, (void)old_size, (void)size;
+    return NULL;
+}
+static void borrowed_free(void *ud, void *ptr, const size_t size) {
+    (void)ud, (void)ptr, (void)size;
+}
+static const sf_allocator borrowed = { borrowed_alloc, borrowed_realloc, borrowed_free, NULL };
+
+/// Read exactly `size` bytes from the current position of `fd`.
+static bool read_exact(const int fd, uint8_t *dest, size_t size) {
+    while (size) {
+        const int64_t n = (int64_t)sys_read(fd, dest, min(size, (size_t)1 << 30));
+        if (n <= 0)
+            return false;
+        dest += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+/// Open a file and find its size. Returns -1 and sets `err` on failure.
+static int open_sized(const sf_str path, size_t *size, sf_fs_err *err) {
+    const int fd = sys_open(sf_cstr(path));
+    if (fd < 0) {
+        *err = open_err();
+        return -1;
+    }
+    sys_stat s;
+    if (sys_fstat(fd, &s) == -1 || s.st_size < 0) {
+        sys_close(fd);
+        *err = SF_READ_FAILURE;
+        return -1;
+    }
+    *size = (size_t)s.st_size;
+    return fd;
+}
+
+/// Where file `i` of a batch is read to, allocating its buffer when it has none yet.
+static uint8_t *batch_dest(batch_job *job, const size_t i, const size_t size) {
+    if (job->phase == BATCH_READ) {
+        job->results[i] = sf_fsb_ex_ok((sf_buffer) {
+            .size = size,
+            .capacity = size,
+            .ptr = job->backing + job->offsets[i],
+            .head = job->backing + job->offsets[i],
+            .flags = 0,
+            .alloc = &borrowed,
+        });
+        return job->results[i].ok.ptr;
+    }
+    job->results[i] = sf_fsb_ex_ok(sf_buffer_fixed(size));
+    if (size && !job->results[i].ok.ptr)
+        job->results[i] = sf_fsb_ex_err(SF_READ_FAILURE);
+    return job->results[i].is_ok ? job->results[i].ok.ptr : NULL;
+}
+
+/// Fail file `i` of a batch, releasing its buffer.
+static void batch_fail(batch_job *job, const size_t i, const sf_fs_err err) {
+    if (job->results[i].is_ok)
+        sf_buffer_clear(&job->results[i].ok);
+    job->results[i] = sf_fsb_ex_err(err);
+}
+
+/// Open file `i` of a batch and prepare its destination. Returns -1 once the file is done or failed.
+static int batch_open(batch_job *job, const size_t i, uint8_t **dest, size_t *size) {
+    if (job->phase == BATCH_READ && !job->results[i].is_ok)
+        return -1; // Failed while its size was taken.
+
+    sf_fs_err err = SF_READ_FAILURE;
+    const int fd = open_sized(job->paths[i], size, &err);
+    if (fd < 0) {
+        job->results[i] = sf_fsb_ex_err(err);
+        return -1;
+    }
+    if (job->phase == BATCH_READ && *size != job->sizes[i]) {
+        // Changed since its size was taken, it would overflow its slot.
+        sys_close(fd);
+        job->results[i] = sf_fsb_ex_err(SF_READ_FAILURE);
+        return -1;
+    }
+    *dest = batch_dest(job, i, *size);
+    if (!*dest || !*size) {
+        sys_close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Process the files `[first, last)` of a batch one at a time.
+static void batch_sync(batch_job *job, const size_t first, const size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        if (job->phase == BATCH_STAT) {
+            sys_stat s;
+            if (sys_stat_path(sf_cstr(job->paths[i]), &s) == -1)
+                job->results[i] = sf_fsb_ex_err(open_err());
+            else
+                job->sizes[i] = (size_t)s.st_size;
+            continue;
+        }
+
+        uint8_t *dest = NULL;
+        size_t size = 0;
+        const int fd = batch_open(job, i, &dest, &size);
+        if (fd < 0)
+            continue;
+        if (!read_exact(fd, dest, size))
+            batch_fail(job, i, SF_READ_FAILURE);
+        sys_close(fd);
+    }
+}
+
+#ifdef SF_HAVE_LIBURING
+/// Process the files `[first, last)` of a batch, submitting all of their reads with one system call.
+/// Returns false if the ring failed with reads still in flight, it must not be used again then.
+static bool batch_uring(batch_job *job, struct io_uring *ring, const size_t first, const size_t last) {
+    int fds[BATCH_BLOCK];
+    bool pending[BATCH_BLOCK] = { false };
+    unsigned queued = 0;
+    for (size_t i = first; i < last; ++i) {
+        uint8_t *dest = NULL;
+        size_t size = 0;
+        fds[i - first] = batch_open(job, i, &dest, &size);
+        if (fds[i - first] < 0)
+            continue;
+        struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            if (!read_exact(fds[i - first], dest, size))
+                batch_fail(job, i, SF_READ_FAILURE);
+            continue;
+        }
+        io_uring_prep_read(sqe, fds[i - first], dest, (unsigned)min(size, (size_t)UINT32_MAX >> 1), 0);
+        io_uring_sqe_set_data(sqe, (void *)(uintptr_t)i);
+        pending[i - first] = true;
+        ++queued;
+    }
+
+    // Submissions stop short when interrupted, what is left stays queued in the ring.
+    bool ok = true;
+    for (unsigned submitted = 0; ok && submitted < queued;) {
+        const int res = io_uring_submit(ring);
+        if (res > 0)
+            submitted += (unsigned)res;
+        else if (res != -EINTR)
+            ok = false;
+    }
+    // Every submitted read is reaped before the block ends, so none is left over for the next one.
+    for (unsigned reaped = 0; ok && reaped < queued;) {
+        struct io_uring_cqe *cqe;
+        const int ret = io_uring_wait_cqe(ring, &cqe);
+        if (ret == -EINTR)
+            continue;
+        if (ret < 0) {
+            ok = false;
+            break;
+        }
+        const size_t i = (size_t)(uintptr_t)io_uring_cqe_get_data(cqe);
+        const int res = cqe->res;
+        io_uring_cqe_seen(ring, cqe);
+        pending[i - first] = false;
+        ++reaped;
+
+        // Short reads (or huge files) finish synchronously from where the ring left off.
+        sf_buffer *buffer = &job->results[i].ok;
+        const size_t done = res > 0 ? (size_t)res : 0;
+        if (res < 0 || lseek(fds[i - first], (off_t)done, SEEK_SET) < 0
+            || !read_exact(fds[i - first], buffer->ptr + done, buffer->size - done))
+            batch_fail(job, i, SF_READ_FAILURE);
+    }
+    for (size_t i = first; i < last; ++i) {
+        // The kernel may still be reading into these, so their buffers are leaked rather than freed.
+        if (pending[i - first])
+            job->results[i] = sf_fsb_ex_err(SF_READ_FAILURE);
+        if (fds[i - first] >= 0)
+            sys_close(fds[i - first]);
+    }
+    return ok;
+}
+#endif
+
+/// Claim blocks of a batch until none are left.
+static void batch_worker(void *ud) {
+    batch_job *job = ud;
+#ifdef SF_HAVE_LIBURING
+    struct io_uring ring;
+    // Kernels without io_uring fall back to reading one file at a time.
+    bool uring = job->phase != BATCH_STAT && io_uring_queue_init(BATCH_BLOCK, &ring, 0) == 0;
+#endif
+    for (;;) {
+        sf_mutex_lock(&job->lock);
+        const size_t first = job->next;
+        job->next = min(job->count, first + BATCH_BLOCK);
+        sf_mutex_unlock(&job->lock);
+        if (first >= job->count)
+            break;
+#ifdef SF_HAVE_LIBURING
+        if (uring) {
+            // A broken ring is dropped, the remaining blocks are read synchronously.
+            if (!batch_uring(job, &ring, first, min(job->count, first + BATCH_BLOCK))) {
+                io_uring_queue_exit(&ring);
+                uring = false;
+            }
+            continue;
+        }
+#endif
+        batch_sync(job, first, min(job->count, first + BATCH_BLOCK));
+    }
+#ifdef SF_HAVE_LIBURING
+    if (uring)
+        io_uring_queue_exit(&ring);
+#endif
+}
+
+/// Run one phase of a batch on every worker, the calling thread included.
+static void batch_run(batch_job *job, const batch_phase phase) {
+    job->phase = phase;
+    job->next = 0;
+
+    // Loads are bound by latency rather than CPU, so oversubscribe a little.
+    sf_thread threads[64];
+    const size_t blocks = (job->count + BATCH_BLOCK - 1) / BATCH_BLOCK;
+    const size_t workers = min(min(sf_cpu_count() * 2, (size_t)64), blocks);
+    size_t started = 0;
+    while (started + 1 < workers && sf_thread_start(&threads[started], batch_worker, job))
+        ++started;
+    batch_worker(job);
+    for (size_t i = 0; i < started; ++i)
+        sf_thread_join(threads[i]);
+}
+
+sf_fs_batch sf_fs_batch_load(const sf_str *paths, const size_t count, const uint32_t flags) {
+    sf_fs_batch batch = { .results = NULL, .count = 0, .backing = NULL, .backing_size = 0 };
+    if (!count)
+        return batch;
+    batch_job job = {
+        .paths = paths,
+        .results = calloc(count, sizeof(sf_fsb_ex)),
+        .count = count,
+        .phase = BATCH_LOAD,
+        .sizes = NULL,
+        .offsets = NULL,
+        .backing = NULL,
+        .next = 0,
+    };
+    if (!job.results)
+        return batch;
+    for (size_t i = 0; i < count; ++i)
+        job.results[i] = sf_fsb_ex_ok(sf_buffer_own(NULL, 0));
+    sf_mutex_init(&job.lock);
+
+    if (flags & SF_BATCH_CONTIGUOUS) {
+        job.sizes = calloc(count, sizeof(size_t) * 2);
+        if (job.sizes) {
+            job.offsets = job.sizes + count;
+            batch_run(&job, BATCH_STAT);
+            for (size_t i = 0; i < count; ++i) {
+                job.offsets[i] = batch.backing_size;
+                batch.backing_size += (job.sizes[i] + BATCH_ALIGN - 1) & ~(size_t)(BATCH_ALIGN - 1);
+            }
+            job.backing = malloc(max(batch.backing_size, (size_t)1));
+        }
+    }
+    // Without room for one allocation every file still gets its own.
+    batch_run(&job, job.backing ? BATCH_READ : BATCH_LOAD);
+    free(job.sizes);
+    sf_mutex_destroy(&job.lock);
+
+    batch.results = job.results;
+    batch.count = count;
+    batch.backing = job.backing;
+    if (!batch.backing)
+        batch.backing_size = 0;
+    return batch;
+}
+
+void sf_fs_batch_free(sf_fs_batch *batch) {
+    for (size_t i = 0; i < batch->count; ++i)
+        if (batch->results[i].is_ok)
+            sf_buffer_clear(&batch->results[i].ok);
+    free(batch->results);
+    free(batch->backing);
+    *batch = (sf_fs_batch) { .results = NULL, .count = 0, .backing = NULL, .backing_size = 0 };
+}
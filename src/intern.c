@@ -0,0 +1,137 @@
+#include "sf/intern.h"
+#include "sf/arena.h"
+#include "sf/thread.h"
+
+/// Chunk size of each shard's string storage.
+#define INTERN_CHUNK_SIZE (16 * 1024)
+#define SHARD_BITS 4
+_Static_assert(SF_INTERN_SHARDS == 1 << SHARD_BITS, "SF_INTERN_SHARDS must match SHARD_BITS");
+
+/// A table entry. The length and hash are kept beside the pointer so probing never touches the strings.
+typedef struct {
+    const char *str;
+    size_t len;
+    uint64_t hash;
+} intern_slot;
+
+/// One independently locked part of the table.
+typedef struct {
+    sf_mutex lock;
+    sf_arena strings;
+    intern_slot *slots;
+    size_t capacity; /// Always a power of two.
+    size_t count;
+} intern_shard;
+
+#define SHARD { .lock = SF_MUTEX_INIT, .strings = { .chunk_size = INTERN_CHUNK_SIZE }, .slots = NULL, .capacity = 0, .count = 0 }
+#define SHARD4 SHARD, SHARD, SHARD, SHARD
+static intern_shard shards[SF_INTERN_SHARDS] = { SHARD4, SHARD4, SHARD4, SHARD4 };
+
+/// Find a string's slot in a table, or the empty slot it belongs in.
+static intern_slot *probe(intern_slot *slots, const size_t capacity, const sf_str string, const uint64_t hash) {
+    const size_t mask = capacity - 1;
+    for (size_t i = (size_t)hash & mask;; i = (i + 1) & mask) {
+        intern_slot *slot = &slots[i];
+        if (!slot->str)
+            return slot;
+        if (slot->hash == hash && slot->len == string.len && memcmp(slot->str, sf_cstr(string), string.len) == 0)
+            return slot;
+    }
+}
+
+/// Double a shard's table. The shard must be locked.
+static bool grow(intern_shard *shard) {
+    const size_t capacity = shard->capacity ? shard->capacity * 2 : 64;
+    intern_slot *slots = calloc(capacity, sizeof(intern_slot));
+    if (!slots)
+        return false;
+    // Every string is distinct, so each only needs an empty slot.
+    for (size_t i = 0; i < shard->capacity; ++i) {
+        const intern_slot *slot = &shard->slots[i];
+        if (!slot->str)
+            continue;
+        size_t j = (size_t)slot->hash & (capacity - 1);
+        while (slots[j].str)
+            j = (j + 1) & (capacity - 1);
+        slots[j] = *slot;
+    }
+    free(shard->slots);
+    shard->slots = slots;
+    shard->capacity = capacity;
+    return true;
+}
+
+static sf_str interned(const intern_slot *slot) {
+    return (sf_str) { .c_str = (char *)slot->str, .len = slot->len, .flags = SF_STR_CONST | SF_STR_INTERNED };
+}
+
+static intern_shard *shard_for(const uint64_t hash) {
+    return &shards[hash >> (64 - SHARD_BITS)];
+}
+
+sf_str sf_intern(const sf_str string) {
+    if (string.flags & SF_STR_INTERNED)
+        return string;
+    const uint64_t hash = sf_str_hash(string);
+    intern_shard *shard = shard_for(hash);
+    sf_mutex_lock(&shard->lock);
+
+    if ((shard->count + 1) * 4 > shard->capacity * 3 && !grow(shard)) {
+        sf_mutex_unlock(&shard->lock);
+        return SF_STR_EMPTY;
+    }
+    intern_slot *slot = probe(shard->slots, shard->capacity, string, hash);
+    if (!slot->str) {
+        // The hash sits right before the bytes, where sf_str_hash expects it.
+        uint64_t *header = sf_arena_alloc_aligned(&shard->strings, sizeof(uint64_t) + string.len + 1, _Alignof(uint64_t));
+        if (!header) {
+            sf_mutex_unlock(&shard->lock);
+            return SF_STR_EMPTY;
+        }
+        *header = hash;
+        char *bytes = (char *)(header + 1);
+        if (string.len)
+            memcpy(bytes, sf_cstr(string), string.len);
+        bytes[string.len] = '\0';
+        *slot = (intern_slot) { bytes, string.len, hash };
+        ++shard->count;
+    }
+
+    const sf_str out = interned(slot);
+    sf_mutex_unlock(&shard->lock);
+    return out;
+}
+
+sf_str sf_intern_find(const sf_str string) {
+    if (string.flags & SF_STR_INTERNED)
+        return string;
+    const uint64_t hash = sf_str_hash(string);
+    intern_shard *shard = shard_for(hash);
+    sf_mutex_lock(&shard->lock);
+    const intern_slot *slot = shard->capacity ? probe(shard->slots, shard->capacity, string, hash) : NULL;
+    const sf_str out = slot && slot->str ? interned(slot) : SF_STR_EMPTY;
+    sf_mutex_unlock(&shard->lock);
+    return out;
+}
+
+size_t sf_intern_count(void) {
+    size_t count = 0;
+    for (size_t i = 0; i < SF_INTERN_SHARDS; ++i) {
+        sf_mutex_lock(&shards[i].lock);
+        count += shards[i].count;
+        sf_mutex_unlock(&shards[i].lock);
+    }
+    return count;
+}
+
+void sf_intern_free(void) {
+    for (size_t i = 0; i < SF_INTERN_SHARDS; ++i) {
+        intern_shard *shard = &shards[i];
+        sf_mutex_lock(&shard->lock);
+        sf_arena_free(&shard->strings);
+        free(shard->slots);
+        shard->slots = NULL;
+        shard->capacity = shard->count = 0;
+        sf_mutex_unlock(&shard->lock);
+    }
+}
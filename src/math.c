@@ -1,12 +1,937 @@
-#include <assert.h>
-#include "sf/math.h"
-
-uint32_t sf_fnv1a(const void *data, size_t size) {
-    const unsigned char *head = data;
-    uint32_t hash = SF_FNV1A_SEED;
-    while (size--) {
-        const unsigned char cc = *head++;
-        hash = (cc ^ hash) * SF_FNV1A_PRIME;
-    }
-    return hash;
-}
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "sf/math.h"
+#include "sf/thread.h"
+#include "cpu.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+uint32_t sf_fnv1a(const void *data, size_t size) {
+    const unsigned char *head = data;
+    uint32_t hash = SF_FNV1A_SEED;
+    while (size--) {
+        const unsigned char cc = *head++;
+        hash = (cc ^ hash) * SF_FNV1A_PRIME;
+    }
+    return hash;
+}
+
+// sf_hash64 follows wyhash (Wang Yi): inputs are folded 16 bytes at a time by multiplying them
+// into 128 bits and xoring the halves, with three independent lanes over 48 byte blocks.
+
+static const uint64_t secret[4] = { 0x2D358DCCAA6C78A5ull, 0x8BB84B93962EACC9ull, 0x4B33A62ED433D4A3ull, 0x4D5A2DA51DE1AA47ull };
+
+/// The 128-bit product of `a` and `b`, as its high half and its low half in `low`.
+static uint64_t mul_128(const uint64_t a, const uint64_t b, uint64_t *low) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ const unsigned __int128 product = (unsigned __int128)a * b;
+    *low = (uint64_t)product;
+    return (uint64_t)(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high;
+    *low = _umul128(a, b, &high);
+    return high;
+#else
+    const uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+    const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    const uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+    *low = (cross << 32) | (uint32_t)lo_lo;
+    return (hi_lo >> 32) + (cross >> 32) + hi_hi;
+#endif
+}
+
+static uint64_t mix(const uint64_t a, const uint64_t b) {
+    uint64_t low;
+    return mul_128(a, b, &low) ^ low;
+}
+
+static uint64_t read64(const uint8_t *p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t read32(const uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/// Fold a 48 byte block into the seed and the two extra lanes.
+static void fold_block(uint64_t *seed, uint64_t lanes[2], const uint8_t *p) {
+    *seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ *seed);
+    lanes[0] = mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ lanes[0]);
+    lanes[1] = mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ lanes[1]);
+}
+
+static uint64_t finish(uint64_t a, uint64_t b, const uint64_t seed, const uint64_t total) {
+    a ^= secret[1];
+    b ^= seed;
+    b = mul_128(a, b, &a);
+    return mix(a ^ secret[0] ^ total, b ^ secret[1]);
+}
+
+/// Hash the last 1 to 48 bytes of an input longer than 16 bytes.
+/// The final 16 bytes are read as a whole, so up to 16 bytes before `p` must be readable.
+static uint64_t finish_long(uint64_t seed, const uint8_t *p, size_t size, const uint64_t total) {
+    for (; size > 16; size -= 16, p += 16)
+        seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+    return finish(read64(p + size - 16), read64(p + size - 8), seed, total);
+}
+
+uint64_t sf_hash64_seeded(const void *data, const size_t size, uint64_t seed) {
+    const uint8_t *p = data;
+    seed ^= mix(seed ^ secret[0], secret[1]);
+    if (size <= 16) {
+        uint64_t a = 0, b = 0;
+        if (size >= 4) {
+            // Two possibly overlapping reads from each end cover every byte.
+            const size_t step = (size >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + step);
+            b = (read32(p + size - 4) << 32) | read32(p + size - 4 - step);
+        } else if (size) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[size >> 1] << 8) | p[size - 1];
+        }
+        return finish(a, b, seed, size);
+    }
+
+    size_t left = size;
+    if (left > 48) {
+        uint64_t lanes[2] = { seed, seed };
+        do {
+            fold_block(&seed, lanes, p);
+            p += 48;
+            left -= 48;
+        } while (left > 48);
+        seed ^= lanes[0] ^ lanes[1];
+    }
+    return finish_long(seed, p, left, size);
+}
+
+void sf_hash_init(sf_hash_state *state, const uint64_t seed) {
+    state->initial_seed = seed;
+    state->seed = seed ^ mix(seed ^ secret[0], secret[1]);
+    state->lanes[0] = state->lanes[1] = state->seed;
+    state->total = 0;
+    state->pending = 0;
+}
+
+void sf_hash_update(sf_hash_state *state, const void *data, size_t size) {
+    const uint8_t *p = data;
+    uint8_t *pending = state->buffer + 16;
+    state->total += size;
+    // The last bytes are hashed differently, so a block is only folded once more input follows it.
+    if (state->pending + size <= 48) {
+        if (size)
+            memcpy(pending + state->pending, p, size);
+        state->pending += size;
+        return;
+    }
+
+    const uint8_t *last_block = pending;
+    if (state->pending) {
+        const size_t fill = 48 - state->pending;
+        memcpy(pending + state->pending, p, fill);
+        p += fill;
+        size -= fill;
+        fold_block(&state->seed, state->lanes, pending);
+    }
+    for (; size > 48; p += 48, size -= 48) {
+        fold_block(&state->seed, state->lanes, p);
+        last_block = p;
+    }
+    memcpy(state->buffer, last_block + 32, 16);
+    memcpy(pending, p, size);
+    state->pending = size;
+}
+
+uint64_t sf_hash_final(const sf_hash_state *state) {
+    const uint8_t *pending = state->buffer + 16;
+    if (state->total <= 48)
+        return sf_hash64_seeded(pending, state->pending, state->initial_seed);
+    return finish_long(state->seed ^ state->lanes[0] ^ state->lanes[1], pending, state->pending, state->total);
+}
+
+// Batch vector kernels run over each component array 4 floats at a time with SSE or 8 with AVX,
+// and over the tail with scalar code doing the same operations in the same order, so results
+// don't depend on which path ran. Add and sub are a + b * 1 and a + b * -1, which round identically.
+
+/// Operations applied to one component array at a time.
+typedef enum {
+    LANES_FMA, // out = a + b * factor
+    LANES_MULF, // out = a * factor
+    LANES_MULV, // out = a * b
+} lanes_op;
+
+static void lanes_scalar(float *out, const float *a, const float *b, const float factor, size_t i, const size_t n, const lanes_op op) {
+    switch (op) {
+    case LANES_FMA:
+        for (; i < n; ++i)
+            out[i] = a[i] + b[i] * factor;
+        break;
+    case LANES_MULF:
+        for (; i < n; ++i)
+            out[i] = a[i] * factor;
+        break;
+    case LANES_MULV:
+        for (; i < n; ++i)
+            out[i] = a[i] * b[i];
+        break;
+    }
+}
+
+/// out = a . b for each element (its square root when `root`), summing over `dims` component arrays.
+static void dot_scalar(float *out, const float *const *a, const float *const *b, const size_t dims, size_t i, const size_t n, const bool root) {
+    for (; i < n; ++i) {
+        float sum = 0;
+        for (size_t d = 0; d < dims; ++d)
+            sum += a[d][i] * b[d][i];
+        out[i] = root ? sqrtf(sum) : sum;
+    }
+}
+
+static void normalize_scalar(float *const *out, const float *const *a, const size_t dims, size_t i, const size_t n) {
+    for (; i < n; ++i) {
+        float sum = 0;
+        for (size_t d = 0; d < dims; ++d)
+            sum += a[d][i] * a[d][i];
+        const float inv = sum > 0 ? 1 / sqrtf(sum) : 0;
+        for (size_t d = 0; d < dims; ++d)
+            out[d][i] = a[d][i] * inv;
+    }
+}
+
+#ifdef SF_CPU_X86
+static void lanes_sse(float *out, const float *a, const float *b, const float factor, const size_t n, const lanes_op op) {
+    const __m128 f = _mm_set1_ps(factor);
+    size_t i = 0;
+    switch (op) {
+    case LANES_FMA:
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_mul_ps(_mm_loadu_ps(b + i), f)));
+        break;
+    case LANES_MULF:
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), f));
+        break;
+    case LANES_MULV:
+        for (; i + 4 <= n; i += 4)
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        break;
+    }
+    lanes_scalar(out, a, b, factor, i, n, op);
+}
+
+SF_TARGET_AVX2 static void lanes_avx(float *out, const float *a, const float *b, const float factor, const size_t n, const lanes_op op) {
+    const __m256 f = _mm256_set1_ps(factor);
+    size_t i = 0;
+    switch (op) {
+    case LANES_FMA:
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_mul_ps(_mm256_loadu_ps(b + i), f)));
+        break;
+    case LANES_MULF:
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), f));
+        break;
+    case LANES_MULV:
+        for (; i + 8 <= n; i += 8)
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        break;
+    }
+    lanes_scalar(out, a, b, factor, i, n, op);
+}
+
+static void dot_sse(float *out, const float *const *a, const float *const *b, const size_t dims, const size_t n, const bool root) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (size_t d = 0; d < dims; ++d)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a[d] + i), _mm_loadu_ps(b[d] + i)));
+        _mm_storeu_ps(out + i, root ? _mm_sqrt_ps(sum) : sum);
+    }
+    dot_scalar(out, a, b, dims, i, n, root);
+}
+
+SF_TARGET_AVX2 static void dot_avx(float *out, const float *const *a, const float *const *b, const size_t dims, const size_t n, const bool root) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (size_t d = 0; d < dims; ++d)
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(a[d] + i), _mm256_loadu_ps(b[d] + i)));
+        _mm256_storeu_ps(out + i, root ? _mm256_sqrt_ps(sum) : sum);
+    }
+    dot_scalar(out, a, b, dims, i, n, root);
+}
+
+static void normalize_sse(float *const *out, const float *const *a, const size_t dims, const size_t n) {
+    const __m128 one = _mm_set1_ps(1), zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 sum = zero;
+        for (size_t d = 0; d < dims; ++d) {
+            const __m128 v = _mm_loadu_ps(a[d] + i);
+            sum = _mm_add_ps(sum, _mm_mul_ps(v, v));
+        }
+        // 1 / sqrt(0) is infinite, the mask turns it into 0.
+        const __m128 inv = _mm_and_ps(_mm_div_ps(one, _mm_sqrt_ps(sum)), _mm_cmpgt_ps(sum, zero));
+        for (size_t d = 0; d < dims; ++d)
+            _mm_storeu_ps(out[d] + i, _mm_mul_ps(_mm_loadu_ps(a[d] + i), inv));
+    }
+    normalize_scalar(out, a, dims, i, n);
+}
+
+SF_TARGET_AVX2 static void normalize_avx(float *const *out, const float *const *a, const size_t dims, const size_t n) {
+    const __m256 one = _mm256_set1_ps(1), zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 sum = zero;
+        for (size_t d = 0; d < dims; ++d) {
+            const __m256 v = _mm256_loadu_ps(a[d] + i);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(v, v));
+        }
+        const __m256 inv = _mm256_and_ps(_mm256_div_ps(one, _mm256_sqrt_ps(sum)), _mm256_cmp_ps(sum, zero, _CMP_GT_OQ));
+        for (size_t d = 0; d < dims; ++d)
+            _mm256_storeu_ps(out[d] + i, _mm256_mul_ps(_mm256_loadu_ps(a[d] + i), inv));
+    }
+    normalize_scalar(out, a, dims, i, n);
+}
+#endif
+
+static void lanes(float *const *out, const float *const *a, const float *const *b, const size_t dims, const float factor, const size_t n, const lanes_op op) {
+    for (size_t d = 0; d < dims; ++d) {
+#ifdef SF_CPU_X86
+        if (cpu_has_avx2())
+            lanes_avx(out[d], a[d], b ? b[d] : NULL, factor, n, op);
+        else
+            lanes_sse(out[d], a[d], b ? b[d] : NULL, factor, n, op);
+#else
+        lanes_scalar(out[d], a[d], b ? b[d] : NULL, factor, 0, n, op);
+#endif
+    }
+}
+
+static void dot(float *out, const float *const *a, const float *const *b, const size_t dims, const size_t n, const bool root) {
+#ifdef SF_CPU_X86
+    if (cpu_has_avx2())
+        dot_avx(out, a, b, dims, n, root);
+    else
+        dot_sse(out, a, b, dims, n, root);
+#else
+    dot_scalar(out, a, b, dims, 0, n, root);
+#endif
+}
+
+static void normalize(float *const *out, const float *const *a, const size_t dims, const size_t n) {
+#ifdef SF_CPU_X86
+    if (cpu_has_avx2())
+        normalize_avx(out, a, dims, n);
+    else
+        normalize_sse(out, a, dims, n);
+#else
+    normalize_scalar(out, a, dims, 0, n);
+#endif
+}
+
+/// Floats per component array, rounded up so each array starts 32 byte aligned.
+static size_t soa_stride(const size_t len) {
+    return (len + 7) & ~(size_t)7;
+}
+
+/// Bytes of the block holding `dims` arrays of `len` floats, with room to align the first one.
+static size_t soa_block_size(const size_t len, const size_t dims) {
+    return soa_stride(len) * dims * sizeof(float) + 32;
+}
+
+/// Allocate `dims` zeroed arrays of `len` floats in one block, and point `arrays` at them.
+static void *soa_alloc(const sf_allocator *alloc, const size_t len, const size_t dims, float **arrays) {
+    if (len > (SIZE_MAX - 64) / (dims * sizeof(float)))
+        return NULL;
+    void *block = sf_calloc(alloc, 1, soa_block_size(len, dims));
+    if (!block)
+        return NULL;
+    float *first = (float *)(void *)(((uintptr_t)block + 31) & ~(uintptr_t)31);
+    for (size_t d = 0; d < dims; ++d)
+        arrays[d] = first + d * soa_stride(len);
+    return block;
+}
+
+#define VEC2_ARRAYS(soa) { (soa)->x, (soa)->y }
+#define VEC3_ARRAYS(soa) { (soa)->x, (soa)->y, (soa)->z }
+
+sf_vec2_soa sf_vec2_soa_new_in(const sf_allocator *alloc, const size_t len) {
+    float *arrays[2] = { NULL, NULL };
+    void *block = soa_alloc(alloc, len, 2, arrays);
+    return (sf_vec2_soa){ .x = arrays[0], .y = arrays[1], .len = block ? len : 0, .block = block, .alloc = alloc };
+}
+
+void sf_vec2_soa_free(sf_vec2_soa *soa) {
+    if (soa->block)
+        sf_free(soa->alloc, soa->block, soa_block_size(soa->len, 2));
+    *soa = (sf_vec2_soa){ .x = NULL, .y = NULL, .len = 0, .block = NULL, .alloc = NULL };
+}
+
+void sf_vec2_soa_from_aos(sf_vec2_soa *soa, const sf_vec2 *vectors) {
+    for (size_t i = 0; i < soa->len; ++i) {
+        soa->x[i] = vectors[i].x;
+        soa->y[i] = vectors[i].y;
+    }
+}
+
+void sf_vec2_soa_to_aos(const sf_vec2_soa *soa, sf_vec2 *vectors) {
+    for (size_t i = 0; i < soa->len; ++i)
+        vectors[i] = (sf_vec2){soa->x[i], soa->y[i]};
+}
+
+void sf_vec2_soa_add(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *second) {
+    assert(first->len >= out->len && second->len >= out->len);
+    float *const o[] = VEC2_ARRAYS(out);
+    const float *const a[] = VEC2_ARRAYS(first), *const b[] = VEC2_ARRAYS(second);
+    lanes(o, a, b, 2, 1, out->len, LANES_FMA);
+}
+
+void sf_vec2_soa_sub(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *second) {
+    assert(first->len >= out->len && second->len >= out->len);
+    float *const o[] = VEC2_ARRAYS(out);
+    const float *const a[] = VEC2_ARRAYS(first), *const b[] = VEC2_ARRAYS(second);
+    lanes(o, a, b, 2, -1, out->len, LANES_FMA);
+}
+
+void sf_vec2_soa_multv(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *factor) {
+    assert(first->len >= out->len && factor->len >= out->len);
+    float *const o[] = VEC2_ARRAYS(out);
+    const float *const a[] = VEC2_ARRAYS(first), *const b[] = VEC2_ARRAYS(factor);
+    lanes(o, a, b, 2, 0, out->len, LANES_MULV);
+}
+
+void sf_vec2_soa_multf(sf_vec2_soa *out, const sf_vec2_soa *first, const float factor) {
+    assert(first->len >= out->len);
+    float *const o[] = VEC2_ARRAYS(out);
+    const float *const a[] = VEC2_ARRAYS(first);
+    lanes(o, a, NULL, 2, factor, out->len, LANES_MULF);
+}
+
+void sf_vec2_soa_fma(sf_vec2_soa *out, const sf_vec2_soa *first, const sf_vec2_soa *second, const float factor) {
+    assert(first->len >= out->len && second->len >= out->len);
+    float *const o[] = VEC2_ARRAYS(out);
+    const float *const a[] = VEC2_ARRAYS(first), *const b[] = VEC2_ARRAYS(second);
+    lanes(o, a, b, 2, factor, out->len, LANES_FMA);
+}
+
+void sf_vec2_soa_dot(float *out, const sf_vec2_soa *first, const sf_vec2_soa *second) {
+    assert(second->len >= first->len);
+    const float *const a[] = VEC2_ARRAYS(first), *const b[] = VEC2_ARRAYS(second);
+    dot(out, a, b, 2, first->len, false);
+}
+
+void sf_vec2_soa_length(float *out, const sf_vec2_soa *vectors) {
+    const float *const a[] = VEC2_ARRAYS(vectors);
+    dot(out, a, a, 2, vectors->len, true);
+}
+
+void sf_vec2_soa_normalize(sf_vec2_soa *out, const sf_vec2_soa *vectors) {
+    assert(vectors->len >= out->len);
+    float *const o[] = VEC2_ARRAYS(out);
+    const float *const a[] = VEC2_ARRAYS(vectors);
+    normalize(o, a, 2, out->len);
+}
+
+sf_vec3_soa sf_vec3_soa_new_in(const sf_allocator *alloc, const size_t len) {
+    float *arrays[3] = { NULL, NULL, NULL };
+    void *block = soa_alloc(alloc, len, 3, arrays);
+    return (sf_vec3_soa){ .x = arrays[0], .y = arrays[1], .z = arrays[2], .len = block ? len : 0, .block = block, .alloc = alloc };
+}
+
+void sf_vec3_soa_free(sf_vec3_soa *soa) {
+    if (soa->block)
+        sf_free(soa->alloc, soa->block, soa_block_size(soa->len, 3));
+    *soa = (sf_vec3_soa){ .x = NULL, .y = NULL, .z = NULL, .len = 0, .block = NULL, .alloc = NULL };
+}
+
+void sf_vec3_soa_from_aos(sf_vec3_soa *soa, const sf_vec3 *vectors) {
+    for (size_t i = 0; i < soa->len; ++i) {
+        soa->x[i] = vectors[i].x;
+        soa->y[i] = vectors[i].y;
+        soa->z[i] = vectors[i].z;
+    }
+}
+
+void sf_vec3_soa_to_aos(const sf_vec3_soa *soa, sf_vec3 *vectors) {
+    for (size_t i = 0; i < soa->len; ++i)
+        vectors[i] = (sf_vec3){soa->x[i], soa->y[i], soa->z[i]};
+}
+
+void sf_vec3_soa_add(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *second) {
+    assert(first->len >= out->len && second->len >= out->len);
+    float *const o[] = VEC3_ARRAYS(out);
+    const float *const a[] = VEC3_ARRAYS(first), *const b[] = VEC3_ARRAYS(second);
+    lanes(o, a, b, 3, 1, out->len, LANES_FMA);
+}
+
+void sf_vec3_soa_sub(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *second) {
+    assert(first->len >= out->len && second->len >= out->len);
+    float *const o[] = VEC3_ARRAYS(out);
+    const float *const a[] = VEC3_ARRAYS(first), *const b[] = VEC3_ARRAYS(second);
+    lanes(o, a, b, 3, -1, out->len, LANES_FMA);
+}
+
+void sf_vec3_soa_multv(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *factor) {
+    assert(first->len >= out->len && factor->len >= out->len);
+    float *const o[] = VEC3_ARRAYS(out);
+    const float *const a[] = VEC3_ARRAYS(first), *const b[] = VEC3_ARRAYS(factor);
+    lanes(o, a, b, 3, 0, out->len, LANES_MULV);
+}
+
+void sf_vec3_soa_multf(sf_vec3_soa *out, const sf_vec3_soa *first, const float factor) {
+    assert(first->len >= out->len);
+    float *const o[] = VEC3_ARRAYS(out);
+    const float *const a[] = VEC3_ARRAYS(first);
+    lanes(o, a, NULL, 3, factor, out->len, LANES_MULF);
+}
+
+void sf_vec3_soa_fma(sf_vec3_soa *out, const sf_vec3_soa *first, const sf_vec3_soa *second, const float factor) {
+    assert(first->len >= out->len && second->len >= out->len);
+    float *const o[] = VEC3_ARRAYS(out);
+    const float *const a[] = VEC3_ARRAYS(first), *const b[] = VEC3_ARRAYS(second);
+    lanes(o, a, b, 3, factor, out->len, LANES_FMA);
+}
+
+void sf_vec3_soa_dot(float *out, const sf_vec3_soa *first, const sf_vec3_soa *second) {
+    assert(second->len >= first->len);
+    const float *const a[] = VEC3_ARRAYS(first), *const b[] = VEC3_ARRAYS(second);
+    dot(out, a, b, 3, first->len, false);
+}
+
+void sf_vec3_soa_length(float *out, const sf_vec3_soa *vectors) {
+    const float *const a[] = VEC3_ARRAYS(vectors);
+    dot(out, a, a, 3, vectors->len, true);
+}
+
+void sf_vec3_soa_normalize(sf_vec3_soa *out, const sf_vec3_soa *vectors) {
+    assert(vectors->len >= out->len);
+    float *const o[] = VEC3_ARRAYS(out);
+    const float *const a[] = VEC3_ARRAYS(vectors);
+    normalize(o, a, 3, out->len);
+}
+
+sf_quat sf_quat_from_euler(const sf_vec3 radians) {
+    const sf_quat x = sf_quat_from_axis((sf_vec3){1, 0, 0}, radians.x);
+    const sf_quat y = sf_quat_from_axis((sf_vec3){0, 1, 0}, radians.y);
+    const sf_quat z = sf_quat_from_axis((sf_vec3){0, 0, 1}, radians.z);
+    return sf_quat_mul(z, sf_quat_mul(y, x));
+}
+
+sf_quat sf_quat_from_axis(const sf_vec3 axis, const float radians) {
+    const float s = sinf(radians / 2);
+    return (sf_quat){axis.x * s, axis.y * s, axis.z * s, cosf(radians / 2)};
+}
+
+sf_mat4 sf_mat4_mul(const sf_mat4 first, const sf_mat4 second) {
+    // Each column of the result is the columns of `first` weighted by a column of `second`.
+    sf_mat4 out;
+#ifdef SF_CPU_X86
+    const __m128 a0 = _mm_loadu_ps(first.m), a1 = _mm_loadu_ps(first.m + 4);
+    const __m128 a2 = _mm_loadu_ps(first.m + 8), a3 = _mm_loadu_ps(first.m + 12);
+    for (size_t c = 0; c < 4; ++c) {
+        const float *b = second.m + c * 4;
+        __m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[0]));
+        column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[1])));
+        column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[2])));
+        column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[3])));
+        _mm_storeu_ps(out.m + c * 4, column);
+    }
+#else
+    for (size_t c = 0; c < 4; ++c) {
+        const float *b = second.m + c * 4;
+        for (size_t r = 0; r < 4; ++r)
+            out.m[c * 4 + r] = first.m[r] * b[0] + first.m[4 + r] * b[1] + first.m[8 + r] * b[2] + first.m[12 + r] * b[3];
+    }
+#endif
+    return out;
+}
+
+sf_mat4 sf_mat4_from_trs(const sf_vec3 position, const sf_quat rotation, const sf_vec3 scale) {
+    const float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    const float xx = x * x, yy = y * y, zz = z * z, xy = x * y, xz = x * z, yz = y * z, wx = w * x, wy = w * y, wz = w * z;
+    return (sf_mat4){{
+        (1 - 2 * (yy + zz)) * scale.x, 2 * (xy + wz) * scale.x, 2 * (xz - wy) * scale.x, 0,
+        2 * (xy - wz) * scale.y, (1 - 2 * (xx + zz)) * scale.y, 2 * (yz + wx) * scale.y, 0,
+        2 * (xz + wy) * scale.z, 2 * (yz - wx) * scale.z, (1 - 2 * (xx + yy)) * scale.z, 0,
+        position.x, position.y, position.z, 1,
+    }};
+}
+
+sf_mat4 sf_transform_local(const sf_transform *transform) {
+    return sf_mat4_from_trs(transform->position, sf_quat_from_euler(transform->rotation), transform->scale);
+}
+
+sf_mat4 sf_transform_world(const sf_transform *transform) {
+    sf_mat4 world = sf_transform_local(transform);
+    for (const sf_transform *parent = transform->parent; parent; parent = parent->parent)
+        world = sf_mat4_mul(sf_transform_local(parent), world);
+    return world;
+}
+
+// Transform graphs keep every parent in a lower slot than its children. Changes only flag a node dirty,
+// the update walks the slots in order from the first dirty one and passes the flag on from parents to
+// children, so a changed node's whole subtree is recomputed after its parent's matrix is.
+
+#define NODE_DIRTY (uint8_t)(1u << 0)
+#define NODE_MARKED (uint8_t)(1u << 1)
+
+sf_transform_graph sf_transform_graph_new(void) {
+    return sf_transform_graph_new_in(NULL);
+}
+
+sf_transform_graph sf_transform_graph_new_in(const sf_allocator *alloc) {
+    return (sf_transform_graph){
+        .worlds = NULL, .locals = NULL, .parents = NULL, .ids = NULL, .slots = NULL, .flags = NULL,
+        .count = 0, .capacity = 0, .first_dirty = 0, .free_id = SF_TRANSFORM_NONE, .alloc = alloc,
+    };
+}
+
+/// Bytes of the block holding every array of a graph with room for `capacity` nodes.
+static size_t graph_block_size(const size_t capacity) {
+    return capacity * (sizeof(sf_mat4) + sizeof(sf_transform) + 3 * sizeof(uint32_t) + sizeof(uint8_t));
+}
+
+void sf_transform_graph_free(sf_transform_graph *graph) {
+    if (graph->worlds)
+        sf_free(graph->alloc, graph->worlds, graph_block_size(graph->capacity));
+    *graph = sf_transform_graph_new_in(graph->alloc);
+}
+
+/// Move every array into one new block with room for `capacity` nodes.
+static bool graph_grow(sf_transform_graph *graph, const size_t capacity) {
+    if (capacity > UINT32_MAX || capacity > SIZE_MAX / graph_block_size(1))
+        return false;
+    uint8_t *block = sf_alloc(graph->alloc, graph_block_size(capacity));
+    if (!block)
+        return false;
+    sf_mat4 *worlds = (sf_mat4 *)(void *)block;
+    sf_transform *locals = (sf_transform *)(void *)(worlds + capacity);
+    uint32_t *parents = (uint32_t *)(void *)(locals + capacity), *ids = parents + capacity, *slots = ids + capacity;
+    uint8_t *flags = (uint8_t *)(slots + capacity);
+    if (graph->worlds) {
+        memcpy(worlds, graph->worlds, graph->count * sizeof(sf_mat4));
+        memcpy(locals, graph->locals, graph->count * sizeof(sf_transform));
+        memcpy(parents, graph->parents, graph->count * sizeof(uint32_t));
+        memcpy(ids, graph->ids, graph->count * sizeof(uint32_t));
+        // Freed handles chain through `slots` up to the highest handle ever given out, which is below `count`
+        // plus the amount of free ones, and so within the old capacity.
+        memcpy(slots, graph->slots, graph->capacity * sizeof(uint32_t));
+        memcpy(flags, graph->flags, graph->count);
+        sf_free(graph->alloc, graph->worlds, graph_block_size(graph->capacity));
+    }
+    graph->worlds = worlds;
+    graph->locals = locals;
+    graph->parents = parents;
+    graph->ids = ids;
+    graph->slots = slots;
+    graph->flags = flags;
+    graph->capacity = capacity;
+    return true;
+}
+
+/// Flag a slot dirty, to be recomputed with its descendants by the next update.
+static void graph_touch(sf_transform_graph *graph, const size_t slot) {
+    graph->flags[slot] |= NODE_DIRTY;
+    if (slot < graph->first_dirty)
+        graph->first_dirty = slot;
+}
+
+static void graph_swap(const sf_transform_graph *graph, const size_t a, const size_t b) {
+    const sf_mat4 world = graph->worlds[a];
+    graph->worlds[a] = graph->worlds[b];
+    graph->worlds[b] = world;
+    const sf_transform local = graph->locals[a];
+    graph->locals[a] = graph->locals[b];
+    graph->locals[b] = local;
+    const uint32_t parent = graph->parents[a], id = graph->ids[a];
+    graph->parents[a] = graph->parents[b];
+    graph->parents[b] = parent;
+    graph->ids[a] = graph->ids[b];
+    graph->ids[b] = id;
+    const uint8_t flags = graph->flags[a];
+    graph->flags[a] = graph->flags[b];
+    graph->flags[b] = flags;
+}
+
+/// Move the subtree rooted at `slot` behind every other node, keeping the order within both groups,
+/// so parents still come before their children. Returns the subtree's new first slot.
+static size_t graph_move_to_end(sf_transform_graph *graph, const size_t slot) {
+    // Descendants all come after `slot`, and after their own parents.
+    size_t moved = 1;
+    graph->flags[slot] |= NODE_MARKED;
+    for (size_t i = slot + 1; i < graph->count; ++i) {
+        const uint32_t parent = graph->parents[i];
+        if (parent != SF_TRANSFORM_NONE && graph->flags[parent] & NODE_MARKED) {
+            graph->flags[i] |= NODE_MARKED;
+            ++moved;
+        }
+    }
+    const size_t first = graph->count - moved;
+    size_t kept = slot, tail = first;
+    for (size_t i = slot; i < graph->count; ++i)
+        graph->slots[graph->ids[i]] = (uint32_t)(graph->flags[i] & NODE_MARKED ? tail++ : kept++);
+    // Parents are slots, so they are renumbered before anything moves.
+    for (size_t i = slot; i < graph->count; ++i)
+        if (graph->parents[i] != SF_TRANSFORM_NONE && graph->parents[i] >= slot)
+            graph->parents[i] = graph->slots[graph->ids[graph->parents[i]]];
+    // Every swap puts at least one node in its final slot.
+    for (size_t i = slot; i < graph->count; ++i) {
+        for (size_t target = graph->slots[graph->ids[i]]; target != i; target = graph->slots[graph->ids[i]])
+            graph_swap(graph, i, target);
+        graph->flags[i] &= (uint8_t)~NODE_MARKED;
+    }
+    if (slot < graph->first_dirty)
+        graph->first_dirty = slot;
+    return first;
+}
+
+sf_transform_id sf_transform_graph_add(sf_transform_graph *graph, const sf_transform_id parent, const sf_transform local) {
+    if (graph->count == graph->capacity && !graph_grow(graph, graph->capacity ? graph->capacity * 2 : 16))
+        return SF_TRANSFORM_NONE;
+    sf_transform_id id = graph->free_id;
+    if (id != SF_TRANSFORM_NONE)
+        graph->free_id = graph->slots[id];
+    else
+        id = (sf_transform_id)graph->count;
+    const size_t slot = graph->count++;
+    graph->locals[slot] = local;
+    graph->locals[slot].parent = NULL;
+    graph->parents[slot] = parent == SF_TRANSFORM_NONE ? SF_TRANSFORM_NONE : graph->slots[parent];
+    graph->ids[slot] = id;
+    graph->slots[id] = (uint32_t)slot;
+    graph->flags[slot] = 0;
+    graph_touch(graph, slot);
+    return id;
+}
+
+void sf_transform_graph_remove(sf_transform_graph *graph, const sf_transform_id id) {
+    const size_t first = graph_move_to_end(graph, graph->slots[id]);
+    for (size_t i = first; i < graph->count; ++i) {
+        graph->slots[graph->ids[i]] = graph->free_id;
+        graph->free_id = graph->ids[i];
+    }
+    graph->count = first;
+}
+
+void sf_transform_graph_set_local(sf_transform_graph *graph, const sf_transform_id id, const sf_transform local) {
+    const size_t slot = graph->slots[id];
+    graph->locals[slot] = local;
+    graph->locals[slot].parent = NULL;
+    graph_touch(graph, slot);
+}
+
+bool sf_transform_graph_set_parent(sf_transform_graph *graph, const sf_transform_id id, const sf_transform_id parent) {
+    size_t slot = graph->slots[id];
+    const uint32_t parent_slot = parent == SF_TRANSFORM_NONE ? SF_TRANSFORM_NONE : graph->slots[parent];
+    for (uint32_t ancestor = parent_slot; ancestor != SF_TRANSFORM_NONE; ancestor = graph->parents[ancestor])
+        if (ancestor == slot)
+            return false;
+    graph->parents[slot] = parent_slot;
+    if (parent_slot != SF_TRANSFORM_NONE && parent_slot > slot)
+        slot = graph_move_to_end(graph, slot);
+    graph_touch(graph, slot);
+    return true;
+}
+
+void sf_transform_graph_update(sf_transform_graph *graph) {
+    for (size_t i = graph->first_dirty; i < graph->count; ++i) {
+        const uint32_t parent = graph->parents[i];
+        if (parent != SF_TRANSFORM_NONE)
+            graph->flags[i] |= graph->flags[parent] & NODE_DIRTY;
+        if (!(graph->flags[i] & NODE_DIRTY))
+            continue;
+        const sf_mat4 local = sf_transform_local(&graph->locals[i]);
+        graph->worlds[i] = parent == SF_TRANSFORM_NONE ? local : sf_mat4_mul(graph->worlds[parent], local);
+    }
+    // Children read their parent's flag above, so flags are only cleared once every slot was visited.
+    for (size_t i = graph->first_dirty; i < graph->count; ++i)
+        graph->flags[i] &= (uint8_t)~NODE_DIRTY;
+    graph->first_dirty = graph->count;
+}
+
+// Random numbers come from xoshiro256** (Blackman and Vigna). Seeds go through splitmix64 first,
+// so that similar seeds still start from unrelated states.
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+sf_rng sf_rng_new(uint64_t seed) {
+    sf_rng rng;
+    for (size_t i = 0; i < 4; ++i)
+        rng.s[i] = splitmix64(&seed);
+    return rng;
+}
+
+void sf_rng_jump(sf_rng *rng) {
+    static const uint64_t jump[4] = { 0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull };
+    uint64_t s[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < 4; ++i)
+        for (uint32_t b = 0; b < 64; ++b) {
+            if (jump[i] & 1ull << b)
+                for (size_t w = 0; w < 4; ++w)
+                    s[w] ^= rng->s[w];
+            sf_rng_next(rng);
+        }
+    memcpy(rng->s, s, sizeof(s));
+}
+
+/// Streams that sf_rng_bytes runs side by side, one 64-bit output of each per step.
+#define RNG_LANES 4
+/// Buffers smaller than this are filled by the generator itself, seeding the streams would cost more.
+#define RNG_BULK_MIN 256
+
+/// The state of every stream, each state word of all streams next to each other.
+typedef struct {
+    uint64_t s[4][RNG_LANES];
+} rng_lanes;
+
+/// Fill whole steps of RNG_LANES outputs, returning the bytes written.
+/// Independent streams keep several multiplies in flight, and compilers can vectorize the lanes.
+static size_t rng_lanes_scalar(rng_lanes *lanes, uint8_t *out, const size_t size) {
+    size_t i = 0;
+    for (; i + RNG_LANES * 8 <= size; i += RNG_LANES * 8) {
+        for (size_t l = 0; l < RNG_LANES; ++l) {
+            sf_rng rng = { { lanes->s[0][l], lanes->s[1][l], lanes->s[2][l], lanes->s[3][l] } };
+            const uint64_t result = sf_rng_next(&rng);
+            memcpy(out + i + l * 8, &result, 8);
+            for (size_t w = 0; w < 4; ++w)
+                lanes->s[w][l] = rng.s[w];
+        }
+    }
+    return i;
+}
+
+#ifdef SF_CPU_X86
+SF_TARGET_AVX2 static size_t rng_lanes_avx2(rng_lanes *lanes, uint8_t *out, const size_t size) {
+    __m256i s0 = _mm256_loadu_si256((const __m256i *)(const void *)lanes->s[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i *)(const void *)lanes->s[1]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i *)(const void *)lanes->s[2]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i *)(const void *)lanes->s[3]);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        // There is no 64-bit multiply, but times 5 and times 9 are a shift and an add.
+        const __m256i x = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);
+        const __m256i rotated = _mm256_or_si256(_mm256_slli_epi64(x, 7), _mm256_srli_epi64(x, 57));
+        _mm256_storeu_si256((__m256i *)(void *)(out + i), _mm256_add_epi64(_mm256_slli_epi64(rotated, 3), rotated));
+        const __m256i t = _mm256_slli_epi64(s1, 17);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+    }
+    _mm256_storeu_si256((__m256i *)(void *)lanes->s[0], s0);
+    _mm256_storeu_si256((__m256i *)(void *)lanes->s[1], s1);
+    _mm256_storeu_si256((__m256i *)(void *)lanes->s[2], s2);
+    _mm256_storeu_si256((__m256i *)(void *)lanes->s[3], s3);
+    return i;
+}
+#endif
+
+void sf_rng_bytes(sf_rng *rng, void *buffer, size_t size) {
+    uint8_t *out = buffer;
+    if (size >= RNG_BULK_MIN) {
+        // Each stream is seeded from the generator, which moves on as if it produced RNG_LANES outputs.
+        rng_lanes lanes;
+        for (size_t l = 0; l < RNG_LANES; ++l) {
+            const sf_rng lane = sf_rng_new(sf_rng_next(rng));
+            for (size_t w = 0; w < 4; ++w)
+                lanes.s[w][l] = lane.s[w];
+        }
+#ifdef SF_CPU_X86
+        const size_t done = cpu_has_avx2() ? rng_lanes_avx2(&lanes, out, size) : rng_lanes_scalar(&lanes, out, size);
+#else
+        const size_t done = rng_lanes_scalar(&lanes, out, size);
+#endif
+        out += done;
+        size -= done;
+    }
+    for (; size >= 8; out += 8, size -= 8) {
+        const uint64_t result = sf_rng_next(rng);
+        memcpy(out, &result, 8);
+    }
+    if (size) {
+        const uint64_t result = sf_rng_next(rng);
+        memcpy(out, &result, size);
+    }
+}
+
+uint64_t sf_rng_below(sf_rng *rng, const uint64_t bound) {
+    // Lemire's method: the high half of random * bound is in range, and the low half tells when it is
+    // one of the few values that would make some results more likely, which are drawn again.
+    uint64_t low, high = mul_128(sf_rng_next(rng), bound, &low);
+    if (low < bound) {
+        const uint64_t threshold = (0 - bound) % bound;
+        while (low < threshold)
+            high = mul_128(sf_rng_next(rng), bound, &low);
+    }
+    return high;
+}
+
+uint64_t sf_rng_uint(sf_rng *rng, const uint64_t min, const uint64_t max) {
+    assert(min <= max);
+    const uint64_t range = max - min;
+    return min + (range == UINT64_MAX ? sf_rng_next(rng) : sf_rng_below(rng, range + 1));
+}
+
+int64_t sf_rng_int(sf_rng *rng, const int64_t min, const int64_t max) {
+    assert(min <= max);
+    const uint64_t range = (uint64_t)max - (uint64_t)min;
+    const uint64_t offset = range == UINT64_MAX ? sf_rng_next(rng) : sf_rng_below(rng, range + 1);
+    return (int64_t)((uint64_t)min + offset);
+}
+
+float sf_rng_float(sf_rng *rng, const float min, const float max) {
+    const float unit = (float)sf_rng_below(rng, (1u << 24) + 1) * 0x1p-24f;
+    const float value = min + (max - min) * unit;
+    return value > max ? max : value;
+}
+
+static sf_thread_local sf_rng thread_rng;
+static sf_thread_local bool thread_rng_seeded;
+
+/// The calling thread's generator, seeded on first use.
+static sf_rng *default_rng(void) {
+    if (!thread_rng_seeded) {
+        // Threads starting within the same clock tick still differ by where their state lives.
+        struct timespec now;
+        timespec_get(&now, TIME_UTC);
+        sf_rand_seed(((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec) ^ (uint64_t)(uintptr_t)&thread_rng);
+    }
+    return &thread_rng;
+}
+
+void sf_rand_seed(const uint64_t seed) {
+    thread_rng = sf_rng_new(seed);
+    thread_rng_seeded = true;
+}
+
+void sf_rand(void *buffer, const size_t size) {
+    sf_rng_bytes(default_rng(), buffer, size);
+}
+
+float sf_randf(const float min, const float max) {
+    return sf_rng_float(default_rng(), min, max);
+}
+
+int64_t sf_randi(const int64_t min, const int64_t max) {
+    return sf_rng_int(default_rng(), min, max);
+}
+
+uint64_t sf_randu(const uint64_t min, const uint64_t max) {
+    return sf_rng_uint(default_rng(), min, max);
+}
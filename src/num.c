@@ -0,0 +1,514 @@
+#include <errno.h>
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sf/num.h"
+#include "num_table.h"
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/// Amount of decimal digits in `value`.
+static uint32_t count_digits(uint64_t value) {
+    uint32_t count = 1;
+    for (;;) {
+        if (value < 10)
+            return count;
+        if (value < 100)
+            return count + 1;
+        if (value < 1000)
+            return count + 2;
+        if (value < 10000)
+            return count + 3;
+        value /= 10000;
+        count += 4;
+    }
+}
+
+/// Write the digits of `value` so they end right before `end`, two at a time.
+static void write_digits(char *end, uint64_t value) {
+    while (value >= 100) {
+        const size_t pair = (size_t)(value % 100) * 2;
+        value /= 100;
+        end -= 2;
+        memcpy(end, digit_pairs + pair, 2);
+    }
+    if (value >= 10)
+        memcpy(end - 2, digit_pairs + value * 2, 2);
+    else
+        end[-1] = (char)('0' + value);
+}
+
+/// Write `value` at `out`, returning the amount of characters written.
+static size_t write_u64(char *out, const uint64_t value) {
+    const uint32_t len = count_digits(value);
+    write_digits(out + len, value);
+    return len;
+}
+
+sf_str sf_u64_to_str(const uint64_t value, char buffer[SF_NUM_BUFFER_SIZE]) {
+    const size_t len = write_u64(buffer, value);
+    buffer[len] = '\0';
+    return (sf_str) { .c_str = buffer, .len = len, .flags = SF_STR_CONST };
+}
+
+sf_str sf_i64_to_str(const int64_t value, char buffer[SF_NUM_BUFFER_SIZE]) {
+    char *out = buffer;
+    if (value < 0)
+        *out++ = '-';
+    // Negate as unsigned, so INT64_MIN doesn't overflow.
+    out += write_u64(out, value < 0 ? 0 - (uint64_t)value : (uint64_t)value);
+    *out = '\0';
+    return (sf_str) { .c_str = buffer, .len = (size_t)(out - buffer), .flags = SF_STR_CONST };
+}
+
+// Shortest round trip formatting follows Ryu (Ulf Adams, 2018): compute the interval of decimals that round to the
+// double, then drop digits while the interval still holds a number with fewer of them.
+
+#define MANTISSA_BITS 52
+#define EXPONENT_BITS 11
+#define EXPONENT_BIAS 1023
+
+/// A decimal `mantissa * 10^exponent`.
+typedef struct {
+    uint64_t mantissa;
+    int32_t exponent;
+} decimal;
+
+/// Bits in 5^e, for e > 0.
+static int32_t pow5_bits(const int32_t e) {
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+/// floor(log10(2^e)), for e >= 0.
+static uint32_t log10_pow2(const int32_t e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+/// floor(log10(5^e)), for e >= 0.
+static uint32_t log10_pow5(const int32_t e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static uint32_t pow5_factor(uint64_t value) {
+    uint32_t count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        ++count;
+    }
+    return count;
+}
+
+static bool multiple_of_pow5(const uint64_t value, const uint32_t p) {
+    return pow5_factor(value) >= p;
+}
+
+static bool multiple_of_pow2(const uint64_t value, const uint32_t p) {
+    return (value & ((1ull << p) - 1)) == 0;
+}
+
+/// The high 64 bits of `a * b`, and the low ones in `low`.
+static uint64_t mul_128(const uint64_t a, const uint64_t b, uint64_t *low) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ const unsigned __int128 product = (unsigned __int128)a * b;
+    *low = (uint64_t)product;
+    return (uint64_t)(product >> 64);
+#else
+    const uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+    const uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    const uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+    *low = (cross << 32) | (uint32_t)lo_lo;
+    return (hi_lo >> 32) + (cross >> 32) + hi_hi;
+#endif
+}
+
+/// `(m * mul) >> j` for a 128-bit `mul`, where 64 < j < 128.
+static uint64_t mul_shift(const uint64_t m, const uint64_t *mul, const int32_t j) {
+    uint64_t low0, low1;
+    const uint64_t high0 = mul_128(m, mul[0], &low0);
+    uint64_t high1 = mul_128(m, mul[1], &low1);
+    const uint64_t sum = high0 + low1;
+    high1 += sum < high0;
+    const uint32_t shift = (uint32_t)(j - 64);
+    return (high1 << (64 - shift)) | (sum >> shift);
+}
+
+/// The shortest decimal of a finite, non-zero double.
+static decimal shortest(const uint64_t ieee_mantissa, const uint32_t ieee_exponent) {
+    // Integers below 2^53 are exact, only trailing zeros need to go.
+    const int32_t exact_e2 = (int32_t)ieee_exponent - EXPONENT_BIAS - MANTISSA_BITS;
+    if (ieee_exponent && exact_e2 <= 0 && exact_e2 >= -MANTISSA_BITS) {
+        const uint64_t m = (1ull << MANTISSA_BITS) | ieee_mantissa;
+        if ((m & ((1ull << -exact_e2) - 1)) == 0) {
+            decimal d = { m >> -exact_e2, 0 };
+            while (d.mantissa % 10 == 0) {
+                d.mantissa /= 10;
+                ++d.exponent;
+            }
+            return d;
+        }
+    }
+
+    // Step 1: the double is m2 * 2^e2, with its neighbours halfway to the next doubles either side.
+    int32_t e2;
+    uint64_t m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - EXPONENT_BIAS - MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (int32_t)ieee_exponent - EXPONENT_BIAS - MANTISSA_BITS - 2;
+        m2 = (1ull << MANTISSA_BITS) | ieee_mantissa;
+    }
+    const bool accept_bounds = (m2 & 1) == 0;
+    const uint64_t mv = 4 * m2;
+    // At powers of two the next double down is closer, so the lower bound is too.
+    const uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    // Step 2: convert the interval to decimal, vr for the value and vp/vm for the upper and lower bounds.
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    bool vm_trailing_zeros = false, vr_trailing_zeros = false;
+    if (e2 >= 0) {
+        const uint32_t q = log10_pow2(e2) - (e2 > 3);
+        e10 = (int32_t)q;
+        const int32_t k = POW5_INV_BITCOUNT + pow5_bits((int32_t)q) - 1;
+        const int32_t i = -e2 + (int32_t)q + k;
+        vr = mul_shift(4 * m2, POW5_INV[q], i);
+        vp = mul_shift(4 * m2 + 2, POW5_INV[q], i);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, POW5_INV[q], i);
+        if (q <= 21) {
+            // Only one of mp, mv and mm can be a multiple of 5, if any.
+            if (mv % 5 == 0)
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            else if (accept_bounds)
+                vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            else
+                vp -= multiple_of_pow5(mv + 2, q);
+        }
+    } else {
+        const uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+        e10 = (int32_t)q + e2;
+        const int32_t i = -e2 - (int32_t)q;
+        const int32_t k = pow5_bits(i) - POW5_BITCOUNT;
+        const int32_t j = (int32_t)q - k;
+        vr = mul_shift(4 * m2, POW5[i], j);
+        vp = mul_shift(4 * m2 + 2, POW5[i], j);
+        vm = mul_shift(4 * m2 - 1 - mm_shift, POW5[i], j);
+        if (q <= 1) {
+            // mv has at least q trailing zeros, as it's a multiple of 4.
+            vr_trailing_zeros = true;
+            if (accept_bounds)
+                vm_trailing_zeros = mm_shift == 1;
+            else
+                --vp;
+        } else if (q < 63) {
+            vr_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    // Step 3: drop digits while the bounds still differ, rounding the value to nearest.
+    int32_t removed = 0;
+    uint64_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        // Exact ties are rare, and need every removed digit tracked to round half to even.
+        uint8_t last_removed = 0;
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (uint8_t)(vr % 10);
+            vr /= 10, vp /= 10, vm /= 10;
+            ++removed;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (uint8_t)(vr % 10);
+                vr /= 10, vp /= 10, vm /= 10;
+                ++removed;
+            }
+        }
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0)
+            last_removed = 4;
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        bool round_up = false;
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100, vp /= 100, vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10, vp /= 10, vm /= 10;
+            ++removed;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    return (decimal) { output, e10 + removed };
+}
+
+sf_str sf_f64_to_str(const double value, char buffer[SF_NUM_BUFFER_SIZE]) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t ieee_mantissa = bits & ((1ull << MANTISSA_BITS) - 1);
+    const uint32_t ieee_exponent = (uint32_t)(bits >> MANTISSA_BITS) & ((1u << EXPONENT_BITS) - 1);
+
+    char *out = buffer;
+    if (ieee_exponent == (1u << EXPONENT_BITS) - 1 && ieee_mantissa) {
+        memcpy(out, "nan", 4);
+        return (sf_str) { .c_str = buffer, .len = 3, .flags = SF_STR_CONST };
+    }
+    if (bits >> 63)
+        *out++ = '-';
+    if (ieee_exponent == (1u << EXPONENT_BITS) - 1) {
+        memcpy(out, "inf", 4);
+        out += 3;
+    } else if (ieee_exponent == 0 && ieee_mantissa == 0) {
+        *out++ = '0';
+    } else {
+        const decimal d = shortest(ieee_mantissa, ieee_exponent);
+        char digits[20];
+        const int32_t len = (int32_t)write_u64(digits, d.mantissa);
+        // Where the decimal point goes, relative to the first digit.
+        const int32_t point = len + d.exponent;
+        if (point >= len && point <= 21) {
+            memcpy(out, digits, (size_t)len);
+            memset(out + len, '0', (size_t)(point - len));
+            out += point;
+        } else if (point > 0 && point <= 21) {
+            memcpy(out, digits, (size_t)point);
+            out[point] = '.';
+            memcpy(out + point + 1, digits + point, (size_t)(len - point));
+            out += len + 1;
+        } else if (point > -6 && point <= 0) {
+            *out++ = '0';
+            *out++ = '.';
+            memset(out, '0', (size_t)-point);
+            out += -point;
+            memcpy(out, digits, (size_t)len);
+            out += len;
+        } else {
+            *out++ = digits[0];
+            if (len > 1) {
+                *out++ = '.';
+                memcpy(out, digits + 1, (size_t)len - 1);
+                out += len - 1;
+            }
+            const int32_t exponent = point - 1;
+            *out++ = 'e';
+            *out++ = exponent < 0 ? '-' : '+';
+            out += write_u64(out, (uint64_t)(exponent < 0 ? -exponent : exponent));
+        }
+    }
+    *out = '\0';
+    return (sf_str) { .c_str = buffer, .len = (size_t)(out - buffer), .flags = SF_STR_CONST };
+}
+
+static bool is_digit(const char c) {
+    return (unsigned)(c - '0') < 10;
+}
+
+/// Parse the digits of `len` bytes at `s` as a magnitude.
+static sf_u64_ex parse_magnitude(const char *s, size_t len) {
+    if (len == 0)
+        return sf_u64_ex_err(SF_NUM_INVALID);
+    // Up to 19 digits always fit, only a 20th can overflow.
+    while (len > 1 && *s == '0')
+        ++s, --len;
+    if (len > 20)
+        return sf_u64_ex_err(is_digit(*s) ? SF_NUM_OVERFLOW : SF_NUM_INVALID);
+
+    uint64_t value = 0;
+    const size_t fast = len < 19 ? len : 19;
+    for (size_t i = 0; i < fast; ++i) {
+        if (!is_digit(s[i]))
+            return sf_u64_ex_err(SF_NUM_INVALID);
+        value = value * 10 + (uint64_t)(s[i] - '0');
+    }
+    for (size_t i = fast; i < len; ++i) {
+        if (!is_digit(s[i]))
+            return sf_u64_ex_err(SF_NUM_INVALID);
+        const uint64_t digit = (uint64_t)(s[i] - '0');
+        if (value > (UINT64_MAX - digit) / 10)
+            return sf_u64_ex_err(SF_NUM_OVERFLOW);
+        value = value * 10 + digit;
+    }
+    return sf_u64_ex_ok(value);
+}
+
+sf_u64_ex sf_str_to_u64(const sf_str string) {
+    const char *s = sf_cstr(string);
+    size_t len = string.len;
+    if (len == 0)
+        return sf_u64_ex_err(SF_NUM_EMPTY);
+    if (*s == '+')
+        ++s, --len;
+    return parse_magnitude(s, len);
+}
+
+sf_i64_ex sf_str_to_i64(const sf_str string) {
+    const char *s = sf_cstr(string);
+    size_t len = string.len;
+    if (len == 0)
+        return sf_i64_ex_err(SF_NUM_EMPTY);
+    const bool negative = *s == '-';
+    if (*s == '-' || *s == '+')
+        ++s, --len;
+    const sf_u64_ex magnitude = parse_magnitude(s, len);
+    if (!magnitude.is_ok)
+        return sf_i64_ex_err(magnitude.err);
+    if (magnitude.ok > (uint64_t)INT64_MAX + negative)
+        return sf_i64_ex_err(SF_NUM_OVERFLOW);
+    // Negate as unsigned, so INT64_MIN doesn't overflow.
+    return sf_i64_ex_ok(negative ? (int64_t)(0 - magnitude.ok) : (int64_t)magnitude.ok);
+}
+
+/// Case insensitive comparison against a lowercase word.
+static bool is_word(const char *s, const size_t len, const char *word) {
+    if (len != strlen(word))
+        return false;
+    for (size_t i = 0; i < len; ++i)
+        if ((s[i] | 0x20) != word[i])
+            return false;
+    return true;
+}
+
+/// Powers of ten that doubles represent exactly.
+static const double exact_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+#define MAX_EXACT_POW10 22
+
+/// Correctly round a number too long or too large for the fast path with strtod.
+/// `s` was validated already, only the decimal point has to match the C locale.
+static sf_f64_ex parse_slow(const char *s, const size_t len) {
+    char small[64];
+    char *copy = len < sizeof(small) ? small : malloc(len + 1);
+    if (!copy)
+        return sf_f64_ex_err(SF_NUM_ALLOC_FAIL);
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    const char point = *localeconv()->decimal_point;
+    char *dot = memchr(copy, '.', len);
+    if (dot)
+        *dot = point;
+
+    errno = 0;
+    const double value = strtod(copy, NULL);
+    const bool overflow = errno == ERANGE && (value == HUGE_VAL || value == -HUGE_VAL);
+    if (copy != small)
+        free(copy);
+    return overflow ? sf_f64_ex_err(SF_NUM_OVERFLOW) : sf_f64_ex_ok(value);
+}
+
+sf_f64_ex sf_str_to_f64(const sf_str string) {
+    const char *s = sf_cstr(string);
+    const size_t len = string.len;
+    if (len == 0)
+        return sf_f64_ex_err(SF_NUM_EMPTY);
+
+    size_t i = 0;
+    const bool negative = s[0] == '-';
+    if (s[0] == '-' || s[0] == '+')
+        ++i;
+    if (i < len && !is_digit(s[i]) && s[i] != '.') {
+        if (is_word(s + i, len - i, "inf") || is_word(s + i, len - i, "infinity"))
+            return sf_f64_ex_ok(negative ? -HUGE_VAL : HUGE_VAL);
+        if (is_word(s + i, len - i, "nan"))
+            return sf_f64_ex_ok(NAN);
+        return sf_f64_ex_err(SF_NUM_INVALID);
+    }
+
+    // Gather up to 19 significant digits, and the power of ten they are scaled by.
+    uint64_t mantissa = 0;
+    int32_t significant = 0, exponent = 0;
+    bool any_digits = false, truncated = false;
+    for (; i < len && is_digit(s[i]); ++i) {
+        any_digits = true;
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+            significant += mantissa != 0;
+        } else {
+            truncated |= s[i] != '0';
+            ++exponent;
+        }
+    }
+    if (i < len && s[i] == '.') {
+        for (++i; i < len && is_digit(s[i]); ++i) {
+            any_digits = true;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(s[i] - '0');
+                significant += mantissa != 0;
+                --exponent;
+            } else {
+                truncated |= s[i] != '0';
+            }
+        }
+    }
+    if (!any_digits)
+        return sf_f64_ex_err(SF_NUM_INVALID);
+    if (i < len && (s[i] | 0x20) == 'e') {
+        ++i;
+        const bool negative_exponent = i < len && s[i] == '-';
+        if (i < len && (s[i] == '-' || s[i] == '+'))
+            ++i;
+        if (i == len)
+            return sf_f64_ex_err(SF_NUM_INVALID);
+        int32_t written = 0;
+        for (; i < len && is_digit(s[i]); ++i)
+            // Saturate, any exponent this large over- or underflows anyway.
+            written = written < 100000 ? written * 10 + (s[i] - '0') : written;
+        exponent += negative_exponent ? -written : written;
+    }
+    if (i != len)
+        return sf_f64_ex_err(SF_NUM_INVALID);
+
+    if (mantissa == 0)
+        return sf_f64_ex_ok(negative ? -0.0 : 0.0);
+#if FLT_EVAL_METHOD == 0
+    // Clinger's fast path: an exact mantissa times an exact power of ten rounds once, correctly.
+    if (!truncated && mantissa <= 1ull << 53) {
+        double value = (double)mantissa;
+        if (exponent < 0 && exponent >= -MAX_EXACT_POW10)
+            return sf_f64_ex_ok(negative ? -(value / exact_pow10[-exponent]) : value / exact_pow10[-exponent]);
+        if (exponent >= 0 && exponent <= MAX_EXACT_POW10 + 15) {
+            // Extra powers of ten can move into the mantissa while it stays exact.
+            if (exponent > MAX_EXACT_POW10) {
+                const uint64_t scale = (uint64_t)exact_pow10[exponent - MAX_EXACT_POW10];
+                if (mantissa > (1ull << 53) / scale)
+                    return parse_slow(s, len);
+                value = (double)(mantissa * scale);
+                exponent = MAX_EXACT_POW10;
+            }
+            return sf_f64_ex_ok(negative ? -(value * exact_pow10[exponent]) : value * exact_pow10[exponent]);
+        }
+    }
+#endif
+    return parse_slow(s, len);
+}
+
+sf_buffer_ex sf_buffer_insert_u64(sf_buffer *buffer, const uint64_t value) {
+    char digits[SF_NUM_BUFFER_SIZE];
+    return sf_buffer_insert(buffer, digits, write_u64(digits, value));
+}
+
+sf_buffer_ex sf_buffer_insert_i64(sf_buffer *buffer, const int64_t value) {
+    char digits[SF_NUM_BUFFER_SIZE];
+    return sf_buffer_insert(buffer, digits, sf_i64_to_str(value, digits).len);
+}
+
+sf_buffer_ex sf_buffer_insert_f64(sf_buffer *buffer, const double value) {
+    char digits[SF_NUM_BUFFER_SIZE];
+    return sf_buffer_insert(buffer, digits, sf_f64_to_str(value, digits).len);
+}
@@ -0,0 +1,265 @@
+#include <assert.h>
+#include "sf/pool.h"
+#include "sf/math.h"
+
+#define MAX_ALIGN _Alignof(max_align_t)
+/// Per-pool caches each thread keeps before recycling the oldest.
+#define THREAD_CACHES 16
+
+/// A pool's record of whether it is alive. Slots are never freed, only reused by later pools,
+/// so a thread cache can check its pool in O(1) even after the pool itself is gone.
+typedef struct sf_pool_slot {
+    sf_mutex lock; /// Held while checking `id`, and while the pool changes generation.
+    uint64_t id; /// Generation of the pool using the slot, bumped when it resets or is freed.
+    sf_pool *pool; /// NULL while unused.
+    struct sf_pool_slot *next_free;
+} sf_pool_slot;
+
+/// A thread's cache of free objects for one generation of one pool.
+typedef struct {
+    sf_pool_slot *slot;
+    uint64_t id;
+    uint32_t count;
+    void *objects[SF_POOL_MAGAZINE];
+} magazine;
+
+/// Header at the start of every slab.
+typedef struct slab {
+    struct slab *next;
+    size_t size;
+} slab;
+#define SLAB_HEADER ((sizeof(slab) + MAX_ALIGN - 1) & ~(MAX_ALIGN - 1))
+
+static sf_thread_local magazine caches[THREAD_CACHES];
+static sf_thread_local uint32_t next_evict;
+
+// Slots released by freed pools. The lock is only taken when creating and freeing pools.
+static sf_mutex slots_lock = SF_MUTEX_INIT;
+static sf_pool_slot *free_slots = NULL;
+
+/// Pop an object from the free list or carve a new one. The pool must be locked.
+static void *carve(sf_pool *pool) {
+    if (pool->free_list) {
+        void *object = pool->free_list;
+        pool->free_list = *(void **)object;
+        return object;
+    }
+
+    if ((size_t)(pool->bump_end - pool->bump) < pool->object_size) {
+        const size_t size = max(pool->slab_size, SLAB_HEADER + pool->object_size);
+        slab *s = sf_alloc(pool->backing, size);
+        if (!s)
+            return NULL;
+        s->next = pool->slabs;
+        s->size = size;
+        pool->slabs = s;
+        pool->bump = (uint8_t *)s + SLAB_HEADER;
+        pool->bump_end = (uint8_t *)s + size;
+    }
+
+    void *object = pool->bump;
+    pool->bump += pool->object_size;
+    return object;
+}
+
+/// Push `count` objects onto the free list. The pool must be locked.
+static void give_back(sf_pool *pool, void **objects, const uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        *(void **)objects[i] = pool->free_list;
+        pool->free_list = objects[i];
+    }
+}
+
+/// Return a cache's objects to its pool, if that generation of the pool is still alive.
+static void evict(magazine *mag) {
+    sf_pool_slot *slot = mag->slot;
+    sf_mutex_lock(&slot->lock);
+    if (slot->id == mag->id) {
+        sf_mutex_lock(&slot->pool->lock);
+        give_back(slot->pool, mag->objects, mag->count);
+        sf_mutex_unlock(&slot->pool->lock);
+    }
+    sf_mutex_unlock(&slot->lock);
+    mag->slot = NULL;
+    mag->count = 0;
+}
+
+/// Find or claim this thread's cache for a pool.
+static magazine *magazine_for(sf_pool *pool) {
+    magazine *unused = NULL;
+    for (uint32_t i = 0; i < THREAD_CACHES; ++i) {
+        if (caches[i].slot == pool->slot) {
+            // A cache from before a reset holds objects of released slabs, so it is just emptied.
+            if (caches[i].id != pool->id) {
+                caches[i].id = pool->id;
+                caches[i].count = 0;
+            }
+            return &caches[i];
+        }
+        if (!caches[i].slot && !unused)
+            unused = &caches[i];
+    }
+
+    magazine *mag = unused;
+    if (!mag) {
+        mag = &caches[next_evict++ % THREAD_CACHES];
+        evict(mag);
+    }
+    mag->slot = pool->slot;
+    mag->id = pool->id;
+    mag->count = 0;
+    return mag;
+}
+
+/// Release every slab of a pool. The pool must be locked.
+static void free_slabs(sf_pool *pool) {
+    slab *s = pool->slabs;
+    while (s) {
+        slab *next = s->next;
+        sf_free(pool->backing, s, s->size);
+        s = next;
+    }
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+    pool->bump = pool->bump_end = NULL;
+}
+
+sf_pool *sf_pool_new(const size_t object_size) {
+    return sf_pool_new_in(NULL, object_size);
+}
+
+sf_pool *sf_pool_new_in(const sf_allocator *backing, const size_t object_size) {
+    sf_pool *pool = sf_alloc(backing, sizeof(sf_pool));
+    if (!pool)
+        return NULL;
+
+    // Objects must hold a free list link. A type's size is a multiple of its alignment,
+    // so objects packed back to back from an aligned slab stay aligned.
+    size_t size = max(object_size, sizeof(void *));
+    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    sf_mutex_lock(&slots_lock);
+    sf_pool_slot *slot = free_slots;
+    if (slot)
+        free_slots = slot->next_free;
+    sf_mutex_unlock(&slots_lock);
+    if (!slot) {
+        // Slots come from the C heap rather than `backing`, as they outlive the pool.
+        slot = malloc(sizeof(sf_pool_slot));
+        if (!slot) {
+            sf_free(backing, pool, sizeof(sf_pool));
+            return NULL;
+        }
+        *slot = (sf_pool_slot) { .id = 0, .pool = NULL, .next_free = NULL };
+        sf_mutex_init(&slot->lock);
+    }
+
+    *pool = (sf_pool) {
+        .object_size = size,
+        .slab_size = max((size_t)SF_POOL_SLAB_SIZE, SLAB_HEADER + size * SF_POOL_MAGAZINE),
+        .slot = slot,
+        .id = 0,
+        .free_list = NULL,
+        .slabs = NULL,
+        .bump = NULL,
+        .bump_end = NULL,
+        .backing = backing,
+    };
+    sf_mutex_init(&pool->lock);
+
+    sf_mutex_lock(&slot->lock);
+    pool->id = ++slot->id;
+    slot->pool = pool;
+    sf_mutex_unlock(&slot->lock);
+    return pool;
+}
+
+void sf_pool_free(sf_pool *pool) {
+    if (!pool)
+        return;
+
+    // A new generation orphans every thread's cache of this pool.
+    sf_pool_slot *slot = pool->slot;
+    sf_mutex_lock(&slot->lock);
+    slot->id++;
+    slot->pool = NULL;
+    sf_mutex_unlock(&slot->lock);
+    sf_mutex_lock(&slots_lock);
+    slot->next_free = free_slots;
+    free_slots = slot;
+    sf_mutex_unlock(&slots_lock);
+
+    free_slabs(pool);
+    sf_mutex_destroy(&pool->lock);
+    sf_free(pool->backing, pool, sizeof(sf_pool));
+}
+
+void sf_pool_reset(sf_pool *pool) {
+    // A new generation orphans every thread's cache of the old objects.
+    sf_mutex_lock(&pool->slot->lock);
+    pool->id = ++pool->slot->id;
+    sf_mutex_lock(&pool->lock);
+    free_slabs(pool);
+    sf_mutex_unlock(&pool->lock);
+    sf_mutex_unlock(&pool->slot->lock);
+}
+
+void *sf_pool_alloc(sf_pool *pool) {
+    magazine *mag = magazine_for(pool);
+    if (mag->count)
+        return mag->objects[--mag->count];
+
+    // Refill half a magazine so the next few allocations don't lock.
+    sf_mutex_lock(&pool->lock);
+    while (mag->count < SF_POOL_MAGAZINE / 2) {
+        void *object = carve(pool);
+        if (!object)
+            break;
+        mag->objects[mag->count++] = object;
+    }
+    sf_mutex_unlock(&pool->lock);
+
+    return mag->count ? mag->objects[--mag->count] : NULL;
+}
+
+void sf_pool_release(sf_pool *pool, void *object) {
+    if (!object)
+        return;
+    magazine *mag = magazine_for(pool);
+    if (mag->count == SF_POOL_MAGAZINE) {
+        // Hand half back so frees from other threads drain to the shared list.
+        sf_mutex_lock(&pool->lock);
+        give_back(pool, mag->objects + SF_POOL_MAGAZINE / 2, SF_POOL_MAGAZINE / 2);
+        sf_mutex_unlock(&pool->lock);
+        mag->count = SF_POOL_MAGAZINE / 2;
+    }
+    mag->objects[mag->count++] = object;
+}
+
+static void *pool_alloc(void *ud, const size_t size) {
+    sf_pool *pool = ud;
+    assert(size <= pool->object_size && "Allocation larger than the pool's objects.");
+    return size <= pool->object_size ? sf_pool_alloc(pool) : NULL;
+}
+
+static void *pool_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    sf_pool *pool = ud;
+    (void)old_size;
+    if (!ptr)
+        return pool_alloc(ud, size);
+    assert(size <= pool->object_size && "Allocation larger than the pool's objects.");
+    return size <= pool->object_size ? ptr : NULL;
+}
+
+static void pool_free(void *ud, void *ptr, const size_t size) {
+    (void)size;
+    sf_pool_release(ud, ptr);
+}
+
+sf_allocator sf_pool_allocator(sf_pool *pool) {
+    return (sf_allocator) {
+        .alloc = pool_alloc,
+        .realloc = pool_realloc,
+        .free = pool_free,
+        .ud = pool,
+    };
+}
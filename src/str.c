@@ -1,60 +1,456 @@
-#include <stdarg.h>
-#include <stdio.h>
-#include "sf/str.h"
-
-sf_str sf_str_fmt(const char *format, ...) {
-    va_list arglist;
-
-    va_start(arglist, format);
-    const size_t size =
-        (size_t)vsnprintf(NULL, 0, format, arglist);
-    va_end(arglist);
-
-    char *fmt = calloc(1, size + 1);
-    va_start(arglist, format);
-    vsnprintf(fmt, size + 1, format, arglist);
-    va_end(arglist);
-
-    return (sf_str) {
-        .c_str = fmt,
-        .len = size,
-        .flags = SF_STR_NONE,
-    };
-}
-
-sf_str sf_str_join(const sf_str str1, const sf_str str2) {
-    const size_t s = str1.len + str2.len;
-    const sf_str new_str = {
-        .c_str = malloc(s + 1),
-        .len = s,
-    };
-    memcpy(new_str.c_str, str1.c_str, str1.len);
-    memcpy(new_str.c_str + str1.len, str2.c_str, str2.len);
-    new_str.c_str[s] = '\0';
-
-    return new_str;
-}
-
-void sf_str_append(sf_str *str1, const sf_str str2) {
-    if (sf_isempty(str2))
-        return;
-    const size_t s = str1->len + str2.len;
-    str1->flags &= (uint8_t)~SF_STR_EMPTYF;
-    str1->c_str = realloc(str1->c_str, s + 1);
-    memcpy(str1->c_str + str1->len, str2.c_str, str2.len);
-    str1->len = s;
-    str1->c_str[s] = '\0';
-}
-
-sf_str sf_str_dup(const sf_str string) {
-    const sf_str new_str = { .c_str = calloc(1, string.len + 1), .len = string.len };
-    memcpy(new_str.c_str, string.c_str, string.len);
-    return new_str;
-}
-
-int sf_str_cmp(const sf_str str1, const sf_str str2) {
-    if (str1.c_str == str2.c_str || (str1.len == 0 && str2.len == 0)) return 0;
-    char *a = str1.c_str, *b = str2.c_str;
-    for (; *a && *b && *a == *b; ++a, ++b) {}
-    return *b - *a;
-}
+#include <stdarg.h>
+#include <stdio.h>
+#include "sf/str.h"
+#include "sf/strbuf.h"
+#include "cpu.h"
+
+sf_str sf_str_fmt(const char *format, ...) {
+    va_list arglist;
+    va_start(arglist, format);
+    const sf_str out = sf_str_vfmt_in(NULL, format, arglist);
+    va_end(arglist);
+    return out;
+}
+
+sf_str sf_str_fmt_in(const sf_allocator *alloc, const char *format, ...) {
+    va_list arglist;
+    va_start(arglist, format);
+    const sf_str out = sf_str_vfmt_in(alloc, format, arglist);
+    va_end(arglist);
+    return out;
+}
+
+/// Make room for a new string of `len` bytes, inline when it fits and otherwise allocated from `alloc`.
+/// Returns where its bytes go, or NULL when out of memory.
+static char *str_init(const sf_allocator *alloc, sf_str *out, const size_t len) {
+    *out = (sf_str) { .c_str = NULL, .len = len, .flags = SF_STR_NONE };
+#ifdef SF_STR_SSO
+    if (len < SF_STR_SSO_SIZE) {
+        out->flags |= SF_STR_INLINE;
+        return out->sso;
+    }
+#endif
+    out->c_str = sf_alloc(alloc, len + 1);
+    return out->c_str;
+}
+
+sf_str sf_str_vfmt_in(const sf_allocator *alloc, const char *format, va_list args) {
+    va_list arglist;
+    sf_strbuf sb = sf_strbuf_new_in(alloc);
+
+#ifdef SF_STR_SSO
+    // Short results are done in one pass, straight into the inline storage.
+    sf_str out;
+    char *inline_str = str_init(alloc, &out, 0);
+    va_copy(arglist, args);
+    const int inline_size = vsnprintf(inline_str, SF_STR_SSO_SIZE, format, arglist);
+    va_end(arglist);
+    if (inline_size < 0 || inline_size < SF_STR_SSO_SIZE) {
+        out.len = inline_size < 0 ? 0 : (size_t)inline_size;
+        return out;
+    }
+    // Too long, but the attempt already measured it.
+    sf_strbuf_reserve(&sb, (size_t)inline_size);
+#else
+    // A guess that fits most results, so vsnprintf usually only runs once.
+    sf_strbuf_reserve(&sb, strlen(format) * 2 + SF_STRBUF_MIN_CAPACITY);
+#endif
+
+    va_copy(arglist, args);
+    const bool ok = sf_strbuf_vappendf(&sb, format, arglist);
+    va_end(arglist);
+    if (!ok) {
+        sf_strbuf_free(&sb);
+        return SF_STR_EMPTY;
+    }
+    return sf_strbuf_finish(&sb);
+}
+
+sf_str sf_str_join(const sf_str str1, const sf_str str2) {
+    return sf_str_join_in(NULL, str1, str2);
+}
+
+sf_str sf_str_join_in(const sf_allocator *alloc, const sf_str str1, const sf_str str2) {
+    const size_t s = str1.len + str2.len;
+    sf_str new_str;
+    char *dest = str_init(alloc, &new_str, s);
+    if (!dest)
+        return new_str;
+    memcpy(dest, sf_cstr(str1), str1.len);
+    memcpy(dest + str1.len, sf_cstr(str2), str2.len);
+    dest[s] = '\0';
+
+    return new_str;
+}
+
+void sf_str_append(sf_str *str1, const sf_str str2) {
+    sf_str_append_in(NULL, str1, str2);
+}
+
+void sf_str_append_in(const sf_allocator *alloc, sf_str *str1, const sf_str str2) {
+    if (sf_isempty(str2))
+        return;
+    const size_t s = str1->len + str2.len;
+    str1->flags &= (uint8_t)~(SF_STR_EMPTYF | SF_STR_HASHED);
+
+#ifdef SF_STR_SSO
+    if (!(str1->flags & SF_STR_INLINE) && !str1->c_str && s < SF_STR_SSO_SIZE) {
+        str1->flags |= SF_STR_INLINE;
+        str1->len = 0;
+    }
+    if (str1->flags & SF_STR_INLINE) {
+        if (s < SF_STR_SSO_SIZE) {
+            memcpy(str1->sso + str1->len, sf_cstr(str2), str2.len);
+            str1->sso[s] = '\0';
+            str1->len = s;
+            return;
+        }
+        // Outgrew the inline storage, move to the heap.
+        char *heap = sf_alloc(alloc, s + 1);
+        memcpy(heap, str1->sso, str1->len);
+        str1->c_str = heap;
+        str1->flags &= (uint8_t)~SF_STR_INLINE;
+    } else
+#endif
+    {
+        const size_t old_size = str1->c_str ? str1->len + 1 : 0;
+        str1->c_str = sf_realloc(alloc, str1->c_str, old_size, s + 1);
+    }
+    memcpy(str1->c_str + str1->len, sf_cstr(str2), str2.len);
+    str1->len = s;
+    str1->c_str[s] = '\0';
+}
+
+sf_str sf_str_dup(const sf_str string) {
+    return sf_str_dup_in(NULL, string);
+}
+
+sf_str sf_str_dup_in(const sf_allocator *alloc, const sf_str string) {
+    sf_str new_str;
+    char *dest = str_init(alloc, &new_str, string.len);
+    if (!dest)
+        return new_str;
+    memcpy(dest, sf_cstr(string), string.len);
+    dest[string.len] = '\0';
+    if (string.flags & SF_STR_HASHED) {
+        new_str.hash = string.hash;
+        new_str.flags |= SF_STR_HASHED;
+    }
+    return new_str;
+}
+
+int sf_str_cmp(const sf_str str1, const sf_str str2) {
+    const size_t len = min(str1.len, str2.len);
+    const int diff = len ? memcmp(sf_cstr(str1), sf_cstr(str2), len) : 0;
+    if (diff)
+        return diff;
+    return (str1.len > str2.len) - (str1.len < str2.len);
+}
+
+// Searches scan 32 bytes at a time with AVX2 when the CPU has it, 16 with SSE2 otherwise,
+// and finish the tail (or everything, elsewhere) a byte at a time.
+
+static size_t find_char_scalar(const char *s, const size_t n, size_t i, const char c) {
+    for (; i < n; ++i)
+        if (s[i] == c)
+            return i;
+    return SF_STR_NPOS;
+}
+
+static size_t count_char_scalar(const char *s, const size_t n, size_t i, const char c) {
+    size_t count = 0;
+    for (; i < n; ++i)
+        count += s[i] == c;
+    return count;
+}
+
+/// Index of the first match of `needle` at or after `i`, checking every position.
+static size_t find_scalar(const char *s, const size_t n, size_t i, const char *needle, const size_t m) {
+    for (; i + m <= n; ++i)
+        if (s[i] == needle[0] && memcmp(s + i, needle, m) == 0)
+            return i;
+    return SF_STR_NPOS;
+}
+
+static size_t find_any_scalar(const char *s, const size_t n, size_t i, const char *set, const size_t set_len) {
+    bool in_set[256] = { false };
+    for (size_t j = 0; j < set_len; ++j)
+        in_set[(uint8_t)set[j]] = true;
+    for (; i < n; ++i)
+        if (in_set[(uint8_t)s[i]])
+            return i;
+    return SF_STR_NPOS;
+}
+
+/// Sets this small are matched with one compare per byte in the set, larger ones by table.
+#define SIMD_SET_MAX 8
+
+#ifdef SF_CPU_X86
+static size_t find_char_sse2(const char *s, const size_t n, const char c) {
+    const __m128i v = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(s + i)), v));
+        if (mask)
+            return i + cpu_ctz32(mask);
+    }
+    return find_char_scalar(s, n, i, c);
+}
+
+SF_TARGET_AVX2 static size_t find_char_avx2(const char *s, const size_t n, const char c) {
+    const __m256i v = _mm256_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(s + i)), v));
+        if (mask)
+            return i + cpu_ctz32(mask);
+    }
+    return find_char_scalar(s, n, i, c);
+}
+
+static size_t count_char_sse2(const char *s, const size_t n, const char c) {
+    const __m128i v = _mm_set1_epi8(c);
+    size_t i = 0, count = 0;
+    for (; i + 16 <= n; i += 16)
+        count += cpu_popcount32((uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(s + i)), v)));
+    return count + count_char_scalar(s, n, i, c);
+}
+
+SF_TARGET_AVX2 static size_t count_char_avx2(const char *s, const size_t n, const char c) {
+    const __m256i v = _mm256_set1_epi8(c);
+    size_t i = 0, count = 0;
+    for (; i + 32 <= n; i += 32)
+        count += cpu_popcount32((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(s + i)), v)));
+    return count + count_char_scalar(s, n, i, c);
+}
+
+// Substring search compares the first and last byte of the needle at 16 or 32 positions at once,
+// and only checks the full needle where both match.
+
+static size_t find_sse2(const char *s, const size_t n, const char *needle, const size_t m) {
+    const __m128i first = _mm_set1_epi8(needle[0]), last = _mm_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(s + i));
+        const __m128i b = _mm_loadu_si128((const __m128i *)(s + i + m - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        for (; mask; mask &= mask - 1) {
+            const size_t at = i + cpu_ctz32(mask);
+            if (memcmp(s + at + 1, needle + 1, m - 2) == 0)
+                return at;
+        }
+    }
+    return find_scalar(s, n, i, needle, m);
+}
+
+SF_TARGET_AVX2 static size_t find_avx2(const char *s, const size_t n, const char *needle, const size_t m) {
+    const __m256i first = _mm256_set1_epi8(needle[0]), last = _mm256_set1_epi8(needle[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *)(s + i));
+        const __m256i b = _mm256_loadu_si256((const __m256i *)(s + i + m - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        for (; mask; mask &= mask - 1) {
+            const size_t at = i + cpu_ctz32(mask);
+            if (memcmp(s + at + 1, needle + 1, m - 2) == 0)
+                return at;
+        }
+    }
+    return find_scalar(s, n, i, needle, m);
+}
+
+static size_t find_any_sse2(const char *s, const size_t n, const char *set, const size_t set_len) {
+    __m128i v[SIMD_SET_MAX];
+    for (size_t j = 0; j < set_len; ++j)
+        v[j] = _mm_set1_epi8(set[j]);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i block = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i any = _mm_setzero_si128();
+        for (size_t j = 0; j < set_len; ++j)
+            any = _mm_or_si128(any, _mm_cmpeq_epi8(block, v[j]));
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(any);
+        if (mask)
+            return i + cpu_ctz32(mask);
+    }
+    return find_any_scalar(s, n, i, set, set_len);
+}
+
+SF_TARGET_AVX2 static size_t find_any_avx2(const char *s, const size_t n, const char *set, const size_t set_len) {
+    __m256i v[SIMD_SET_MAX];
+    for (size_t j = 0; j < set_len; ++j)
+        v[j] = _mm256_set1_epi8(set[j]);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i block = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i any = _mm256_setzero_si256();
+        for (size_t j = 0; j < set_len; ++j)
+            any = _mm256_or_si256(any, _mm256_cmpeq_epi8(block, v[j]));
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(any);
+        if (mask)
+            return i + cpu_ctz32(mask);
+    }
+    return find_any_scalar(s, n, i, set, set_len);
+}
+#endif
+
+/// Index of `c` in `len` bytes at `s`.
+static size_t find_char(const char *s, const size_t n, const char c) {
+#ifdef SF_CPU_X86
+    return cpu_has_avx2() ? find_char_avx2(s, n, c) : find_char_sse2(s, n, c);
+#else
+    return find_char_scalar(s, n, 0, c);
+#endif
+}
+
+/// Index of `m` bytes at `needle` in `n` bytes at `s`.
+static size_t find(const char *s, const size_t n, const char *needle, const size_t m) {
+    if (m == 0)
+        return 0;
+    if (m > n)
+        return SF_STR_NPOS;
+    if (m == 1)
+        return find_char(s, n, needle[0]);
+#ifdef SF_CPU_X86
+    return cpu_has_avx2() ? find_avx2(s, n, needle, m) : find_sse2(s, n, needle, m);
+#else
+    return find_scalar(s, n, 0, needle, m);
+#endif
+}
+
+/// Index of any of `set_len` bytes at `set` in `n` bytes at `s`.
+static size_t find_any(const char *s, const size_t n, const char *set, const size_t set_len) {
+    if (set_len == 0)
+        return SF_STR_NPOS;
+    if (set_len == 1)
+        return find_char(s, n, set[0]);
+#ifdef SF_CPU_X86
+    if (set_len <= SIMD_SET_MAX)
+        return cpu_has_avx2() ? find_any_avx2(s, n, set, set_len) : find_any_sse2(s, n, set, set_len);
+#endif
+    return find_any_scalar(s, n, 0, set, set_len);
+}
+
+size_t sf_str_find(const sf_str string, const sf_str needle) {
+    return find(sf_cstr(string), string.len, sf_cstr(needle), needle.len);
+}
+
+size_t sf_str_find_char(const sf_str string, const char c) {
+    return find_char(sf_cstr(string), string.len, c);
+}
+
+size_t sf_str_find_any(const sf_str string, const sf_str set) {
+    return find_any(sf_cstr(string), string.len, sf_cstr(set), set.len);
+}
+
+size_t sf_str_count_char(const sf_str string, const char c) {
+    const char *s = sf_cstr(string);
+#ifdef SF_CPU_X86
+    return cpu_has_avx2() ? count_char_avx2(s, string.len, c) : count_char_sse2(s, string.len, c);
+#else
+    return count_char_scalar(s, string.len, 0, c);
+#endif
+}
+
+size_t sf_str_count(const sf_str string, const sf_str needle) {
+    if (needle.len == 0)
+        return 0;
+    if (needle.len == 1)
+        return sf_str_count_char(string, sf_cstr(needle)[0]);
+    const char *s = sf_cstr(string), *m = sf_cstr(needle);
+    size_t count = 0;
+    for (size_t i = 0, at; (at = find(s + i, string.len - i, m, needle.len)) != SF_STR_NPOS; i += at + needle.len)
+        ++count;
+    return count;
+}
+
+/// A view of `len` bytes at `offset`, which must be in bounds. Takes a pointer so the search loops
+/// below don't copy whole strings in and out of calls.
+static sf_str view(const sf_str *string, const size_t offset, const size_t len) {
+#ifdef SF_STR_SSO
+    // A view into an inline string would point into this copy of it, so copy the bytes instead.
+    if (string->flags & SF_STR_INLINE) {
+        sf_str out = { .len = len, .flags = SF_STR_INLINE | SF_STR_CONST };
+        memcpy(out.sso, string->sso + offset, len);
+        out.sso[len] = '\0';
+        return out;
+    }
+#endif
+    return (sf_str) { .c_str = string->c_str ? string->c_str + offset : NULL, .len = len, .flags = SF_STR_CONST };
+}
+
+sf_str sf_str_sub(const sf_str string, size_t offset, const size_t len) {
+    offset = min(offset, string.len);
+    return view(&string, offset, min(len, string.len - offset));
+}
+
+bool sf_str_split_next(sf_str *rest, const sf_str delim, sf_str *piece) {
+    if (sf_isempty(*rest))
+        return false;
+    const size_t at = find(sf_cstr(*rest), rest->len, sf_cstr(delim), delim.len);
+    if (at == SF_STR_NPOS || delim.len == 0) {
+        *piece = view(rest, 0, rest->len);
+        *rest = SF_STR_EMPTY;
+        return true;
+    }
+    *piece = view(rest, 0, at);
+    *rest = view(rest, at + delim.len, rest->len - at - delim.len);
+    return true;
+}
+
+static bool in_set(const char c, const char *set, const size_t set_len) {
+    for (size_t i = 0; i < set_len; ++i)
+        if (set[i] == c)
+            return true;
+    return false;
+}
+
+bool sf_str_tokenize_next(sf_str *rest, const sf_str delims, sf_str *token) {
+    // Skip the run of delimiters before the token.
+    const char *s = sf_cstr(*rest), *set = sf_cstr(delims);
+    size_t start = 0;
+    while (start < rest->len && in_set(s[start], set, delims.len))
+        ++start;
+    if (start == rest->len) {
+        *rest = SF_STR_EMPTY;
+        return false;
+    }
+
+    const size_t end = find_any(s + start, rest->len - start, set, delims.len);
+    const size_t len = end == SF_STR_NPOS ? rest->len - start : end;
+    *token = view(rest, start, len);
+    *rest = view(rest, start + len, rest->len - start - len);
+    return true;
+}
+
+size_t sf_str_split(const sf_str string, const sf_str delim, sf_str *out, const size_t max) {
+    sf_str rest = string;
+    size_t count = 0;
+    while (count < max && sf_str_split_next(&rest, delim, &out[count]))
+        ++count;
+    return count;
+}
+
+static bool is_space(const char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+sf_str sf_str_trim_left(const sf_str string) {
+    const char *s = sf_cstr(string);
+    size_t start = 0;
+    while (start < string.len && is_space(s[start]))
+        ++start;
+    return view(&string, start, string.len - start);
+}
+
+sf_str sf_str_trim_right(const sf_str string) {
+    const char *s = sf_cstr(string);
+    size_t len = string.len;
+    while (len && is_space(s[len - 1]))
+        --len;
+    return view(&string, 0, len);
+}
+
+sf_str sf_str_trim(const sf_str string) {
+    return sf_str_trim_left(sf_str_trim_right(string));
+}
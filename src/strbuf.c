@@ -0,0 +1,189 @@
+#include <math.h>
+#include <stdio.h>
+#include "sf/strbuf.h"
+#include "sf/num.h"
+
+sf_strbuf sf_strbuf_new(void) {
+    return sf_strbuf_new_in(NULL);
+}
+
+sf_strbuf sf_strbuf_new_in(const sf_allocator *alloc) {
+    return (sf_strbuf) {
+        .ptr = NULL,
+        .len = 0,
+        .capacity = 0,
+        .alloc = alloc,
+    };
+}
+
+void sf_strbuf_free(sf_strbuf *sb) {
+    if (sb->ptr)
+        sf_free(sb->alloc, sb->ptr, sb->capacity);
+    sb->ptr = NULL;
+    sb->len = sb->capacity = 0;
+}
+
+void sf_strbuf_clear(sf_strbuf *sb) {
+    sb->len = 0;
+    if (sb->ptr)
+        sb->ptr[0] = '\0';
+}
+
+bool sf_strbuf_reserve(sf_strbuf *sb, const size_t additional) {
+    if (additional >= SIZE_MAX - sb->len)
+        return false;
+    const size_t needed = sb->len + additional + 1;
+    if (needed <= sb->capacity)
+        return true;
+
+    size_t capacity = sb->capacity ? sb->capacity : SF_STRBUF_MIN_CAPACITY;
+    while (capacity < needed)
+        capacity = capacity > SIZE_MAX / 2 ? needed : capacity * 2;
+    char *p = sb->ptr
+        ? sf_realloc(sb->alloc, sb->ptr, sb->capacity, capacity)
+        : sf_alloc(sb->alloc, capacity);
+    if (!p)
+        return false;
+    sb->ptr = p;
+    sb->capacity = capacity;
+    return true;
+}
+
+/// Append `len` bytes, keeping the contents null terminated.
+static bool append(sf_strbuf *sb, const char *bytes, const size_t len) {
+    if (!sf_strbuf_reserve(sb, len))
+        return false;
+    if (len)
+        memcpy(sb->ptr + sb->len, bytes, len);
+    sb->len += len;
+    sb->ptr[sb->len] = '\0';
+    return true;
+}
+
+bool sf_strbuf_append(sf_strbuf *sb, const sf_str string) {
+    return append(sb, sf_cstr(string), string.len);
+}
+
+bool sf_strbuf_append_char(sf_strbuf *sb, const char c) {
+    if (sb->len + 1 >= sb->capacity && !sf_strbuf_reserve(sb, 1))
+        return false;
+    sb->ptr[sb->len++] = c;
+    sb->ptr[sb->len] = '\0';
+    return true;
+}
+
+bool sf_strbuf_append_uint(sf_strbuf *sb, const uint64_t value) {
+    if (!sf_strbuf_reserve(sb, SF_NUM_BUFFER_SIZE))
+        return false;
+    sb->len += sf_u64_to_str(value, sb->ptr + sb->len).len;
+    return true;
+}
+
+bool sf_strbuf_append_int(sf_strbuf *sb, const int64_t value) {
+    if (!sf_strbuf_reserve(sb, SF_NUM_BUFFER_SIZE))
+        return false;
+    sb->len += sf_i64_to_str(value, sb->ptr + sb->len).len;
+    return true;
+}
+
+bool sf_strbuf_append_double(sf_strbuf *sb, const double value) {
+    if (!sf_strbuf_reserve(sb, SF_NUM_BUFFER_SIZE))
+        return false;
+    sb->len += sf_f64_to_str(value, sb->ptr + sb->len).len;
+    return true;
+}
+
+bool sf_strbuf_append_float(sf_strbuf *sb, const double value, unsigned precision) {
+    static const uint64_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+    precision = precision > 9 ? 9 : precision;
+    const bool negative = signbit(value);
+    const double magnitude = negative ? -value : value;
+    // Fixed point needs the scaled value to fit in 64 bits. Doubles that large are integers anyway.
+    if (isnan(value) || magnitude * (double)pow10[precision] >= 1e18)
+        return sf_strbuf_append_double(sb, value);
+
+    const uint64_t scaled = (uint64_t)(magnitude * (double)pow10[precision] + 0.5);
+    if (!sf_strbuf_reserve(sb, SF_NUM_BUFFER_SIZE))
+        return false;
+    char *out = sb->ptr + sb->len;
+    if (negative)
+        *out++ = '-';
+    out += sf_u64_to_str(scaled / pow10[precision], out).len;
+    if (precision) {
+        char digits[SF_NUM_BUFFER_SIZE];
+        const sf_str fraction = sf_u64_to_str(scaled % pow10[precision], digits);
+        *out++ = '.';
+        memset(out, '0', precision - fraction.len);
+        memcpy(out + precision - fraction.len, digits, fraction.len);
+        out += precision;
+    }
+    *out = '\0';
+    sb->len = (size_t)(out - sb->ptr);
+    return true;
+}
+
+bool sf_strbuf_appendf(sf_strbuf *sb, const char *format, ...) {
+    va_list arglist;
+    va_start(arglist, format);
+    const bool ok = sf_strbuf_vappendf(sb, format, arglist);
+    va_end(arglist);
+    return ok;
+}
+
+bool sf_strbuf_vappendf(sf_strbuf *sb, const char *format, va_list args) {
+    // Format straight into the spare capacity, only running again if it didn't fit.
+    if (sb->capacity - sb->len < SF_STRBUF_MIN_CAPACITY && !sf_strbuf_reserve(sb, SF_STRBUF_MIN_CAPACITY))
+        return false;
+    va_list arglist;
+    va_copy(arglist, args);
+    const int n = vsnprintf(sb->ptr + sb->len, sb->capacity - sb->len, format, arglist);
+    va_end(arglist);
+    if (n < 0) {
+        sb->ptr[sb->len] = '\0';
+        return false;
+    }
+
+    const size_t size = (size_t)n;
+    if (size >= sb->capacity - sb->len) {
+        if (!sf_strbuf_reserve(sb, size)) {
+            sb->ptr[sb->len] = '\0';
+            return false;
+        }
+        va_copy(arglist, args);
+        vsnprintf(sb->ptr + sb->len, size + 1, format, arglist);
+        va_end(arglist);
+    }
+    sb->len += size;
+    return true;
+}
+
+sf_str sf_strbuf_finish(sf_strbuf *sb) {
+    if (!sb->ptr && !sf_strbuf_reserve(sb, 0))
+        return SF_STR_EMPTY;
+    sb->ptr[sb->len] = '\0';
+
+    sf_str out = { .c_str = sb->ptr, .len = sb->len, .flags = SF_STR_NONE };
+#ifdef SF_STR_SSO
+    if (sb->len < SF_STR_SSO_SIZE) {
+        out.flags |= SF_STR_INLINE;
+        memcpy(out.sso, sb->ptr, sb->len + 1);
+        sf_strbuf_free(sb);
+        return out;
+    }
+#endif
+    // Strings are freed by their length, so trim the spare capacity. Allocators shrink in place,
+    // one that can't gets an exact copy instead.
+    if (sb->capacity != sb->len + 1) {
+        char *p = sf_realloc(sb->alloc, sb->ptr, sb->capacity, sb->len + 1);
+        if (!p) {
+            p = sf_alloc(sb->alloc, sb->len + 1);
+            if (!p)
+                return SF_STR_EMPTY;
+            memcpy(p, sb->ptr, sb->len + 1);
+            sf_free(sb->alloc, sb->ptr, sb->capacity);
+        }
+        out.c_str = p;
+    }
+    *sb = sf_strbuf_new_in(sb->alloc);
+    return out;
+}
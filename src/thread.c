@@ -0,0 +1,93 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdlib.h>
+#include "sf/thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+/// Heap allocated start parameters, owned by the new thread.
+typedef struct {
+    void (*func)(void *ud);
+    void *ud;
+} thread_start;
+
+#ifdef _WIN32
+
+void sf_mutex_init(sf_mutex *mutex) { InitializeSRWLock((PSRWLOCK)&mutex->lock); }
+void sf_mutex_destroy(sf_mutex *mutex) { (void)mutex; }
+void sf_mutex_lock(sf_mutex *mutex) { AcquireSRWLockExclusive((PSRWLOCK)&mutex->lock); }
+void sf_mutex_unlock(sf_mutex *mutex) { ReleaseSRWLockExclusive((PSRWLOCK)&mutex->lock); }
+
+static unsigned __stdcall thread_main(void *ud) {
+    const thread_start start = *(thread_start *)ud;
+    free(ud);
+    start.func(start.ud);
+    return 0;
+}
+
+bool sf_thread_start(sf_thread *thread, void (*func)(void *ud), void *ud) {
+    thread_start *start = malloc(sizeof(thread_start));
+    if (!start)
+        return false;
+    *start = (thread_start) { func, ud };
+    thread->handle = (void *)_beginthreadex(NULL, 0, thread_main, start, 0, NULL);
+    if (!thread->handle) {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void sf_thread_join(sf_thread thread) {
+    WaitForSingleObject(thread.handle, INFINITE);
+    CloseHandle(thread.handle);
+}
+
+size_t sf_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+void sf_mutex_init(sf_mutex *mutex) { pthread_mutex_init(&mutex->lock, NULL); }
+void sf_mutex_destroy(sf_mutex *mutex) { pthread_mutex_destroy(&mutex->lock); }
+void sf_mutex_lock(sf_mutex *mutex) { pthread_mutex_lock(&mutex->lock); }
+void sf_mutex_unlock(sf_mutex *mutex) { pthread_mutex_unlock(&mutex->lock); }
+
+static void *thread_main(void *ud) {
+    const thread_start start = *(thread_start *)ud;
+    free(ud);
+    start.func(start.ud);
+    return NULL;
+}
+
+bool sf_thread_start(sf_thread *thread, void (*func)(void *ud), void *ud) {
+    thread_start *start = malloc(sizeof(thread_start));
+    if (!start)
+        return false;
+    *start = (thread_start) { func, ud };
+    if (pthread_create(&thread->handle, NULL, thread_main, start) != 0) {
+        free(start);
+        return false;
+    }
+    return true;
+}
+
+void sf_thread_join(const sf_thread thread) {
+    pthread_join(thread.handle, NULL);
+}
+
+size_t sf_cpu_count(void) {
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
+
+#endif
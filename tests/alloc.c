@@ -0,0 +1,91 @@
+#include <assert.h>
+#include "sf/alloc.h"
+#include "sf/str.h"
+#include "sf/containers/buffer.h"
+
+#define VEC_NAME vec_int
+#define VEC_T int
+#include "sf/containers/vec.h"
+
+#define MAP_NAME map_ii
+#define MAP_K int
+#define MAP_V int
+#include "sf/containers/map.h"
+
+#define MAP_NAME swiss_ii
+#define MAP_K int
+#define MAP_V int
+#include "sf/containers/swiss_map.h"
+
+/// Tracks live bytes so every size handed back on free must match the allocation.
+typedef struct {
+    size_t live;
+    size_t calls;
+} counter;
+
+static void *count_alloc(void *ud, size_t size) {
+    counter *c = ud;
+    c->live += size;
+    c->calls++;
+    return malloc(size);
+}
+static void *count_realloc(void *ud, void *ptr, size_t old_size, size_t size) {
+    counter *c = ud;
+    c->live += size - old_size;
+    c->calls++;
+    return realloc(ptr, size);
+}
+static void count_free(void *ud, void *ptr, size_t size) {
+    counter *c = ud;
+    c->live -= size;
+    free(ptr);
+}
+
+int main(void) {
+    counter c = { 0, 0 };
+    const sf_allocator alloc = { count_alloc, count_realloc, count_free, &c };
+
+    vec_int vec = vec_int_new_in(&alloc);
+    for (int i = 0; i < 100; ++i)
+        vec_int_push(&vec, i);
+    for (int i = 0; i < 90; ++i)
+        vec_int_pop(&vec);
+    vec_int_insert(&vec, 0, 7);
+    vec_int_delete(&vec, 0);
+    assert(c.calls > 0 && c.live == vec.slots * sizeof(int));
+    vec_int_free(&vec);
+    assert(c.live == 0);
+
+    map_ii map = map_ii_new_in(&alloc);
+    for (int i = 0; i < 100; ++i)
+        map_ii_set(&map, i, i);
+    for (int i = 0; i < 50; ++i)
+        map_ii_delete(&map, i);
+    map_ii_free(&map);
+    assert(c.live == 0);
+
+    swiss_ii swiss = swiss_ii_new_in(&alloc);
+    for (int i = 0; i < 100; ++i)
+        swiss_ii_set(&swiss, i, i);
+    swiss_ii_free(&swiss);
+    assert(c.live == 0);
+
+    sf_buffer buff = sf_buffer_grow_in(&alloc);
+    for (int i = 0; i < 10; ++i) {
+        sf_buffer_ex res = sf_buffer_autoins(&buff, &i);
+        assert(res.is_ok);
+    }
+    sf_buffer_clear(&buff);
+    assert(c.live == 0);
+
+    sf_str s = sf_str_fmt_in(&alloc, "%d-%s", 12, "twelve");
+    assert(sf_str_eq(s, sf_lit("12-twelve")));
+    sf_str_append_in(&alloc, &s, sf_lit("!"));
+    sf_str j = sf_str_join_in(&alloc, s, sf_lit("?"));
+    sf_str d = sf_str_dup_in(&alloc, j);
+    assert(sf_str_eq(d, sf_lit("12-twelve!?")));
+    sf_str_free_in(&alloc, s);
+    sf_str_free_in(&alloc, j);
+    sf_str_free_in(&alloc, d);
+    assert(c.live == 0);
+}
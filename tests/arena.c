@@ -0,0 +1,46 @@
+#include <assert.h>
+#include "sf/arena.h"
+
+#define VEC_NAME vec_int
+#define VEC_T int
+#include "sf/containers/vec.h"
+
+int main(void) {
+    sf_arena arena = sf_arena_new(256);
+
+    int *a = sf_arena_new_array(&arena, int, 4);
+    assert(a && (uintptr_t)a % _Alignof(int) == 0);
+    a[3] = 7;
+    void *aligned = sf_arena_alloc_aligned(&arena, 8, 64);
+    assert(aligned && (uintptr_t)aligned % 64 == 0);
+
+    // Everything past a mark is released on restore, and the space reused.
+    sf_arena_mark mark = sf_arena_save(&arena);
+    void *scratch = sf_arena_alloc(&arena, 32);
+    void *big = sf_arena_alloc(&arena, 4096);
+    assert(scratch && big && arena.head->size >= 4096);
+    sf_arena_restore(&arena, mark);
+    assert(sf_arena_alloc(&arena, 32) == scratch);
+    assert(a[3] == 7);
+
+    sf_str s = sf_str_fmt_arena(&arena, "%d-%s", 12, "twelve");
+    assert(sf_str_eq(s, sf_lit("12-twelve")));
+    sf_str j = sf_str_join_arena(&arena, s, sf_lit("!"));
+    sf_str d = sf_str_dup_arena(&arena, j);
+    assert(sf_str_eq(d, sf_lit("12-twelve!")) && sf_cstr(d) != sf_cstr(j));
+    sf_str_free(d); // No-op on arena strings.
+
+    // Containers can allocate from the arena, and the last allocation grows in place.
+    sf_allocator alloc = sf_arena_allocator(&arena);
+    vec_int vec = vec_int_new_in(&alloc);
+    for (int i = 0; i < 1000; ++i)
+        vec_int_push(&vec, i);
+    for (int i = 0; i < 1000; ++i)
+        assert(vec_int_get(&vec, (size_t)i) == i);
+    vec_int_free(&vec);
+
+    sf_arena_reset(&arena);
+    assert(arena.head && arena.head->used == 0 && !arena.head->prev);
+    sf_arena_free(&arena);
+    assert(!arena.head && !arena.spare);
+}
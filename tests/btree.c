@@ -0,0 +1,168 @@
+#include <assert.h>
+#include "sf/str.h"
+
+#define MAP_NAME btree_ii
+#define MAP_K int
+#define MAP_V int
+#include "sf/containers/btree.h"
+
+// Small nodes, so a few hundred keys already make a tree several levels deep.
+#define MAP_NAME btree_small
+#define MAP_K uint32_t
+#define MAP_V uint32_t
+#define BTREE_NODE_BYTES 64
+#include "sf/containers/btree.h"
+
+// Nodes smaller than their header still hold the minimum of 4 keys.
+#define MAP_NAME btree_tiny
+#define MAP_K uint16_t
+#define MAP_V uint16_t
+#define BTREE_NODE_BYTES 8
+#include "sf/containers/btree.h"
+
+static int str_cmp(const sf_str a, const sf_str b) {
+    return sf_str_cmp(a, b);
+}
+#define MAP_NAME btree_ss
+#define MAP_K sf_str
+#define MAP_V int
+#define CMP_FN str_cmp
+#include "sf/containers/btree.h"
+
+/// Checks that a subtree is ordered within [lo, hi) and nodes other than the root are at least half full.
+/// Returns the amount of pairs below it.
+static size_t check_node(const btree_small *map, const void *node, const size_t height, const uint32_t lo, const uint32_t hi) {
+    if (height == 0) {
+        const btree_small_leaf *leaf = node;
+        assert(node == map->root || leaf->count >= sizeof(leaf->keys) / sizeof(*leaf->keys) / 2);
+        for (size_t i = 0; i < leaf->count; ++i)
+            assert(leaf->keys[i] >= lo && leaf->keys[i] < hi && (i == 0 || leaf->keys[i - 1] < leaf->keys[i]));
+        return leaf->count;
+    }
+    const btree_small_inner *inner = node;
+    assert(node == map->root ? inner->count >= 1 : inner->count >= sizeof(inner->keys) / sizeof(*inner->keys) / 2);
+    size_t pairs = 0;
+    for (size_t i = 0; i <= inner->count; ++i) {
+        const uint32_t from = i == 0 ? lo : inner->keys[i - 1], to = i == inner->count ? hi : inner->keys[i];
+        assert(from < to);
+        pairs += check_node(map, inner->children[i], height - 1, from, to);
+    }
+    return pairs;
+}
+static void check_tree(const btree_small *map) {
+    assert(!map->root || check_node(map, map->root, map->height, 0, UINT32_MAX) == map->count);
+}
+
+/// Sums the keys and values passed to it.
+static void sum_pairs(void *ud, const int key, const int value) {
+    *(long *)ud += key * 1000 + value;
+}
+
+int main(void) {
+    btree_ii map = btree_ii_new();
+    assert(!btree_ii_get(&map, 1).is_ok && !btree_ii_iter_valid(btree_ii_begin(&map)));
+    btree_ii_set(&map, 3, 30);
+    btree_ii_set(&map, 1, 10);
+    btree_ii_set(&map, 2, 20);
+    btree_ii_set(&map, 3, 31);
+    assert(map.count == 3 && btree_ii_get(&map, 3).ok == 31 && btree_ii_get(&map, 1).ok == 10);
+    long sum = 0;
+    btree_ii_foreach(&map, sum_pairs, &sum);
+    assert(sum == 1010 + 2020 + 3031);
+    btree_ii_delete(&map, 2);
+    btree_ii_delete(&map, 7);
+    assert(map.count == 2 && !btree_ii_get(&map, 2).is_ok);
+    btree_ii_delete(&map, 1);
+    btree_ii_delete(&map, 3);
+    assert(map.count == 0 && map.root == NULL);
+    btree_ii_free(&map);
+
+    // Random inserts and deletes, mirrored in a plain array.
+    enum { KEYS = 2000 };
+    static uint32_t present[KEYS];
+    btree_small tree = btree_small_new();
+    uint64_t seed = 7;
+    for (int step = 0; step < 40000; ++step) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        const uint32_t key = (uint32_t)(seed >> 33) % KEYS;
+        // Fill up for the first half, then drain.
+        if ((seed >> 20) % 4 < (step < 20000 ? 3u : 1u)) {
+            btree_small_set(&tree, key, key + 1);
+            present[key] = key + 1;
+        } else {
+            btree_small_delete(&tree, key);
+            present[key] = 0;
+        }
+        if (step % 1000 == 0)
+            check_tree(&tree);
+    }
+    check_tree(&tree);
+    size_t count = 0;
+    for (uint32_t key = 0; key < KEYS; ++key) {
+        const btree_small_ex found = btree_small_get(&tree, key);
+        assert(found.is_ok == (present[key] != 0) && (!found.is_ok || found.ok == present[key]));
+        count += present[key] != 0;
+    }
+    assert(tree.count == count && tree.height > 1);
+
+    // Iterators walk both ways in order, and lower_bound lands on the next present key.
+    uint32_t previous = 0, seen = 0;
+    for (btree_small_iter it = btree_small_begin(&tree); btree_small_iter_valid(it); btree_small_iter_next(&it)) {
+        assert(seen == 0 || btree_small_iter_key(it) > previous);
+        assert(btree_small_iter_value(it) == btree_small_iter_key(it) + 1);
+        previous = btree_small_iter_key(it);
+        ++seen;
+    }
+    assert(seen == count);
+    for (btree_small_iter it = btree_small_rbegin(&tree); btree_small_iter_valid(it); btree_small_iter_prev(&it))
+        --seen;
+    assert(seen == 0);
+    for (uint32_t key = 0; key < KEYS; ++key) {
+        uint32_t next = key;
+        while (next < KEYS && !present[next])
+            ++next;
+        const btree_small_iter it = btree_small_lower_bound(&tree, key);
+        assert(next == KEYS ? !btree_small_iter_valid(it) : btree_small_iter_key(it) == next);
+    }
+
+    // Draining empties the tree back to no nodes at all.
+    for (uint32_t key = 0; key < KEYS; ++key)
+        btree_small_delete(&tree, key);
+    assert(tree.count == 0 && tree.root == NULL && tree.first == NULL);
+
+    // Bulk loading builds a valid tree for every size, keeping the last of repeated keys.
+    uint32_t keys[700], values[700];
+    for (uint32_t n = 0; n < 700; n += n < 40 ? 1 : 37) {
+        for (uint32_t i = 0; i < n; ++i) {
+            keys[i] = i / 2 * 3;
+            values[i] = i;
+        }
+        assert(btree_small_build_sorted(&tree, keys, values, n) && tree.count == (n + 1) / 2);
+        check_tree(&tree);
+        for (uint32_t i = 0; i < n; ++i)
+            assert(btree_small_get(&tree, i / 2 * 3).ok == (i % 2 || i + 1 == n ? i : i + 1));
+        btree_small_set(&tree, 1, 1);
+        btree_small_delete(&tree, 0);
+        check_tree(&tree);
+    }
+    btree_small_free(&tree);
+
+    btree_tiny tiny = btree_tiny_new();
+    for (uint16_t key = 0; key < 100; ++key)
+        btree_tiny_set(&tiny, key, (uint16_t)(key * 2));
+    assert(tiny.count == 100 && tiny.height > 1 && btree_tiny_get(&tiny, 99).ok == 198);
+    btree_tiny_free(&tiny);
+
+    // A time window query over string keys.
+    btree_ss events = btree_ss_new();
+    btree_ss_set(&events, sf_lit("2024-03-01"), 1);
+    btree_ss_set(&events, sf_lit("2024-01-15"), 2);
+    btree_ss_set(&events, sf_lit("2024-02-10"), 3);
+    btree_ss_set(&events, sf_lit("2024-02-28"), 4);
+    int window = 0;
+    for (btree_ss_iter it = btree_ss_lower_bound(&events, sf_lit("2024-02"));
+         btree_ss_iter_valid(it) && sf_str_cmp(btree_ss_iter_key(it), sf_lit("2024-03")) < 0; btree_ss_iter_next(&it))
+        window = window * 10 + btree_ss_iter_value(it);
+    assert(window == 34);
+    btree_ss_free(&events);
+}
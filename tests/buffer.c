@@ -1,39 +1,69 @@
-#include <assert.h>
-#include <string.h>
-#include "sf/containers/buffer.h"
-#include "sf/result.h"
-
-int main(void) {
-    sf_buffer buff = sf_buffer_fixed(1024);
-
-    unsigned char bytes[1024] = { 4, 2, 0, 6, 9 };
-    sf_result res = sf_buffer_insert(&buff, bytes, sizeof(bytes));
-    assert(res.is_ok);
-    sf_discard(res);
-    assert(memcmp(buff.ptr, bytes, sizeof(bytes)) == 0);
-
-    sf_buffer_clear(&buff);
-
-
-    buff = sf_buffer_fixed(512);
-
-    res = sf_buffer_insert(&buff, bytes, sizeof(bytes));
-    assert(!res.is_ok);
-    sf_discard(res);
-
-    sf_buffer_clear(&buff);
-
-
-    buff = sf_buffer_grow();
-
-    res = sf_buffer_insert(&buff, bytes, sizeof(bytes));
-    assert(res.is_ok);
-    sf_discard(res);
-    assert(buff.size == sizeof(bytes));
-
-    sf_buffer_clear(&buff);
-
-
-    buff = sf_buffer_own(bytes, sizeof(bytes));
-    assert(memcmp(buff.ptr, bytes, sizeof(bytes)) == 0);
+#include <assert.h>
+#include <string.h>
+#include "sf/containers/buffer.h"
+
+int main(void) {
+    sf_buffer buff = sf_buffer_fixed(1024);
+
+    unsigned char bytes[1024] = { 4, 2, 0, 6, 9 };
+    sf_buffer_ex res = sf_buffer_insert(&buff, bytes, sizeof(bytes));
+    assert(res.is_ok);
+    assert(memcmp(buff.ptr, bytes, sizeof(bytes)) == 0);
+
+    sf_buffer_clear(&buff);
+
+
+    buff = sf_buffer_fixed(512);
+
+    res = sf_buffer_insert(&buff, bytes, sizeof(bytes));
+    assert(!res.is_ok);
+
+    sf_buffer_clear(&buff);
+
+
+    buff = sf_buffer_grow();
+
+    res = sf_buffer_insert(&buff, bytes, sizeof(bytes));
+    assert(res.is_ok);
+    assert(buff.size == sizeof(bytes));
+
+    sf_buffer_clear(&buff);
+
+
+    buff = sf_buffer_grow();
+
+    // Small inserts grow geometrically instead of one realloc per insert.
+    size_t reallocs = 0, capacity = 0;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        res = sf_buffer_autoins(&buff, &i);
+        assert(res.is_ok);
+        reallocs += buff.capacity != capacity;
+        capacity = buff.capacity;
+    }
+    assert(buff.size == 10000 * sizeof(uint32_t) && buff.capacity >= buff.size);
+    assert(reallocs < 16);
+
+    res = sf_buffer_reserve(&buff, 1 << 20);
+    assert(res.is_ok && buff.capacity == 1 << 20 && buff.size == 10000 * sizeof(uint32_t));
+
+    sf_buffer_prep_ex prep = sf_buffer_prepare(&buff, 16);
+    assert(prep.is_ok && prep.ok == buff.head);
+    memcpy(prep.ok, "prepared+commit!", 16);
+    sf_buffer_commit(&buff, 16);
+    assert(buff.size == 10000 * sizeof(uint32_t) + 16);
+    assert(memcmp(buff.ptr + 10000 * sizeof(uint32_t), "prepared+commit!", 16) == 0);
+
+    sf_buffer_clear(&buff);
+    assert(buff.capacity == 0 && buff.size == 0);
+
+
+    buff = sf_buffer_fixed(8);
+    assert(!sf_buffer_reserve(&buff, 16).is_ok);
+    assert(!sf_buffer_prepare(&buff, 16).is_ok);
+    assert(sf_buffer_prepare(&buff, 8).is_ok);
+    sf_buffer_clear(&buff);
+
+
+    buff = sf_buffer_own(bytes, sizeof(bytes));
+    assert(memcmp(buff.ptr, bytes, sizeof(bytes)) == 0);
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include <assert.h>
+#include "sf/str.h"
+
+#define MAP_NAME flat_ii
+#define MAP_K int
+#define MAP_V int
+#include "sf/containers/flat_map.h"
+
+static bool str_less(const sf_str a, const sf_str b) {
+    return sf_str_cmp(a, b) < 0;
+}
+#define MAP_NAME flat_ss
+#define MAP_K sf_str
+#define MAP_V sf_str
+#define LESS_FN str_less
+#include "sf/containers/flat_map.h"
+
+/// Sums the keys and values passed to it.
+static void sum_pairs(void *ud, const int key, const int value) {
+    *(long *)ud += key * 1000 + value;
+}
+
+int main(void) {
+    // Every tree shape finds its keys and the gaps between them.
+    int keys[200], values[200];
+    for (int n = 0; n <= 130; ++n) {
+        for (int i = 0; i < n; ++i) {
+            keys[i] = (i * 131 % n) * 2;
+            values[i] = keys[i] + 1;
+        }
+        flat_ii map = flat_ii_new();
+        assert(flat_ii_build(&map, keys, values, (size_t)n) && map.count == (size_t)n);
+        for (int i = 0; i < n; ++i) {
+            assert(map.keys[i] == i * 2 && map.values[i] == i * 2 + 1);
+            const flat_ii_ex found = flat_ii_get(&map, i * 2);
+            assert(found.is_ok && found.ok == i * 2 + 1);
+            assert(!flat_ii_get(&map, i * 2 + 1).is_ok && !flat_ii_get(&map, -i - 1).is_ok);
+            assert(flat_ii_lower_bound(&map, i * 2 - 1) == (size_t)i && flat_ii_lower_bound(&map, i * 2) == (size_t)i);
+        }
+        assert(flat_ii_lower_bound(&map, n * 2) == (size_t)n);
+        flat_ii_free(&map);
+    }
+
+    // Repeated keys keep their last value, in builds and batches alike.
+    flat_ii map = flat_ii_new();
+    const int dup_keys[] = { 5, 1, 5, 3, 1, 5 }, dup_values[] = { 1, 2, 3, 4, 5, 6 };
+    assert(flat_ii_build(&map, dup_keys, dup_values, 6) && map.count == 3);
+    assert(flat_ii_get(&map, 1).ok == 5 && flat_ii_get(&map, 3).ok == 4 && flat_ii_get(&map, 5).ok == 6);
+    const int batch_keys[] = { 4, 0, 3, 9, 4 }, batch_values[] = { 40, 0, 30, 90, 41 };
+    assert(flat_ii_insert_batch(&map, batch_keys, batch_values, 5) && map.count == 6);
+    const int merged[] = { 0, 1, 3, 4, 5, 9 };
+    for (size_t i = 0; i < map.count; ++i)
+        assert(map.keys[i] == merged[i]);
+    assert(flat_ii_get(&map, 3).ok == 30 && flat_ii_get(&map, 4).ok == 41 && flat_ii_get(&map, 1).ok == 5);
+
+    long sum = 0;
+    flat_ii_range(&map, 2, 5, sum_pairs, &sum);
+    assert(sum == 3030 + 4041);
+    sum = 0;
+    flat_ii_range(&map, 6, 100, sum_pairs, &sum);
+    assert(sum == 9090);
+    sum = 0;
+    flat_ii_foreach(&map, sum_pairs, &sum);
+    assert(sum == 0 + 1005 + 3030 + 4041 + 5006 + 9090);
+
+    assert(flat_ii_set(&map, 2, 20) && flat_ii_set(&map, 9, 99) && map.count == 7);
+    flat_ii_delete(&map, 0);
+    flat_ii_delete(&map, 7);
+    assert(map.count == 6 && !flat_ii_get(&map, 0).is_ok && flat_ii_get(&map, 2).ok == 20);
+    assert(flat_ii_get(&map, 9).ok == 99 && flat_ii_get(&map, 5).ok == 6);
+    assert(flat_ii_build(&map, NULL, NULL, 0) && map.count == 0 && !flat_ii_get(&map, 1).is_ok);
+    flat_ii_free(&map);
+
+    // A routing table with string keys.
+    flat_ss routes = flat_ss_new();
+    const sf_str paths[] = { sf_lit("/users"), sf_lit("/"), sf_lit("/users/new"), sf_lit("/about") };
+    const sf_str handlers[] = { sf_lit("list"), sf_lit("index"), sf_lit("create"), sf_lit("about") };
+    assert(flat_ss_build(&routes, paths, handlers, 4));
+    assert(sf_str_eq(flat_ss_get(&routes, sf_lit("/users/new")).ok, sf_lit("create")));
+    assert(sf_str_eq(flat_ss_get(&routes, sf_lit("/")).ok, sf_lit("index")));
+    assert(!flat_ss_get(&routes, sf_lit("/user")).is_ok);
+    assert(flat_ss_lower_bound(&routes, sf_lit("/users")) == 2);
+    flat_ss_free(&routes);
+}
@@ -1,15 +1,183 @@
-#include <assert.h>
-#include <stdlib.h>
-#include "sf/fs.h"
-#include "sf/str.h"
-
-int main(void) {
-    long size = sf_file_size(sf_lit("CMakeLists.txt"));
-    assert(size > 0);
-
-    uint8_t *file = malloc((size_t)size);
-    sf_result res = sf_load_file(file, sf_lit("CMakeLists.txt"));
-    assert(res.is_ok);
-
-    free(file);
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "sf/fs.h"
+#include "sf/str.h"
+
+int main(void) {
+    long size = sf_file_size(sf_lit("CMakeLists.txt"));
+    assert(size > 0);
+
+    uint8_t *file = malloc((size_t)size);
+    sf_fs_ex res = sf_load_file(file, sf_lit("CMakeLists.txt"));
+    assert(res.is_ok);
+
+
+    // A mapped file reads the same bytes, but refuses writes.
+    sf_fsb_ex mapped = sf_file_map(sf_lit("CMakeLists.txt"), SF_MAP_SEQUENTIAL | SF_MAP_WILLNEED);
+    assert(mapped.is_ok && mapped.ok.size == (size_t)size);
+    assert(memcmp(mapped.ok.ptr, file, (size_t)size) == 0);
+    assert(mapped.ok.flags & SF_BUFFER_READONLY);
+    sf_buffer_ex ins = sf_buffer_insert(&mapped.ok, "x", 1);
+    assert(!ins.is_ok && ins.err == SF_BUFFER_NOT_WRITABLE);
+    assert(!sf_buffer_prepare(&mapped.ok, 1).is_ok);
+
+    char first;
+    assert(sf_buffer_autoread(&mapped.ok, &first).is_ok && first == (char)file[0]);
+    sf_file_advise(&mapped.ok, SF_MAP_RANDOM);
+    sf_buffer_clear(&mapped.ok);
+    assert(!mapped.ok.ptr);
+
+    mapped = sf_file_map(sf_lit("does/not/exist"), 0);
+    assert(!mapped.is_ok && mapped.err == SF_FILE_NOT_FOUND);
+
+    // Streaming in tiny chunks sees the same bytes, and lines survive chunk boundaries.
+    sf_fsr_ex reader = sf_file_reader_open(sf_lit("CMakeLists.txt"), 7);
+    assert(reader.is_ok);
+    size_t streamed = 0;
+    for (sf_fss_ex chunk; (chunk = sf_file_reader_next(&reader.ok)).is_ok; streamed += chunk.ok.len) {
+        assert(chunk.ok.len <= 7);
+        assert(memcmp(chunk.ok.c_str, file + streamed, chunk.ok.len) == 0);
+    }
+    assert(streamed == (size_t)size);
+    sf_file_reader_close(&reader.ok);
+
+    reader = sf_file_reader_open(sf_lit("CMakeLists.txt"), 5);
+    assert(reader.is_ok);
+    size_t offset = 0, lines = 0;
+    for (sf_fss_ex line; (line = sf_file_reader_next_line(&reader.ok)).is_ok; ++lines) {
+        assert(memcmp(line.ok.c_str, file + offset, line.ok.len) == 0);
+        assert(!memchr(line.ok.c_str, '\n', line.ok.len));
+        offset += line.ok.len;
+        if (offset < (size_t)size && file[offset] == '\r')
+            ++offset;
+        if (offset < (size_t)size && file[offset] == '\n')
+            ++offset;
+    }
+    assert(offset == (size_t)size && lines > 1);
+    assert(sf_file_reader_next_line(&reader.ok).err == SF_EOF);
+    sf_file_reader_close(&reader.ok);
+
+    assert(sf_file_reader_open(sf_lit("does/not/exist"), 0).err == SF_FILE_NOT_FOUND);
+
+    // Batches load every file concurrently, failures stay per file.
+    enum { PATHS = 300 };
+    static sf_str paths[PATHS];
+    for (size_t i = 0; i < PATHS; ++i)
+        paths[i] = i % 3 == 0 ? sf_lit("CMakeLists.txt") : i % 3 == 1 ? sf_lit("tests/fs.c") : sf_lit("does/not/exist");
+    sf_fsb_ex expected = sf_file_buffer(sf_lit("tests/fs.c"));
+    assert(expected.is_ok);
+    for (uint32_t flags = 0; flags <= SF_BATCH_CONTIGUOUS; flags += SF_BATCH_CONTIGUOUS) {
+        sf_fs_batch batch = sf_fs_batch_load(paths, PATHS, flags);
+        assert(batch.count == PATHS && !batch.backing == !flags);
+        for (size_t i = 0; i < PATHS; ++i) {
+            const sf_fsb_ex res = batch.results[i];
+            if (i % 3 == 2) {
+                assert(!res.is_ok && res.err == SF_FILE_NOT_FOUND);
+                continue;
+            }
+            const sf_buffer want = i % 3 == 0 ? sf_buffer_own(file, (size_t)size) : expected.ok;
+            assert(res.is_ok && res.ok.size == want.size);
+            assert(memcmp(res.ok.ptr, want.ptr, want.size) == 0);
+        }
+        sf_fs_batch_free(&batch);
+        assert(!batch.results && !batch.count);
+    }
+    sf_buffer_clear(&expected.ok);
+
+    // Writes of every size come out in order, whether buffered, direct or gathered.
+    const sf_str out = sf_lit("fs_test.out");
+    sf_fsw_ex writer = sf_file_writer_open(out, 16, 0);
+    assert(writer.is_ok);
+    assert(sf_file_writer_write(&writer.ok, file, 3).is_ok);
+    assert(sf_file_writer_write(&writer.ok, file + 3, 40).is_ok);
+    assert(sf_file_writer_write(&writer.ok, file + 43, 5).is_ok);
+    const sf_buffer parts[] = { sf_buffer_own(file + 48, 2), sf_buffer_own(file + 50, 30), sf_buffer_own(file + 80, 0) };
+    assert(sf_file_writer_writev(&writer.ok, parts, 3).is_ok);
+    assert(sf_file_writer_writev(&writer.ok, parts, 1).is_ok);
+    assert(sf_file_writer_close(&writer.ok).is_ok);
+    assert(sf_file_size(out) == 82);
+    sf_fsb_ex written = sf_file_buffer(out);
+    assert(written.is_ok && memcmp(written.ok.ptr, file, 80) == 0 && memcmp(written.ok.ptr + 80, file + 48, 2) == 0);
+    sf_buffer_clear(&written.ok);
+
+    // Atomic writers only replace the file once closed successfully.
+    writer = sf_file_writer_open(out, 0, SF_WRITE_ATOMIC | SF_WRITE_SYNC | SF_WRITE_GROUP_COMMIT);
+    assert(writer.is_ok && writer.ok.group_size == SF_WRITER_GROUP_SIZE);
+    writer.ok.group_size = 2;
+    sf_str temp = sf_str_dup(writer.ok.temp_path);
+    assert(sf_file_exists(temp));
+    assert(sf_file_writer_write(&writer.ok, file, 10).is_ok);
+    assert(sf_file_writer_commit(&writer.ok).is_ok && writer.ok.commits == 1);
+    assert(sf_file_writer_commit(&writer.ok).is_ok && writer.ok.commits == 0);
+    assert(sf_file_size(out) == 82);
+    sf_file_writer_abort(&writer.ok);
+    assert(sf_file_size(out) == 82 && !sf_file_exists(temp));
+    sf_str_free(temp);
+
+    // Writers replacing the same path each get their own temporary file, the last to close wins.
+#ifndef _WIN32
+    assert(chmod(sf_cstr(out), 0640) == 0);
+#endif
+    writer = sf_file_writer_open(out, 0, SF_WRITE_ATOMIC);
+    sf_fsw_ex other = sf_file_writer_open(out, 0, SF_WRITE_ATOMIC);
+    assert(writer.is_ok && other.is_ok && !sf_str_eq(writer.ok.temp_path, other.ok.temp_path));
+    temp = sf_str_dup(writer.ok.temp_path);
+    assert(sf_file_writer_write(&other.ok, "other", 5).is_ok);
+    assert(sf_file_writer_write(&writer.ok, file, (size_t)size).is_ok);
+    assert(sf_file_writer_close(&other.ok).is_ok);
+    assert(sf_file_size(out) == 5);
+    assert(sf_file_writer_close(&writer.ok).is_ok);
+    assert(sf_file_size(out) == size && !sf_file_exists(temp));
+    sf_str_free(temp);
+#ifndef _WIN32
+    struct stat s;
+    assert(stat(sf_cstr(out), &s) == 0 && (s.st_mode & 0777) == 0640);
+#endif
+
+    writer = sf_file_writer_open(out, 0, SF_WRITE_APPEND);
+    assert(writer.is_ok);
+    assert(sf_file_writer_write(&writer.ok, "!", 1).is_ok);
+    assert(sf_file_writer_close(&writer.ok).is_ok);
+    assert(sf_file_size(out) == size + 1);
+
+    // Atomic appending writers copy the file through a block smaller than it.
+    writer = sf_file_writer_open(out, 16, SF_WRITE_ATOMIC | SF_WRITE_APPEND);
+    assert(writer.is_ok && sf_file_size(writer.ok.temp_path) == size + 1);
+    assert(sf_file_writer_write(&writer.ok, "?", 1).is_ok);
+    assert(sf_file_size(out) == size + 1);
+    assert(sf_file_writer_close(&writer.ok).is_ok);
+    written = sf_file_buffer(out);
+    assert(written.is_ok && written.ok.size == (size_t)size + 2 && memcmp(written.ok.ptr, file, (size_t)size) == 0);
+    assert(written.ok.ptr[size] == '!' && written.ok.ptr[size + 1] == '?');
+    sf_buffer_clear(&written.ok);
+    remove(sf_cstr(out));
+
+    writer = sf_file_writer_open(out, 0, SF_WRITE_ATOMIC | SF_WRITE_APPEND);
+    assert(writer.is_ok);
+    assert(sf_file_writer_write(&writer.ok, "?", 1).is_ok);
+    assert(sf_file_writer_close(&writer.ok).is_ok);
+    assert(sf_file_size(out) == 1);
+    remove(sf_cstr(out));
+
+#ifndef _WIN32
+    // A failed write keeps the buffered bytes, so they are still written once it can be retried.
+    writer = sf_file_writer_open(out, 16, 0);
+    assert(writer.is_ok && sf_file_writer_write(&writer.ok, file, 5).is_ok);
+    const int fd = writer.ok.fd;
+    writer.ok.fd = -1;
+    assert(!sf_file_writer_writev(&writer.ok, parts, 2).is_ok);
+    assert(!sf_file_writer_flush(&writer.ok).is_ok);
+    writer.ok.fd = fd;
+    assert(sf_file_writer_close(&writer.ok).is_ok);
+    written = sf_file_buffer(out);
+    assert(written.is_ok && written.ok.size == 5 && memcmp(written.ok.ptr, file, 5) == 0);
+    sf_buffer_clear(&written.ok);
+    remove(sf_cstr(out));
+#endif
+
+    assert(sf_file_writer_open(sf_lit("does/not/exist"), 0, 0).err == SF_FILE_NOT_FOUND);
+
+    free(file);
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <assert.h>
+#include <stdio.h>
+#include "sf/intern.h"
+#include "sf/thread.h"
+
+#define MAP_NAME map_si
+#define MAP_K sf_str
+#define MAP_V int
+#define HASH_FN sf_str_hash
+#define EQUAL_FN sf_str_eq
+#include "sf/containers/map.h"
+
+#define THREADS 4
+#define NAMES 2000
+
+static sf_str results[THREADS][NAMES];
+
+/// Intern the same names as every other thread.
+static void intern_names(void *ud) {
+    sf_str *out = ud;
+    char name[32];
+    for (int i = 0; i < NAMES; ++i) {
+        snprintf(name, sizeof(name), "ident_%d", i);
+        out[i] = sf_intern_cstr(name);
+    }
+}
+
+int main(void) {
+    char buffer_a[] = "position", buffer_b[] = "position";
+    const char *a = buffer_a, *b = buffer_b;
+    const sf_str x = sf_intern(sf_ref(a)), y = sf_intern(sf_ref(b));
+    assert(sf_isinterned(x) && x.c_str == y.c_str && x.c_str != a);
+    assert(sf_str_eq(x, y) && sf_str_eq(x, sf_lit("position")));
+    assert(!sf_str_eq(x, sf_intern(sf_lit("velocity"))));
+    assert(sf_str_hash(x) == sf_hash64("position", 8));
+    assert(sf_intern(x).c_str == x.c_str);
+    sf_str_free(x); // No-op, the table owns it.
+
+    assert(sf_intern_find(sf_lit("position")).c_str == x.c_str);
+    assert(sf_isempty(sf_intern_find(sf_lit("rotation"))));
+    assert(sf_intern_count() == 2);
+    assert(sf_intern(sf_lit("")).len == 0);
+
+    // Concurrent interning agrees on one copy per string.
+    sf_thread threads[THREADS];
+    for (size_t i = 0; i < THREADS; ++i)
+        assert(sf_thread_start(&threads[i], intern_names, results[i]));
+    for (size_t i = 0; i < THREADS; ++i)
+        sf_thread_join(threads[i]);
+    for (size_t i = 0; i < NAMES; ++i)
+        for (size_t t = 1; t < THREADS; ++t)
+            assert(results[t][i].c_str == results[0][i].c_str);
+    assert(sf_intern_count() == 3 + NAMES);
+
+    // Interned keys hash and compare without touching their bytes.
+    map_si map = map_si_new();
+    for (int i = 0; i < NAMES; ++i)
+        map_si_set(&map, results[0][i], i);
+    char name[32];
+    for (int i = 0; i < NAMES; ++i) {
+        snprintf(name, sizeof(name), "ident_%d", i);
+        assert(map_si_get(&map, sf_intern_cstr(name)).ok == i);
+    }
+    map_si_free(&map);
+
+    sf_intern_free();
+    assert(sf_intern_count() == 0);
+    assert(sf_intern(sf_lit("position")).len == 8);
+    sf_intern_free();
+}
@@ -1,36 +1,65 @@
-#include <assert.h>
-#include "sf/str.h"
-
-#define MAP_NAME map_ci
-#define MAP_K char
-#define MAP_V int
-#include "sf/containers/map.h"
-
-#define MAP_NAME map_ss
-#define MAP_K sf_str
-#define MAP_V sf_str
-#define HASH_FN sf_str_hash
-#define EQUAL_FN sf_str_eq
-#include "sf/containers/map.h"
-
-int main(void) {
-    map_ci map = map_ci_new();
-
-    int a;
-    map_ci_set(&map, 'a', 4);
-    assert(map_ci_get(&map, 'a', &a) && a == 4);
-    map_ci_set(&map, 'b', 6);
-    assert(map_ci_get(&map, 'b', &a) && a == 6);
-    map_ci_set(&map, 'c', 8);
-    assert(map_ci_get(&map, 'c', &a) && a == 8);
-
-    map_ci_free(&map);
-
-    map_ss map2 = map_ss_new();
-
-    map_ss_set(&map2, sf_lit("test"), sf_lit("80085"));
-    sf_str out = SF_STR_EMPTY;
-    assert(map_ss_get(&map2, sf_lit("test"), &out) && sf_str_eq(sf_lit("80085"), out));
-
-    map_ss_free(&map2);
+#include <assert.h>
+#include "sf/str.h"
+
+#define MAP_NAME map_ci
+#define MAP_K char
+#define MAP_V int
+#include "sf/containers/map.h"
+
+#define MAP_NAME map_ss
+#define MAP_K sf_str
+#define MAP_V sf_str
+#define HASH_FN sf_str_hash
+#define EQUAL_FN sf_str_eq
+#include "sf/containers/map.h"
+
+#define MAP_NAME map_inc
+#define MAP_K int
+#define MAP_V int
+#define MAP_INCREMENTAL
+#define MAP_MIGRATE_STEP 2
+#include "sf/containers/map.h"
+
+int main(void) {
+    map_ci map = map_ci_new();
+
+    map_ci_set(&map, 'a', 4);
+    map_ci_ex a = map_ci_get(&map, 'a');
+    assert(a.is_ok && a.ok == 4);
+    map_ci_set(&map, 'b', 6);
+    a = map_ci_get(&map, 'b');
+    assert(a.is_ok && a.ok == 6);
+    map_ci_set(&map, 'c', 8);
+    a = map_ci_get(&map, 'c');
+    assert(a.is_ok && a.ok == 8);
+
+    map_ci_free(&map);
+
+    map_ss map2 = map_ss_new();
+
+    map_ss_set(&map2, sf_lit("test"), sf_lit("80085"));
+    map_ss_ex out = map_ss_get(&map2, sf_lit("test"));
+    assert(out.is_ok && sf_str_eq(sf_lit("80085"), out.ok));
+
+    map_ss_free(&map2);
+
+    map_inc map3 = map_inc_new();
+
+    // Pairs must stay reachable while they are spread over both tables.
+    bool migrated = false;
+    for (int i = 0; i < 1000; ++i) {
+        map_inc_set(&map3, i, i);
+        migrated |= map_inc_migrating(&map3);
+        map_inc_ex v = map_inc_get(&map3, i / 2);
+        assert(v.is_ok && v.ok == i / 2);
+    }
+    assert(migrated && map3.pair_count == 1000);
+    for (int i = 0; i < 1000; i += 2)
+        map_inc_delete(&map3, i);
+    assert(map3.pair_count == 500);
+    assert(!map_inc_migrate(&map3, SIZE_MAX) && !map_inc_migrating(&map3));
+    for (int i = 0; i < 1000; ++i)
+        assert(map_inc_get(&map3, i).is_ok == (i % 2 == 1));
+
+    map_inc_free(&map3);
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "sf/math.h"
+#include "sf/thread.h"
+#include "sf/containers/buffer.h"
+
+/// Whether two vectors are equal up to float rounding.
+static bool near(const sf_vec3 a, const sf_vec3 b) {
+    return fabsf(a.x - b.x) <= 1e-5f * (1 + fabsf(b.x)) && fabsf(a.y - b.y) <= 1e-5f * (1 + fabsf(b.y)) &&
+        fabsf(a.z - b.z) <= 1e-5f * (1 + fabsf(b.z));
+}
+
+static void draw_in_thread(void *ud) {
+    *(uint64_t *)ud = sf_randu(0, UINT64_MAX);
+}
+
+int main(void) {
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(i * 131 + 7);
+
+    for (size_t size = 0; size <= 200; ++size) {
+        const uint64_t hash = sf_hash64(data, size);
+        assert(hash == sf_hash64_seeded(data, size, SF_HASH_SEED));
+        assert(hash != sf_hash64_seeded(data, size, 1));
+        if (size)
+            assert(hash != sf_hash64(data, size - 1));
+
+        // Flipping any bit changes the hash.
+        for (size_t i = 0; i < size; i += 7) {
+            data[i] ^= 0x10;
+            assert(sf_hash64(data, size) != hash);
+            data[i] ^= 0x10;
+        }
+
+        // Streaming gives the same hash however the input is split.
+        for (size_t split = 0; split <= size; ++split) {
+            sf_hash_state state;
+            sf_hash_init(&state, SF_HASH_SEED);
+            sf_hash_update(&state, data, split);
+            sf_hash_update(&state, data + split, size - split);
+            assert(sf_hash_final(&state) == hash);
+        }
+        sf_hash_state state;
+        sf_hash_init(&state, SF_HASH_SEED);
+        for (size_t i = 0; i < size; ++i)
+            sf_hash_update(&state, data + i, 1);
+        assert(sf_hash_final(&state) == hash);
+    }
+
+    sf_buffer buffer = sf_buffer_grow();
+    assert(sf_buffer_insert(&buffer, data, 100).is_ok);
+    assert(sf_buffer_hash(&buffer) == sf_hash64(data, 100));
+    sf_buffer_clear(&buffer);
+
+    // Nearby integers land in different buckets of a small power of two table.
+    size_t used[64] = { 0 };
+    for (uint64_t i = 0; i < 64; ++i)
+        ++used[sf_hash_u64(i) & 63];
+    size_t empty = 0;
+    for (size_t i = 0; i < 64; ++i)
+        empty += used[i] == 0;
+    assert(empty < 40 && sf_hash_u64(1) != sf_hash_u64(2));
+
+    // Batch kernels match the scalar functions, for lengths that leave a tail after every vector width.
+    for (size_t len = 0; len <= 19; ++len) {
+        sf_vec3 aos[19], back[19];
+        for (size_t i = 0; i < len; ++i)
+            aos[i] = (sf_vec3){(float)i - 5, (float)(i * i) / 7, i % 3 ? 0.5f : -2};
+        aos[len ? len - 1 : 0] = (sf_vec3){0, 0, 0};
+        sf_vec3_soa a = sf_vec3_soa_new(len), b = sf_vec3_soa_new(len), out = sf_vec3_soa_new(len);
+        assert(a.block && a.len == len && (uintptr_t)a.y % 32 == 0 && (uintptr_t)a.z % 32 == 0);
+        sf_vec3_soa_from_aos(&a, aos);
+        for (size_t i = 0; i < len; ++i)
+            sf_vec3_soa_set(&b, i, (sf_vec3){1, 2, 3});
+        sf_vec3_soa_to_aos(&a, back);
+        assert(len == 0 || memcmp(back, aos, len * sizeof(sf_vec3)) == 0);
+
+        sf_vec3_soa_fma(&out, &a, &b, 0.25f);
+        for (size_t i = 0; i < len; ++i) {
+            const sf_vec3 expected = sf_vec3_add(aos[i], sf_vec3_multf((sf_vec3){1, 2, 3}, 0.25f));
+            const sf_vec3 got = sf_vec3_soa_get(&out, i);
+            assert(got.x == expected.x && got.y == expected.y && got.z == expected.z);
+        }
+        sf_vec3_soa_sub(&out, &a, &b);
+        sf_vec3_soa_multv(&out, &out, &b);
+        sf_vec3_soa_add(&out, &out, &b);
+        sf_vec3_soa_multf(&out, &out, 2);
+        for (size_t i = 0; i < len; ++i) {
+            const sf_vec3 step = sf_vec3_multv(sf_vec3_sub(aos[i], (sf_vec3){1, 2, 3}), (sf_vec3){1, 2, 3});
+            const sf_vec3 expected = sf_vec3_multf(sf_vec3_add(step, (sf_vec3){1, 2, 3}), 2);
+            const sf_vec3 got = sf_vec3_soa_get(&out, i);
+            assert(got.x == expected.x && got.y == expected.y && got.z == expected.z);
+        }
+
+        float dots[19], lengths[19];
+        sf_vec3_soa_dot(dots, &a, &b);
+        sf_vec3_soa_length(lengths, &a);
+        sf_vec3_soa_normalize(&out, &a);
+        for (size_t i = 0; i < len; ++i) {
+            const sf_vec3 v = aos[i];
+            assert(dots[i] == v.x * 1 + v.y * 2 + v.z * 3);
+            assert(fabsf(lengths[i] - sqrtf(v.x * v.x + v.y * v.y + v.z * v.z)) <= 1e-6f * lengths[i]);
+            const sf_vec3 n = sf_vec3_soa_get(&out, i);
+            const float norm = n.x * n.x + n.y * n.y + n.z * n.z;
+            assert(lengths[i] == 0 ? norm == 0 : fabsf(norm - 1) < 1e-5f);
+        }
+        sf_vec3_soa_free(&a);
+        sf_vec3_soa_free(&b);
+        sf_vec3_soa_free(&out);
+        assert(a.block == NULL && a.len == 0);
+    }
+
+    sf_vec2 flat[5] = { {3, 4}, {0, 0}, {-1, 0}, {6, 8}, {0, 2} };
+    sf_vec2_soa points = sf_vec2_soa_new(5);
+    sf_vec2_soa_from_aos(&points, flat);
+    float lengths[5];
+    sf_vec2_soa_length(lengths, &points);
+    assert(lengths[0] == 5 && lengths[1] == 0 && lengths[3] == 10 && lengths[4] == 2);
+    sf_vec2_soa_normalize(&points, &points);
+    sf_vec2_soa_to_aos(&points, flat);
+    assert(flat[0].x == 0.6f && flat[0].y == 0.8f && flat[1].x == 0 && flat[2].x == -1 && flat[4].y == 1);
+    sf_vec2_soa_free(&points);
+
+    // A quarter turn around z takes x to y, and matrices apply scale, then rotation, then translation.
+    const float quarter = 1.57079632679f;
+    const sf_vec3 turned = sf_quat_rotate(sf_quat_from_euler((sf_vec3){0, 0, quarter}), (sf_vec3){1, 0, 0});
+    assert(near(turned, (sf_vec3){0, 1, 0}));
+    const sf_quat xy = sf_quat_from_euler((sf_vec3){quarter, quarter, 0});
+    assert(near(sf_quat_rotate(xy, (sf_vec3){0, 1, 0}), sf_quat_rotate(sf_quat_from_axis((sf_vec3){0, 1, 0}, quarter), (sf_vec3){0, 0, 1})));
+    const sf_mat4 trs = sf_mat4_from_trs((sf_vec3){10, 0, 0}, sf_quat_from_axis((sf_vec3){0, 0, 1}, quarter), (sf_vec3){2, 2, 2});
+    assert(near(sf_mat4_transform_point(&trs, (sf_vec3){1, 0, 0}), (sf_vec3){10, 2, 0}));
+    const sf_mat4 twice = sf_mat4_mul(trs, trs), identity = sf_mat4_mul(SF_MAT4_IDENTITY, trs);
+    assert(near(sf_mat4_transform_point(&twice, (sf_vec3){1, 0, 0}), (sf_vec3){6, 20, 0}));
+    assert(memcmp(&identity, &trs, sizeof(trs)) == 0);
+
+    // Parent pointers and graphs give the same world matrices.
+    sf_transform root = SF_TRANSFORM_IDENTITY, arm = SF_TRANSFORM_IDENTITY, hand = SF_TRANSFORM_IDENTITY;
+    root.position = (sf_vec3){0, 0, 5};
+    arm.position = (sf_vec3){1, 0, 0};
+    arm.rotation = (sf_vec3){0, 0, quarter};
+    hand.position = (sf_vec3){2, 0, 0};
+    arm.parent = &root;
+    hand.parent = &arm;
+    const sf_mat4 hand_world = sf_transform_world(&hand);
+    assert(near(sf_mat4_transform_point(&hand_world, (sf_vec3){0, 0, 0}), (sf_vec3){1, 2, 5}));
+
+    sf_transform_graph graph = sf_transform_graph_new();
+    const sf_transform_id hand_id = sf_transform_graph_add(&graph, SF_TRANSFORM_NONE, hand);
+    const sf_transform_id root_id = sf_transform_graph_add(&graph, SF_TRANSFORM_NONE, root);
+    const sf_transform_id arm_id = sf_transform_graph_add(&graph, root_id, arm);
+    const sf_transform_id other_id = sf_transform_graph_add(&graph, SF_TRANSFORM_NONE, SF_TRANSFORM_IDENTITY);
+    // The hand was added first, so parenting it to the arm moves it behind the arm.
+    assert(sf_transform_graph_set_parent(&graph, hand_id, arm_id));
+    assert(!sf_transform_graph_set_parent(&graph, root_id, hand_id) && !sf_transform_graph_set_parent(&graph, arm_id, arm_id));
+    for (size_t i = 0; i < graph.count; ++i)
+        assert(graph.parents[i] == SF_TRANSFORM_NONE || graph.parents[i] < i);
+    sf_transform_graph_update(&graph);
+    assert(memcmp(sf_transform_graph_world(&graph, hand_id), &hand_world, sizeof(sf_mat4)) == 0);
+    assert(graph.first_dirty == graph.count);
+
+    // Moving the root moves everything below it, and only that.
+    root.position = (sf_vec3){0, 0, -5};
+    sf_transform_graph_set_local(&graph, root_id, root);
+    const sf_mat4 other_before = *sf_transform_graph_world(&graph, other_id);
+    graph.worlds[graph.slots[other_id]].m[0] = 42;
+    sf_transform_graph_update(&graph);
+    assert(near(sf_mat4_transform_point(sf_transform_graph_world(&graph, hand_id), (sf_vec3){0, 0, 0}), (sf_vec3){1, 2, -5}));
+    assert(sf_transform_graph_world(&graph, other_id)->m[0] == 42 && other_before.m[0] == 1);
+
+    // Removing a node removes its subtree and its handles are reused.
+    sf_transform_graph_remove(&graph, arm_id);
+    assert(graph.count == 2 && sf_transform_graph_local(&graph, root_id)->position.z == -5);
+    const sf_transform_id reused = sf_transform_graph_add(&graph, root_id, arm);
+    assert((reused == arm_id || reused == hand_id) && graph.count == 3);
+    sf_transform_graph_update(&graph);
+    assert(near(sf_mat4_transform_point(sf_transform_graph_world(&graph, reused), (sf_vec3){0, 0, 0}), (sf_vec3){1, 0, -5}));
+    for (int i = 0; i < 100; ++i)
+        assert(sf_transform_graph_add(&graph, reused, SF_TRANSFORM_IDENTITY) != SF_TRANSFORM_NONE);
+    sf_transform_graph_update(&graph);
+    assert(near(sf_mat4_transform_point(&graph.worlds[graph.count - 1], (sf_vec3){0, 0, 0}), (sf_vec3){1, 0, -5}));
+    sf_transform_graph_free(&graph);
+
+    // Random reparenting keeps every parent before its children and matches walking parent pointers.
+    enum { NODES = 40 };
+    sf_transform nodes[NODES];
+    sf_transform_id handles[NODES];
+    graph = sf_transform_graph_new();
+    for (size_t i = 0; i < NODES; ++i) {
+        nodes[i] = SF_TRANSFORM_IDENTITY;
+        nodes[i].position = (sf_vec3){(float)(i % 3), (float)(i % 5) / 4, 1};
+        nodes[i].rotation = (sf_vec3){0, (float)i / 10, 0};
+        handles[i] = sf_transform_graph_add(&graph, SF_TRANSFORM_NONE, nodes[i]);
+    }
+    uint64_t random = 1;
+    for (int round = 0; round < 200; ++round) {
+        random = random * 6364136223846793005u + 1442695040888963407u;
+        const size_t child = (random >> 33) % NODES, parent = (random >> 45) % (NODES + 1);
+        bool cycle = parent == child;
+        for (const sf_transform *p = parent < NODES ? nodes[parent].parent : NULL; p && !cycle; p = p->parent)
+            cycle = p == &nodes[child];
+        assert(sf_transform_graph_set_parent(&graph, handles[child], parent < NODES ? handles[parent] : SF_TRANSFORM_NONE) == !cycle);
+        if (!cycle)
+            nodes[child].parent = parent < NODES ? &nodes[parent] : NULL;
+        if (round % 20)
+            continue;
+        sf_transform_graph_update(&graph);
+        for (size_t i = 0; i < NODES; ++i) {
+            const sf_mat4 expected = sf_transform_world(&nodes[i]);
+            const sf_mat4 *world = sf_transform_graph_world(&graph, handles[i]);
+            assert(near(sf_mat4_transform_point(world, (sf_vec3){1, 1, 1}), sf_mat4_transform_point(&expected, (sf_vec3){1, 1, 1})));
+            assert(graph.parents[graph.slots[handles[i]]] == (nodes[i].parent ? graph.slots[handles[nodes[i].parent - nodes]] : SF_TRANSFORM_NONE));
+        }
+        for (size_t i = 0; i < graph.count; ++i)
+            assert(graph.parents[i] == SF_TRANSFORM_NONE || graph.parents[i] < i);
+    }
+    sf_transform_graph_free(&graph);
+
+    // The generator matches the published xoshiro256** sequence.
+    sf_rng rng = { { 1, 2, 3, 4 } };
+    assert(sf_rng_next(&rng) == 0x2D00 && sf_rng_next(&rng) == 0 && sf_rng_next(&rng) == 0x5A007080);
+    sf_rng a = sf_rng_new(42), b = sf_rng_new(42), jumped = sf_rng_new(42);
+    sf_rng_jump(&jumped);
+    for (int i = 0; i < 100; ++i) {
+        const uint64_t value = sf_rng_next(&a);
+        assert(value == sf_rng_next(&b) && value != sf_rng_next(&jumped));
+    }
+
+    // Bulk fills are RNG_LANES streams seeded from the generator, interleaved, then the generator for the tail.
+    uint64_t bulk[130], streams[4][4];
+    sf_rng_bytes(&a, bulk, 1037);
+    for (size_t l = 0; l < 4; ++l) {
+        const sf_rng lane = sf_rng_new(sf_rng_next(&b));
+        memcpy(streams[l], lane.s, sizeof(lane.s));
+    }
+    for (size_t i = 0; i < 1024 / 8; ++i) {
+        sf_rng lane;
+        memcpy(lane.s, streams[i % 4], sizeof(lane.s));
+        assert(bulk[i] == sf_rng_next(&lane));
+        memcpy(streams[i % 4], lane.s, sizeof(lane.s));
+    }
+    const uint64_t tail = sf_rng_next(&b), last = sf_rng_next(&b);
+    assert(bulk[128] == tail && memcmp(&bulk[129], &last, 5) == 0);
+    assert(sf_rng_next(&a) == sf_rng_next(&b));
+
+    // Bounded draws hit every value of small ranges about equally often, and handle the full range.
+    size_t seen[7] = { 0 };
+    for (int i = 0; i < 70000; ++i) {
+        const int64_t value = sf_rng_int(&a, -3, 3);
+        assert(value >= -3 && value <= 3);
+        ++seen[value + 3];
+    }
+    for (size_t i = 0; i < 7; ++i)
+        assert(seen[i] > 9000 && seen[i] < 11000);
+    for (int i = 0; i < 1000; ++i) {
+        const uint64_t value = sf_rng_uint(&a, 5, 7);
+        const float f = sf_rng_float(&a, -1, 2);
+        assert(value >= 5 && value <= 7 && f >= -1 && f <= 2);
+        assert(sf_rng_below(&a, 1) == 0 && sf_rng_below(&a, 1ull << 63) < 1ull << 63);
+    }
+    assert(sf_rng_uint(&a, 9, 9) == 9 && sf_rng_int(&a, INT64_MIN, INT64_MAX) != sf_rng_int(&a, INT64_MIN, INT64_MAX));
+    assert(sf_rng_float(&a, 0.5f, 0.5f) == 0.5f);
+
+    // The default generator is per thread, and reproducible once seeded.
+    sf_rand_seed(7);
+    sf_rng seven = sf_rng_new(7);
+    assert(sf_randu(0, 100) == sf_rng_uint(&seven, 0, 100) && sf_randi(-5, 5) == sf_rng_int(&seven, -5, 5));
+    assert(sf_randf(0, 1) == sf_rng_float(&seven, 0, 1));
+    uint8_t noise[300];
+    sf_rand(noise, sizeof(noise));
+    uint64_t drawn[2];
+    sf_thread threads[2];
+    for (size_t i = 0; i < 2; ++i)
+        assert(sf_thread_start(&threads[i], draw_in_thread, &drawn[i]));
+    for (size_t i = 0; i < 2; ++i)
+        sf_thread_join(threads[i]);
+    assert(drawn[0] != drawn[1]);
+}
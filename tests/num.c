@@ -0,0 +1,81 @@
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "sf/num.h"
+#include "sf/strbuf.h"
+
+/// Formats `value` and compares against `expected`.
+static bool formats_to(const double value, const char *expected) {
+    char buffer[SF_NUM_BUFFER_SIZE];
+    const sf_str s = sf_f64_to_str(value, buffer);
+    return s.len == strlen(expected) && strcmp(buffer, expected) == 0;
+}
+
+int main(void) {
+    char buffer[SF_NUM_BUFFER_SIZE];
+    assert(sf_str_eq(sf_u64_to_str(0, buffer), sf_lit("0")) && buffer[1] == '\0');
+    assert(sf_str_eq(sf_u64_to_str(UINT64_MAX, buffer), sf_lit("18446744073709551615")));
+    assert(sf_str_eq(sf_u64_to_str(1000000, buffer), sf_lit("1000000")));
+    assert(sf_str_eq(sf_i64_to_str(INT64_MIN, buffer), sf_lit("-9223372036854775808")));
+    assert(sf_str_eq(sf_i64_to_str(-7, buffer), sf_lit("-7")));
+
+    // Shortest round trip, written out in full between 1e-7 and 1e21.
+    assert(formats_to(0.1, "0.1") && formats_to(0.1 + 0.2, "0.30000000000000004"));
+    assert(formats_to(100, "100") && formats_to(-1.5, "-1.5") && formats_to(123456.789, "123456.789"));
+    assert(formats_to(1e20, "100000000000000000000") && formats_to(1e21, "1e+21"));
+    assert(formats_to(0.000001, "0.000001") && formats_to(1e-7, "1e-7") && formats_to(2.5e-8, "2.5e-8"));
+    assert(formats_to(5e-324, "5e-324") && formats_to(1.7976931348623157e308, "1.7976931348623157e+308"));
+    assert(formats_to(9007199254740993.0, "9007199254740992") && formats_to(1.0 / 3, "0.3333333333333333"));
+    assert(formats_to(0.0, "0") && formats_to(-0.0, "-0") && formats_to(NAN, "nan"));
+    assert(formats_to(HUGE_VAL, "inf") && formats_to(-HUGE_VAL, "-inf"));
+
+    assert(sf_str_to_u64(sf_lit("18446744073709551615")).ok == UINT64_MAX);
+    assert(sf_str_to_u64(sf_lit("+0000000000000000000000042")).ok == 42);
+    assert(sf_str_to_u64(sf_lit("18446744073709551616")).err == SF_NUM_OVERFLOW);
+    assert(sf_str_to_u64(sf_lit("123456789012345678901")).err == SF_NUM_OVERFLOW);
+    assert(sf_str_to_u64(sf_lit("-1")).err == SF_NUM_INVALID && sf_str_to_u64(sf_lit("12a")).err == SF_NUM_INVALID);
+    assert(sf_str_to_u64(sf_lit("")).err == SF_NUM_EMPTY && sf_str_to_u64(sf_lit("+")).err == SF_NUM_INVALID);
+    assert(sf_str_to_i64(sf_lit("-9223372036854775808")).ok == INT64_MIN);
+    assert(sf_str_to_i64(sf_lit("9223372036854775807")).ok == INT64_MAX);
+    assert(sf_str_to_i64(sf_lit("9223372036854775808")).err == SF_NUM_OVERFLOW);
+    assert(sf_str_to_i64(sf_lit("-42")).ok == -42 && sf_str_to_i64(sf_lit("- 1")).err == SF_NUM_INVALID);
+
+    assert(sf_str_to_f64(sf_lit("1.5")).ok == 1.5 && sf_str_to_f64(sf_lit("-.25")).ok == -0.25);
+    assert(sf_str_to_f64(sf_lit("2e10")).ok == 2e10 && sf_str_to_f64(sf_lit("1E-5")).ok == 1e-5);
+    assert(sf_str_to_f64(sf_lit("5.")).ok == 5 && sf_str_to_f64(sf_lit("1e30")).ok == 1e30);
+    assert(sf_str_to_f64(sf_lit("0.30000000000000004")).ok == 0.1 + 0.2);
+    assert(sf_str_to_f64(sf_lit("123456789012345678901234567890")).ok == 123456789012345678901234567890.0);
+    assert(sf_str_to_f64(sf_lit("-Infinity")).ok == -HUGE_VAL && isnan(sf_str_to_f64(sf_lit("NaN")).ok));
+    assert(signbit(sf_str_to_f64(sf_lit("-0.0")).ok) && sf_str_to_f64(sf_lit("1e-400")).ok == 0);
+    assert(sf_str_to_f64(sf_lit("1e400")).err == SF_NUM_OVERFLOW && sf_str_to_f64(sf_lit("")).err == SF_NUM_EMPTY);
+    const char *invalid[] = { ".", "-", "e5", "1e", "1e+", "1.2.3", "0x10", " 1", "1 ", "infinit" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+        assert(sf_str_to_f64(sf_ref(invalid[i])).err == SF_NUM_INVALID);
+
+    // Every double survives a round trip through text, including subnormals.
+    uint64_t bits = 0x9E3779B97F4A7C15u;
+    for (int i = 0; i < 100000; ++i) {
+        bits = bits * 6364136223846793005u + 1442695040888963407u;
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        if (isnan(value))
+            continue;
+        const sf_f64_ex parsed = sf_str_to_f64(sf_f64_to_str(value, buffer));
+        assert(parsed.is_ok && memcmp(&parsed.ok, &value, sizeof(value)) == 0);
+    }
+
+    sf_buffer out = sf_buffer_grow();
+    assert(sf_buffer_insert_u64(&out, 42).is_ok && sf_buffer_insert_i64(&out, -1).is_ok);
+    assert(sf_buffer_insert_f64(&out, 0.5).is_ok);
+    assert(out.size == 7 && memcmp(out.ptr, "42-10.5", 7) == 0);
+    sf_buffer_clear(&out);
+    uint8_t small[4];
+    sf_buffer fixed = sf_buffer_own(small, sizeof(small));
+    assert(sf_buffer_insert_u64(&fixed, 123).is_ok && !sf_buffer_insert_u64(&fixed, 45).is_ok);
+
+    sf_strbuf sb = sf_strbuf_new();
+    assert(sf_strbuf_append_double(&sb, 0.1) && sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_double(&sb, -2.5e-10));
+    assert(sf_str_eq(sf_strbuf_view(&sb), sf_lit("0.1 -2.5e-10")));
+    sf_strbuf_free(&sb);
+}
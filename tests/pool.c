@@ -0,0 +1,81 @@
+#include <assert.h>
+#include "sf/pool.h"
+
+#define MAP_NAME map_pooled
+#define MAP_K int
+#define MAP_V int
+#define MAP_POOL
+#include "sf/containers/map.h"
+
+#define OBJECTS 10000
+
+/// Releases every object a different thread allocated.
+static void release_all(void *ud) {
+    void **objects = ud;
+    sf_pool *pool = objects[0];
+    for (size_t i = 1; i <= OBJECTS; ++i)
+        sf_pool_release(pool, objects[i]);
+}
+
+int main(void) {
+    sf_pool *pool = sf_pool_new(24);
+    assert(pool && pool->object_size >= 24);
+
+    uint64_t *a = sf_pool_alloc(pool);
+    uint64_t *b = sf_pool_alloc(pool);
+    assert(a && b && a != b);
+    *a = 1, *b = 2;
+    sf_pool_release(pool, a);
+    assert(sf_pool_alloc(pool) == a);
+    assert(*b == 2);
+
+    // Objects freed on another thread flow back through the shared free list.
+    static void *objects[OBJECTS + 1];
+    objects[0] = pool;
+    for (size_t i = 1; i <= OBJECTS; ++i) {
+        objects[i] = sf_pool_alloc(pool);
+        assert(objects[i]);
+    }
+    sf_thread thread;
+    assert(sf_thread_start(&thread, release_all, objects));
+    sf_thread_join(thread);
+    for (size_t i = 1; i <= OBJECTS; ++i)
+        assert(sf_pool_alloc(pool));
+
+    sf_pool_reset(pool);
+    assert(!pool->slabs && sf_pool_alloc(pool));
+    sf_pool_free(pool);
+
+    // More pools than a thread has caches, some freed and replaced while others hold cached objects.
+    sf_pool *pools[24];
+    for (size_t i = 0; i < 24; ++i)
+        pools[i] = sf_pool_new(sizeof(size_t));
+    for (size_t round = 0; round < 50; ++round) {
+        for (size_t i = 0; i < 24; ++i) {
+            size_t *object = sf_pool_alloc(pools[i]);
+            assert(object);
+            *object = i;
+            sf_pool_release(pools[i], object);
+        }
+        if (round % 10 == 0) {
+            sf_pool_free(pools[round % 24]);
+            pools[round % 24] = sf_pool_new(sizeof(size_t));
+            sf_pool_reset(pools[(round + 1) % 24]);
+        }
+    }
+    for (size_t i = 0; i < 24; ++i)
+        sf_pool_free(pools[i]);
+
+    map_pooled map = map_pooled_new();
+    for (int i = 0; i < 1000; ++i)
+        map_pooled_set(&map, i, i);
+    for (int i = 0; i < 1000; i += 2)
+        map_pooled_delete(&map, i);
+    for (int i = 0; i < 1000; ++i)
+        assert(map_pooled_get(&map, i).is_ok == (i % 2 == 1));
+    map_pooled_clear(&map);
+    assert(map.pair_count == 0 && !map_pooled_get(&map, 1).is_ok);
+    map_pooled_set(&map, 1, 2);
+    assert(map_pooled_get(&map, 1).ok == 2);
+    map_pooled_free(&map);
+}
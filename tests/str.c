@@ -1,8 +1,90 @@
-#include <assert.h>
-#include "sf/str.h"
-
-int main(void) {
-    sf_str twelve = sf_str_fmt("twelve{%d}", 12);
-    assert(sf_str_eq(twelve, sf_lit("twelve{12}")));
-    sf_str_free(twelve);
-}
\ No newline at end of file
+#include <assert.h>
+#include <string.h>
+#include "sf/str.h"
+
+int main(void) {
+    sf_str twelve = sf_str_fmt("twelve{%d}", 12);
+    assert(sf_str_eq(twelve, sf_lit("twelve{12}")));
+    sf_str_free(twelve);
+
+    // Short and long strings behave the same, wherever they're stored.
+    sf_str key = sf_str_dup(sf_lit("id"));
+    assert(key.len == 2 && strcmp(sf_cstr(key), "id") == 0);
+    sf_str_append(&key, sf_lit("_short"));
+    assert(sf_str_eq(key, sf_lit("id_short")));
+    sf_str_append(&key, sf_lit("_and_now_much_longer"));
+    assert(sf_str_eq(key, sf_lit("id_short_and_now_much_longer")) && !sf_isinline(key));
+    sf_str joined = sf_str_join(sf_lit("a"), sf_lit("b"));
+    assert(sf_str_eq(joined, sf_lit("ab")) && sf_cstr(joined)[2] == '\0');
+    sf_str copy = joined;
+    assert(sf_str_eq(copy, joined));
+#ifdef SF_STR_SSO
+    assert(sf_isinline(joined) && sf_isinline(sf_str_fmt("%d", 123456789)));
+    sf_str longest = sf_str_fmt("%s", "fifteen chars!!"), heap = sf_str_fmt("%s", "sixteen chars!!!");
+    assert(sf_isinline(longest) && !sf_isinline(heap) && sf_str_eq(heap, sf_lit("sixteen chars!!!")));
+    sf_str_free(heap);
+#endif
+    sf_str_free(key);
+    sf_str_free(joined);
+
+    assert(sf_str_cmp(sf_lit("abc"), sf_lit("abd")) < 0 && sf_str_cmp(sf_lit("ab"), sf_lit("abc")) < 0);
+    assert(sf_str_cmp(sf_lit("b"), sf_lit("abc")) > 0 && sf_str_cmp(sf_lit("abc"), sf_lit("abc")) == 0);
+
+    // Searches cover matches in the vectorized body and in the tail, at every length.
+    char text[200];
+    for (size_t len = 0; len < sizeof(text); ++len) {
+        memset(text, 'a', len);
+        const sf_str s = { .c_str = text, .len = len, .flags = SF_STR_CONST };
+        assert(sf_str_find_char(s, 'x') == SF_STR_NPOS && sf_str_find(s, sf_lit("ab")) == SF_STR_NPOS);
+        assert(sf_str_count_char(s, 'a') == len && sf_str_find_any(s, sf_lit("xyz")) == SF_STR_NPOS);
+        if (len < 3)
+            continue;
+        text[len - 1] = 'x', text[len - 3] = 'b';
+        assert(sf_str_find_char(s, 'x') == len - 1 && sf_str_count_char(s, 'a') == len - 2);
+        assert(sf_str_find(s, sf_lit("bax")) == len - 3 && sf_str_find(s, sf_lit("bx")) == SF_STR_NPOS);
+        assert(sf_str_find_any(s, sf_lit("zyx")) == len - 1 && sf_str_find_any(s, sf_lit("!\"#$%&'()*+,-./x")) == len - 1);
+    }
+    const sf_str text_str = sf_lit("the cat sat on the mat with the other cat");
+    assert(sf_str_find(text_str, sf_lit("cat")) == 4 && sf_str_find(text_str, sf_lit("")) == 0);
+    assert(sf_str_count(text_str, sf_lit("the")) == 4 && sf_str_count(sf_lit("aaaa"), sf_lit("aa")) == 2);
+    assert(sf_str_count(text_str, sf_lit("at")) == 4 && sf_str_find(sf_lit("ab"), sf_lit("abc")) == SF_STR_NPOS);
+
+    // Splitting keeps empty pieces, tokenizing drops them.
+    sf_str pieces[8];
+    assert(sf_str_split(sf_lit("a,,bc,"), sf_lit(","), pieces, 8) == 4);
+    assert(sf_str_eq(pieces[0], sf_lit("a")) && pieces[1].len == 0 && sf_str_eq(pieces[2], sf_lit("bc")) && pieces[3].len == 0);
+    assert(sf_str_split(sf_lit("key => value"), sf_lit(" => "), pieces, 8) == 2 && sf_str_eq(pieces[1], sf_lit("value")));
+    assert(sf_str_split(sf_lit("a,b,c"), sf_lit(","), pieces, 2) == 2);
+    sf_str rest = sf_lit("  one\ttwo  three\n"), token;
+    const char *tokens[] = { "one", "two", "three" };
+    size_t count = 0;
+    while (sf_str_tokenize_next(&rest, sf_lit(" \t\n"), &token)) {
+        assert(count < 3 && sf_str_eq(token, sf_ref(tokens[count])));
+        ++count;
+    }
+    assert(count == 3);
+
+    assert(sf_str_eq(sf_str_trim(sf_lit(" \t padded \r\n")), sf_lit("padded")));
+    assert(sf_str_eq(sf_str_trim_left(sf_lit("  x ")), sf_lit("x ")) && sf_str_eq(sf_str_trim_right(sf_lit("  x ")), sf_lit("  x")));
+    assert(sf_str_trim(sf_lit("   ")).len == 0 && sf_str_eq(sf_str_sub(sf_lit("abc"), 1, 99), sf_lit("bc")));
+    sf_str owned = sf_str_dup(sf_lit("k=v"));
+    assert(sf_str_split(owned, sf_lit("="), pieces, 8) == 2 && sf_str_eq(pieces[1], sf_lit("v")));
+    sf_str_free(owned);
+
+    // A cached hash matches the computed one, rejects unequal strings and goes stale on mutation.
+    sf_str route = sf_str_dup(sf_lit("/api/v1/users"));
+    const uint64_t route_hash = sf_str_hash_cached(&route);
+    assert(route.flags & SF_STR_HASHED && route_hash == sf_str_hash(sf_lit("/api/v1/users")));
+    assert(sf_str_hash(route) == route_hash && sf_str_eq(route, sf_lit("/api/v1/users")));
+    sf_str other = sf_str_dup(sf_lit("/api/v1/posts"));
+    sf_str_hash_cached(&other);
+    assert(!sf_str_eq(route, other));
+    sf_str route_copy = sf_str_dup(route);
+    assert(route_copy.flags & SF_STR_HASHED && sf_str_eq(route_copy, route));
+    sf_str_append(&route, sf_lit("/42"));
+    assert(!(route.flags & SF_STR_HASHED) && sf_str_hash(route) == sf_str_hash(sf_lit("/api/v1/users/42")));
+    assert(sf_str_hash_cached(&route) != route_hash && !sf_str_eq(route, route_copy));
+    sf_str_free(route);
+    sf_str_free(other);
+    sf_str_free(route_copy);
+}
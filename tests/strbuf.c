@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sf/strbuf.h"
+
+/// Grows but refuses to shrink, tracking the bytes live so frees with the wrong size show up.
+typedef struct {
+    size_t live;
+    bool fail;
+} strict_state;
+static void *strict_alloc(void *ud, const size_t size) {
+    strict_state *state = ud;
+    if (state->fail)
+        return NULL;
+    state->live += size;
+    return malloc(size);
+}
+static void *strict_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    strict_state *state = ud;
+    if (size < old_size)
+        return NULL;
+    void *p = realloc(ptr, size);
+    if (p)
+        state->live += size - old_size;
+    return p;
+}
+static void strict_free(void *ud, void *ptr, const size_t size) {
+    strict_state *state = ud;
+    state->live -= size;
+    free(ptr);
+}
+
+int main(void) {
+    sf_strbuf sb = sf_strbuf_new();
+    assert(sf_strbuf_view(&sb).len == 0 && !sb.ptr);
+
+    assert(sf_strbuf_append(&sb, sf_lit("x=")));
+    assert(sf_strbuf_append_int(&sb, -42));
+    assert(sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_uint(&sb, UINT64_MAX));
+    assert(sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_int(&sb, INT64_MIN));
+    assert(sf_strbuf_appendf(&sb, " %s|", "fmt"));
+    assert(sf_str_eq(sf_strbuf_view(&sb), sf_lit("x=-42 18446744073709551615 -9223372036854775808 fmt|")));
+
+    sf_strbuf_clear(&sb);
+    assert(sf_strbuf_append_float(&sb, 3.14159, 2) && sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_float(&sb, -0.5, 3) && sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_float(&sb, 2.0, 0) && sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_float(&sb, 0.0625, 9) && sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_float(&sb, 1e300, 1) && sf_strbuf_append_char(&sb, ' '));
+    assert(sf_strbuf_append_float(&sb, -HUGE_VAL, 1));
+    assert(sf_str_eq(sf_strbuf_view(&sb), sf_lit("3.14 -0.500 2 0.062500000 1e+300 -inf")));
+
+    // Growth is geometric, and long formatted appends land in one piece.
+    sf_strbuf_clear(&sb);
+    for (int i = 0; i < 300; ++i)
+        assert(sf_strbuf_append(&sb, sf_lit("fragment ")));
+    assert(sb.len == 300 * 9 && sb.capacity >= sb.len + 1 && sb.ptr[sb.len] == '\0');
+    char long_arg[200];
+    memset(long_arg, 'a', sizeof(long_arg) - 1);
+    long_arg[sizeof(long_arg) - 1] = '\0';
+    assert(sf_strbuf_appendf(&sb, "<%s>", long_arg));
+    assert(sb.len == 300 * 9 + 201 && sb.ptr[sb.len - 1] == '>');
+
+    sf_str done = sf_strbuf_finish(&sb);
+    assert(done.len == 300 * 9 + 201 && sf_cstr(done)[done.len] == '\0');
+    assert(!sb.ptr && sb.len == 0);
+    sf_str_free(done);
+
+    // sf_str_fmt is built on the builder.
+    sf_str fmt = sf_str_fmt("%s-%d-%s", long_arg, 7, "end");
+    assert(fmt.len == 199 + 6 && memcmp(sf_cstr(fmt) + 199, "-7-end", 7) == 0);
+    sf_str_free(fmt);
+    sf_str empty = sf_strbuf_finish(&sb);
+    assert(empty.len == 0 && sf_cstr(empty)[0] == '\0');
+    sf_str_free(empty);
+    sf_strbuf_free(&sb);
+
+    // An allocator that can't shrink in place gets an exact copy, freed by its length like any string.
+    strict_state state = { 0, false };
+    const sf_allocator strict = { strict_alloc, strict_realloc, strict_free, &state };
+    sb = sf_strbuf_new_in(&strict);
+    assert(sf_strbuf_append(&sb, sf_lit("longer than any inline string")));
+    done = sf_strbuf_finish(&sb);
+    assert(sf_str_eq(done, sf_lit("longer than any inline string")) && state.live == done.len + 1);
+    sf_str_free_in(&strict, done);
+    assert(state.live == 0);
+
+    // Without memory for the copy, finishing fails and the builder keeps its contents.
+    assert(sf_strbuf_append(&sb, sf_lit("longer than any inline string")));
+    state.fail = true;
+    assert(sf_isnull(sf_strbuf_finish(&sb)) && sb.len == 29);
+    sf_strbuf_free(&sb);
+    assert(state.live == 0);
+}
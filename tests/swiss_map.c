@@ -0,0 +1,52 @@
+#include <assert.h>
+#include "sf/str.h"
+
+#define MAP_NAME swiss_ii
+#define MAP_K int
+#define MAP_V int
+#include "sf/containers/swiss_map.h"
+
+#define MAP_NAME swiss_ss
+#define MAP_K sf_str
+#define MAP_V sf_str
+#define HASH_FN sf_str_hash
+#define EQUAL_FN sf_str_eq
+#include "sf/containers/swiss_map.h"
+
+int main(void) {
+    swiss_ii map = swiss_ii_new();
+
+    for (int i = 0; i < 10000; ++i)
+        swiss_ii_set(&map, i, i * 2);
+    assert(map.pair_count == 10000);
+    assert((map.capacity & (map.capacity - 1)) == 0);
+    for (int i = 0; i < 10000; ++i) {
+        swiss_ii_ex v = swiss_ii_get(&map, i);
+        assert(v.is_ok && v.ok == i * 2);
+    }
+    assert(!swiss_ii_get(&map, 10000).is_ok);
+
+    // Deleting every other key must leave the rest reachable.
+    for (int i = 0; i < 10000; i += 2)
+        swiss_ii_delete(&map, i);
+    assert(map.pair_count == 5000);
+    for (int i = 0; i < 10000; ++i)
+        assert(swiss_ii_get(&map, i).is_ok == (i % 2 == 1));
+
+    swiss_ii_set(&map, 1, 42);
+    assert(map.pair_count == 5000 && swiss_ii_get(&map, 1).ok == 42);
+
+    swiss_ii_clear(&map);
+    assert(map.pair_count == 0 && !swiss_ii_get(&map, 1).is_ok);
+    swiss_ii_free(&map);
+
+    swiss_ss map2 = swiss_ss_new();
+
+    swiss_ss_set(&map2, sf_lit("test"), sf_lit("80085"));
+    swiss_ss_ex out = swiss_ss_get(&map2, sf_lit("test"));
+    assert(out.is_ok && sf_str_eq(sf_lit("80085"), out.ok));
+    swiss_ss_delete(&map2, sf_lit("test"));
+    assert(!swiss_ss_get(&map2, sf_lit("test")).is_ok);
+
+    swiss_ss_free(&map2);
+}
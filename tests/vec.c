@@ -1,22 +1,129 @@
-#include <assert.h>
-
-#define VEC_NAME sf_vec_int
-#define VEC_T int
-#include "sf/containers/vec.h"
-
-int main(void) {
-    sf_vec_int vec = sf_vec_int_new();
-
-    for (int i = 0; i < 5; ++i)
-        sf_vec_int_push(&vec, i);
-    for (int i = 0; i < 5; ++i) {
-        int v = sf_vec_int_get(&vec, (uint64_t)i);
-        assert(v == i);
-    }
-
-    sf_vec_int_insert(&vec, 3, 4);
-    assert(sf_vec_int_get(&vec, 3) == 4);
-    assert(sf_vec_int_get(&vec, vec.count - 1) == sf_vec_int_pop(&vec));
-
-    sf_vec_int_free(&vec);
-}
\ No newline at end of file
+#include <assert.h>
+#include <stdlib.h>
+
+#define VEC_NAME sf_vec_int
+#define VEC_T int
+#include "sf/containers/vec.h"
+
+#define VEC_NAME small_vec
+#define VEC_T int
+#define VSIZE_T uint16_t
+#define VSIZE_MAX UINT16_MAX
+#define VEC_NO_SHRINK
+#include "sf/containers/vec.h"
+
+#define VEC_NAME tag_vec
+#define VEC_T int
+#define VEC_INLINE 8
+#include "sf/containers/vec.h"
+
+/// Heap allocator that counts allocations, to see when an inline vec spills.
+static int allocations;
+static void *count_alloc(void *ud, const size_t size) {
+    (void)ud;
+    ++allocations;
+    return malloc(size);
+}
+static void *count_realloc(void *ud, void *ptr, const size_t old_size, const size_t size) {
+    (void)ud, (void)old_size;
+    return realloc(ptr, size);
+}
+static void count_free(void *ud, void *ptr, const size_t size) {
+    (void)ud, (void)size;
+    --allocations;
+    free(ptr);
+}
+static const sf_allocator counting = { count_alloc, count_realloc, count_free, NULL };
+
+int main(void) {
+    sf_vec_int vec = sf_vec_int_new();
+
+    for (int i = 0; i < 5; ++i)
+        sf_vec_int_push(&vec, i);
+    for (int i = 0; i < 5; ++i) {
+        int v = sf_vec_int_get(&vec, (uint64_t)i);
+        assert(v == i);
+    }
+
+    sf_vec_int_insert(&vec, 3, 4);
+    assert(sf_vec_int_get(&vec, 3) == 4);
+    assert(sf_vec_int_get(&vec, vec.count - 1) == sf_vec_int_pop(&vec));
+
+    // Ranges go in and out in one piece.
+    const int values[] = { 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+    assert(sf_vec_int_append(&vec, values, 10) && vec.count == 15 && *vec.top == 19);
+    assert(sf_vec_int_insert_range(&vec, 1, values, 3) && vec.count == 18);
+    assert(sf_vec_int_get(&vec, 0) == 0 && sf_vec_int_get(&vec, 1) == 10 && sf_vec_int_get(&vec, 3) == 12);
+    assert(sf_vec_int_get(&vec, 4) == 1 && sf_vec_int_get(&vec, 17) == 19);
+    sf_vec_int_delete_range(&vec, 1, 3);
+    assert(vec.count == 15 && sf_vec_int_get(&vec, 1) == 1 && sf_vec_int_get(&vec, 5) == 10);
+    sf_vec_int_delete_range(&vec, 5, 10);
+    assert(vec.count == 5 && *vec.top == 3 && sf_vec_int_append(&vec, values, 0));
+
+    // Removing elements only shrinks once three quarters are unused, and then only by half.
+    sf_vec_int_free(&vec);
+    for (int i = 0; i < 1025; ++i)
+        sf_vec_int_push(&vec, i);
+    assert(vec.slots == 2048);
+    for (int i = 0; i < 100; ++i) {
+        sf_vec_int_delete(&vec, vec.count - 1);
+        sf_vec_int_push(&vec, i);
+        assert(vec.slots == 2048);
+    }
+    sf_vec_int_delete_range(&vec, 10, vec.count - 10);
+    assert(vec.count == 10 && vec.slots == 32 && sf_vec_int_get(&vec, 9) == 9);
+
+    // Reserved room stays until shrink_to_fit.
+    assert(sf_vec_int_reserve(&vec, 990) && vec.slots == 1000);
+    const int *data = vec.data;
+    for (int i = 0; i < 990; ++i)
+        sf_vec_int_push(&vec, i);
+    while (vec.count > 1)
+        sf_vec_int_pop(&vec);
+    assert(vec.data == data && vec.slots == 1000);
+    sf_vec_int_shrink_to_fit(&vec);
+    assert(vec.slots == 1 && sf_vec_int_get(&vec, 0) == 0);
+    sf_vec_int_pop(&vec);
+    sf_vec_int_shrink_to_fit(&vec);
+    assert(vec.slots == 0 && vec.data == NULL);
+
+    assert(sf_vec_int_resize(&vec, 6, 7) && vec.count == 6 && sf_vec_int_get(&vec, 5) == 7);
+    assert(sf_vec_int_resize(&vec, 2, 0) && vec.count == 2 && *vec.top == 7);
+    sf_vec_int_free(&vec);
+
+    // Without shrinking, memory is only given back on request.
+    small_vec small = small_vec_new();
+    assert(small_vec_resize(&small, 300, 1) && small.slots >= 300);
+    const uint16_t slots = small.slots;
+    small_vec_delete_range(&small, 0, 299);
+    assert(small.slots == slots && small.count == 1);
+    assert(!small_vec_reserve(&small, UINT16_MAX) && small_vec_reserve(&small, 10));
+    small_vec_shrink_to_fit(&small);
+    assert(small.slots == 1);
+    small_vec_free(&small);
+
+    // Inline vecs only allocate past their inline elements, and move back in when they shrink.
+    tag_vec tags = tag_vec_new_in(&counting);
+    for (int i = 0; i < 8; ++i)
+        tag_vec_push(&tags, i);
+    assert(allocations == 0 && tags.data == NULL && tags.slots == 8 && tag_vec_get(&tags, 7) == 7);
+    const tag_vec copy = tags;
+    assert(tag_vec_get(&copy, 3) == 3 && tag_vec_items(&copy) != tag_vec_items(&tags));
+    tag_vec_insert(&tags, 4, 100);
+    assert(allocations == 1 && tags.data != NULL && tags.count == 9 && tags.slots == 16);
+    assert(tag_vec_get(&tags, 4) == 100 && tag_vec_get(&tags, 5) == 4 && tag_vec_get(&tags, 8) == 7);
+    tag_vec_delete(&tags, 0);
+    assert(tag_vec_get(&tags, 0) == 1 && tag_vec_get(&tags, 3) == 100);
+    assert(tag_vec_append(&tags, values, 10) && tags.count == 18 && tag_vec_get(&tags, 17) == 19);
+    tag_vec_delete_range(&tags, 4, 14);
+    assert(allocations == 0 && tags.data == NULL && tags.slots == 8 && tags.count == 4);
+    assert(tag_vec_get(&tags, 0) == 1 && tag_vec_get(&tags, 3) == 100);
+    assert(tag_vec_reserve(&tags, 20) && allocations == 1 && tags.slots == 24);
+    tag_vec_shrink_to_fit(&tags);
+    assert(allocations == 0 && tags.data == NULL && tag_vec_get(&tags, 2) == 3);
+    tag_vec_free(&tags);
+    assert(tags.count == 0 && tags.slots == 8 && tags.alloc == &counting);
+    tag_vec alloced = tag_vec_alloc(20, 5);
+    assert(alloced.count == 20 && alloced.slots == 20 && tag_vec_get(&alloced, 19) == 5);
+    tag_vec_free(&alloced);
+}
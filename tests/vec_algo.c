@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define VEC_NAME sf_vec_int
+#define VEC_T int
+#include "sf/containers/vec.h"
+#define VEC_NAME sf_vec_int
+#define VEC_T int
+#define VEC_RADIX_KEY(x) sf_radix_i32(x)
+#include "sf/containers/vec_algo.h"
+
+#define VEC_NAME sf_vec_f64
+#define VEC_T double
+#include "sf/containers/vec.h"
+#define VEC_NAME sf_vec_f64
+#define VEC_T double
+#define VEC_RADIX_KEY(x) sf_radix_f64(x)
+#include "sf/containers/vec_algo.h"
+
+typedef struct {
+    uint16_t key;
+    uint32_t order;
+} entry;
+static bool entry_less(const entry a, const entry b) {
+    return a.key < b.key;
+}
+#define VEC_NAME entry_vec
+#define VEC_T entry
+#define VEC_INLINE 4
+#include "sf/containers/vec.h"
+#define VEC_NAME entry_vec
+#define VEC_T entry
+#define LESS_FN entry_less
+#define VEC_RADIX_KEY(x) (x).key
+#include "sf/containers/vec_algo.h"
+
+static int compare_ints(const void *a, const void *b) {
+    const int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/// Sorts `vec` every way and compares against qsort.
+static void check_sorts(sf_vec_int *vec) {
+    const size_t n = vec->count;
+    int *expected = malloc(n * sizeof(int) + 1);
+    if (n)
+        memcpy(expected, vec->data, n * sizeof(int));
+    qsort(expected, n, sizeof(int), compare_ints);
+
+    sf_vec_int copy = sf_vec_int_new();
+    assert(sf_vec_int_append(&copy, vec->data, vec->count));
+    sf_vec_int_sort(&copy);
+    assert(n == 0 || memcmp(copy.data, expected, n * sizeof(int)) == 0);
+    sf_vec_int_free(&copy);
+    assert(sf_vec_int_append(&copy, vec->data, vec->count) && sf_vec_int_radix_sort(&copy));
+    assert(n == 0 || memcmp(copy.data, expected, n * sizeof(int)) == 0);
+    sf_vec_int_free(&copy);
+    assert(sf_vec_int_append(&copy, vec->data, vec->count) && sf_vec_int_sort_parallel(&copy, 3));
+    assert(n == 0 || memcmp(copy.data, expected, n * sizeof(int)) == 0);
+    sf_vec_int_free(&copy);
+    free(expected);
+}
+
+int main(void) {
+    static const size_t sizes[] = { 0, 1, 2, 17, 100, 1000, 200000 };
+    sf_vec_int vec = sf_vec_int_new();
+    uint64_t seed = 1;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s) {
+        const size_t n = sizes[s];
+        // Random, few distinct values, sorted, reversed, and a pipe organ that hurts naive pivots.
+        for (int shape = 0; shape < 5; ++shape) {
+            sf_vec_int_free(&vec);
+            for (size_t i = 0; i < n; ++i) {
+                seed = seed * 6364136223846793005u + 1442695040888963407u;
+                const int random = (int)(seed >> 32);
+                const int values[] = {
+                    random, random % 4, (int)i, -(int)i, (int)(i < n / 2 ? i : n - i),
+                };
+                sf_vec_int_push(&vec, values[shape]);
+            }
+            check_sorts(&vec);
+        }
+    }
+
+    // Bounds over runs of duplicates.
+    sf_vec_int_free(&vec);
+    assert(sf_vec_int_lower_bound(&vec, 5) == 0 && sf_vec_int_upper_bound(&vec, 5) == 0);
+    for (int i = 0; i < 30; ++i)
+        sf_vec_int_push(&vec, i / 3 * 2);
+    for (int value = -1; value <= 20; ++value) {
+        size_t lower = 0, upper = 0;
+        while (lower < vec.count && sf_vec_int_get(&vec, lower) < value)
+            ++lower;
+        while (upper < vec.count && sf_vec_int_get(&vec, upper) <= value)
+            ++upper;
+        assert(sf_vec_int_lower_bound(&vec, value) == lower && sf_vec_int_upper_bound(&vec, value) == upper);
+    }
+    sf_vec_int_free(&vec);
+
+    // Floats order negatives, zeros and infinities like `<`.
+    sf_vec_f64 doubles = sf_vec_f64_new();
+    const double values[] = { 2.5, -0.0, -1e300, 1e-300, -HUGE_VAL, 0.0, HUGE_VAL, -2.5, 3 };
+    assert(sf_vec_f64_append(&doubles, values, 9) && sf_vec_f64_radix_sort(&doubles));
+    for (size_t i = 1; i < doubles.count; ++i)
+        assert(!(sf_vec_f64_get(&doubles, i) < sf_vec_f64_get(&doubles, i - 1)));
+    assert(sf_vec_f64_get(&doubles, 0) == -HUGE_VAL && sf_vec_f64_get(&doubles, 8) == HUGE_VAL);
+    sf_vec_f64_free(&doubles);
+
+    // Radix sorting structs on a key keeps equal keys in order, inline or not.
+    entry_vec entries = entry_vec_new();
+    for (uint32_t i = 0; i < 1000; ++i) {
+        entry_vec_push(&entries, (entry){ (uint16_t)(i * 7919 % 50), i });
+        if (i == 3)
+            assert(entry_vec_radix_sort(&entries) && entries.data == NULL);
+    }
+    entry_vec_delete_range(&entries, 0, 4);
+    assert(entry_vec_radix_sort(&entries));
+    for (size_t i = 1; i < entries.count; ++i) {
+        const entry a = entry_vec_get(&entries, i - 1), b = entry_vec_get(&entries, i);
+        assert(a.key < b.key || (a.key == b.key && a.order < b.order));
+    }
+    // Keys 0 and 7 were among the four deleted.
+    assert(entry_vec_lower_bound(&entries, (entry){ 10, 0 }) == 10 * 20 - 2);
+    entry_vec_free(&entries);
+}